@@ -0,0 +1,11 @@
+#ifndef BENCHTIMER_HPP
+#define BENCHTIMER_HPP
+
+// Seconds on a clock that never goes back, to time steps in the benchmarks (misc06_benchmarks),
+// the tools (misc07_tools) and the shader registry. Only differences mean something.
+// Include <chrono> first.
+inline double now(){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
@@ -1,3 +1,5 @@
+#include <stdio.h>
+
 // Include GLFW
 #include <GLFW/glfw3.h>
 extern GLFWwindow* window; // The "extern" keyword here is to access the variable "window" declared in tutorialXXX.cpp. This is a hack to keep the tutorials simple. Please avoid this.
@@ -8,18 +10,16 @@ extern GLFWwindow* window; // The "extern" keyword here is to access the variabl
 using namespace glm;
 
 #include "controls.hpp"
+#include "input.hpp"
+#include "inputrecord.hpp"
 
-#define g 9.8f;
+#include "rocketsim.hpp"
 
-float height = 0.0f;
-float gauge = 0.0f;
-float ySpeed = 0.0f;
-float rotation = 0.0f;
-bool chute = false; // ϻ
-bool launch = false; // ߻
-bool landing = false; // 
-bool Rdirection = false; //  
-bool press = false;
+// The rocket as of the last simulated tick, and the tick before : rendering interpolates between them
+RocketState rocket;
+RocketState previousRocket;
+FixedStepClock simulationClock;
+bool simulationStarted = false;
 
 glm::mat4 ViewMatrix;
 glm::mat4 ProjectionMatrix;
@@ -32,31 +32,57 @@ glm::mat4 getProjectionMatrix() {
 }
 
 float getRotation() {
-	return rotation;
+	return rocket.rotation;
 }
 
 float getHeight() {
-	return height;
+	// Between two ticks : blend the last two simulated states
+	float alpha = getFixedStepAlpha(simulationClock);
+	return previousRocket.height + (rocket.height - previousRocket.height) * alpha;
 }
 
 float getySpeed() {
-	return ySpeed;
+	return rocket.ySpeed;
+}
+
+float getGauge() {
+	return rocket.gauge;
 }
 
 bool getChute() {
-	return chute;
+	return rocket.chute;
 }
 
 bool getLaunch() {
-	return launch;
+	return rocket.launch;
 }
 
 bool getLanding() {
-	return landing;
+	return rocket.landing;
 }
 
 bool getDirection() {
-	return Rdirection;
+	return rocket.direction;
+}
+
+unsigned long long getSimulationTick() {
+	return simulationClock.tick;
+}
+
+void updateRocketSimulation(float deltaTime, bool spaceHeld) {
+	if (!simulationStarted) {
+		resetRocket(rocket);
+		previousRocket = rocket;
+		initFixedStepClock(simulationClock);
+		simulationStarted = true;
+	}
+
+	// Run as many fixed ticks as the elapsed time covers : the flight is the same at any frame rate
+	int substeps = advanceFixedStepClock(simulationClock, deltaTime);
+	for (int i = 0; i < substeps; i++) {
+		previousRocket = rocket;
+		stepRocket(rocket, spaceHeld);
+	}
 }
 
 // Initial position : on +Z
@@ -67,11 +93,83 @@ float horizontalAngle = 3.14f;
 float verticalAngle = 0.3f;
 // Initial Field of View
 float initialFoV = 45.0f;
+// The wheel zooms, within these
+float minFoV = 10.0f;
+float maxFoV = 90.0f;
+
+// Display range of the projection
+float nearPlane = 0.1f;
+float farPlane = 100.0f;
+
+glm::vec3 getCameraPosition() {
+	return position;
+}
 
 float speed = 3.0f; // 3 units / second
 float mouseSpeed = 0.005f;
 
+// What the input events said so far
+bool inputStarted = false;
+bool moveForward, moveBackward, strafeRight, strafeLeft, spaceHeld;
+bool cursorKnown = false;
+double cursorX, cursorY;
+float FoV = initialFoV;
+int framebufferWidth = 1024, framebufferHeight = 768;
+
+// This frame's events : from the queue, or from a replayed recording
+InputFrame inputFrame;
+bool replayDesynchronized = false;
+
+// The matrices are only computed again when what they depend on changes
+glm::vec3 cameraDirection, cameraRight, cameraUp;
+bool orientationChanged = true;
+bool viewChanged = true;
+bool projectionChanged = true;
+
+void setClipPlanes(float nearDistance, float farDistance) {
+	nearPlane = nearDistance;
+	farPlane = farDistance;
+	projectionChanged = true;
+}
 
+static void applyInputEvent(const InputEvent & event) {
+	switch (event.type) {
+	case INPUT_KEY: {
+		if (event.action == GLFW_REPEAT)
+			break;
+		bool pressed = event.action == GLFW_PRESS;
+		if (event.key == GLFW_KEY_UP) moveForward = pressed;
+		else if (event.key == GLFW_KEY_DOWN) moveBackward = pressed;
+		else if (event.key == GLFW_KEY_RIGHT) strafeRight = pressed;
+		else if (event.key == GLFW_KEY_LEFT) strafeLeft = pressed;
+		else if (event.key == GLFW_KEY_SPACE) spaceHeld = pressed;
+		break;
+	}
+	case INPUT_CURSOR:
+		// The hidden cursor is never recentered : its movement since the last event turns the camera
+		if (cursorKnown) {
+			horizontalAngle += mouseSpeed * float(cursorX - event.x);
+			verticalAngle += mouseSpeed * float(cursorY - event.y);
+			orientationChanged = true;
+		}
+		cursorX = event.x;
+		cursorY = event.y;
+		cursorKnown = true;
+		break;
+	case INPUT_SCROLL:
+		FoV = glm::clamp(FoV - 5.0f * float(event.y), minFoV, maxFoV);
+		projectionChanged = true;
+		break;
+	case INPUT_FRAMEBUFFER_SIZE:
+		// 0 x 0 while minimized : keep the last ratio
+		if (event.x > 0 && event.y > 0) {
+			framebufferWidth = int(event.x);
+			framebufferHeight = int(event.y);
+			projectionChanged = true;
+		}
+		break;
+	}
+}
 
 void computeMatricesFromInputs() {
 
@@ -82,107 +180,93 @@ void computeMatricesFromInputs() {
 	double currentTime = glfwGetTime();
 	float deltaTime = float(currentTime - lastTime);
 
-	// Get mouse position
-	double xpos, ypos;
-	glfwGetCursorPos(window, &xpos, &ypos);
-
-	// Reset mouse position for next frame
-	glfwSetCursorPos(window, 1024 / 2, 768 / 2);
-
-	// Compute new orientation
-	horizontalAngle += mouseSpeed * float(1024 / 2 - xpos);
-	verticalAngle += mouseSpeed * float(768 / 2 - ypos);
-
-	// Direction : Spherical coordinates to Cartesian coordinates conversion
-	glm::vec3 direction(
-		cos(verticalAngle) * sin(horizontalAngle),
-		sin(verticalAngle),
-		cos(verticalAngle) * cos(horizontalAngle)
-	);
-
-	// Right vector
-	glm::vec3 right = glm::vec3(
-		sin(horizontalAngle - 3.14f / 2.0f),
-		0,
-		cos(horizontalAngle - 3.14f / 2.0f)
-	);
+	if (isReplayingInput()) {
+		// The recorded frame, with its own duration : the window's input is ignored
+		if (!readInputFrame(inputFrame)) {
+			inputFrame.deltaTime = 0.0f;
+			inputFrame.eventCount = 0;
+		} else if (inputFrame.tick != getSimulationTick() && !replayDesynchronized) {
+			printf("Input replay : frame recorded at tick %llu, played at tick %llu\n", inputFrame.tick, getSimulationTick());
+			replayDesynchronized = true;
+		}
+		deltaTime = inputFrame.deltaTime;
+	} else {
+		if (!inputStarted) {
+			initInput(window);
+			inputStarted = true;
+		}
 
-	// Up vector
-	glm::vec3 up = glm::cross(right, direction);
+		// What happened since the last frame
+		inputFrame.tick = getSimulationTick();
+		inputFrame.deltaTime = deltaTime;
+		inputFrame.eventCount = 0;
+		while (inputFrame.eventCount < INPUT_QUEUE_CAPACITY && popInputEvent(inputFrame.events[inputFrame.eventCount]))
+			inputFrame.eventCount++;
+		writeInputFrame(inputFrame);
+	}
+	for (unsigned int i = 0; i < inputFrame.eventCount; i++)
+		applyInputEvent(inputFrame.events[i]);
+
+	if (orientationChanged) {
+		// Direction : Spherical coordinates to Cartesian coordinates conversion
+		cameraDirection = glm::vec3(
+			cos(verticalAngle) * sin(horizontalAngle),
+			sin(verticalAngle),
+			cos(verticalAngle) * cos(horizontalAngle)
+		);
+
+		// Right vector
+		cameraRight = glm::vec3(
+			sin(horizontalAngle - 3.14f / 2.0f),
+			0,
+			cos(horizontalAngle - 3.14f / 2.0f)
+		);
+
+		// Up vector
+		cameraUp = glm::cross(cameraRight, cameraDirection);
+
+		orientationChanged = false;
+		viewChanged = true;
+	}
 
 	// Move forward
-	if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-		position += direction * deltaTime * speed;
+	if (moveForward) {
+		position += cameraDirection * deltaTime * speed;
 	}
 	// Move backward
-	if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-		position -= direction * deltaTime * speed;
+	if (moveBackward) {
+		position -= cameraDirection * deltaTime * speed;
 	}
 	// Strafe right
-	if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) {
-		position += right * deltaTime * speed;
+	if (strafeRight) {
+		position += cameraRight * deltaTime * speed;
 	}
 	// Strafe left
-	if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {
-		position -= right * deltaTime * speed;
-	}
-	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-		if (launch == false && landing == false) {
-			if (gauge < 3) {
-				gauge += 0.01f;
-			}
-			press = true;
-		}
-	}
-	if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE && press == true) {
-		if (!launch) {
-			launch = true;
-			ySpeed = gauge;
-		}
-		if (landing) {
-			height = -0.5f;
-			gauge = 0.0f;
-			ySpeed = 0.0f; 
-			launch = false; 
-			landing = false;
-			Rdirection = false;
-			press = false;
-		}
+	if (strafeLeft) {
+		position -= cameraRight * deltaTime * speed;
 	}
+	if (moveForward || moveBackward || strafeRight || strafeLeft)
+		viewChanged = true;
 
-	if (launch == true && landing == false) {
-		if (chute == false) {
-			ySpeed -= 0.01f;
-		}
-		else {
+	// The flight advances in fixed ticks
+	updateRocketSimulation(deltaTime, spaceHeld);
 
-		}
-		if (ySpeed < 0) {
-			Rdirection = true;
-			rotation = 10.0f;
-		}
-		if (ySpeed < -2.0) {
-			chute = true;
-			ySpeed /= 5;
-		}
-		height += ySpeed / g;
-		
-		if (height < -0.5f) {
-			landing = true;
-		}
+	if (projectionChanged) {
+		// Projection matrix : the ratio of the framebuffer, display range : 0.1 unit <-> 100 units unless setClipPlanes says otherwise
+		ProjectionMatrix = glm::perspective(glm::radians(FoV), float(framebufferWidth) / float(framebufferHeight), nearPlane, farPlane);
+		projectionChanged = false;
 	}
 
-	float FoV = initialFoV;// - 5 * glfwGetMouseWheel(); // Now GLFW 3 requires setting up a callback for this. It's a bit too complicated for this beginner's tutorial, so it's disabled instead.
-
-	// Projection matrix : 45?Field of View, 4:3 ratio, display range : 0.1 unit <-> 100 units
-	ProjectionMatrix = glm::perspective(glm::radians(FoV), 4.0f / 3.0f, 0.1f, 100.0f);
-	// Camera matrix
-	ViewMatrix = glm::lookAt(
-		position,           // Camera is here
-		position + direction, // and looks here : at the same position, plus "direction"
-		up                  // Head is up (set to 0,-1,0 to look upside-down)
-	);
+	if (viewChanged) {
+		// Camera matrix
+		ViewMatrix = glm::lookAt(
+			position,           // Camera is here
+			position + cameraDirection, // and looks here : at the same position, plus "direction"
+			cameraUp            // Head is up (set to 0,-1,0 to look upside-down)
+		);
+		viewChanged = false;
+	}
 
 	// For the next frame, the "last time" will be "now"
 	lastTime = currentTime;
-}
\ No newline at end of file
+}
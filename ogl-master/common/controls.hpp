@@ -1,15 +1,26 @@
 #ifndef CONTROLS_HPP
 #define CONTROLS_HPP
 
+// Once per frame : applies the input events queued since the last call (see input.hpp, started
+// on the first call), and computes the matrices again if they changed. The projection follows
+// the size of the framebuffer; the wheel zooms.
 void computeMatricesFromInputs();
 glm::mat4 getViewMatrix();
 glm::mat4 getProjectionMatrix();
+glm::vec3 getCameraPosition();
+// Near and far distances of the projection. 0.1 and 100 by default.
+void setClipPlanes(float nearDistance, float farDistance);
 float getRotation();
 float getHeight();
 float getySpeed();
+float getGauge();
 bool getChute();
 bool getLaunch();
 bool getLanding();
 bool getDirection();
 
+// Advances the rocket flight by deltaTime seconds, in fixed ticks (see rocketsim.hpp)
+void updateRocketSimulation(float deltaTime, bool spaceHeld);
+unsigned long long getSimulationTick();
+
 #endif
\ No newline at end of file
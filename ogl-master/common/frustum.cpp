@@ -0,0 +1,122 @@
+#include <vector>
+#include <math.h>
+
+#include <glm/glm.hpp>
+
+#include "frustum.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE
+#include <emmintrin.h>
+#endif
+
+void extractFrustum(Frustum & frustum, const glm::mat4 & m){
+	// Gribb & Hartmann : each plane is the 4th row of the matrix plus or minus another row.
+	// glm is column-major : row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+	for ( int i=0; i<3; i++ ){
+		glm::vec4 row (m[0][i], m[1][i], m[2][i], m[3][i]);
+		glm::vec4 last(m[0][3], m[1][3], m[2][3], m[3][3]);
+		frustum.planes[2*i  ] = last + row;
+		frustum.planes[2*i+1] = last - row;
+	}
+	for ( int p=0; p<6; p++ )
+		frustum.planes[p] /= glm::length(glm::vec3(frustum.planes[p]));
+}
+
+bool isBoxVisible(const Frustum & frustum, glm::vec3 boxMin, glm::vec3 boxMax){
+	glm::vec3 center = (boxMin + boxMax) * 0.5f;
+	glm::vec3 extent = (boxMax - boxMin) * 0.5f;
+	for ( int p=0; p<6; p++ ){
+		glm::vec3 normal(frustum.planes[p]);
+		// Distance of the box corner that is the most inside this plane
+		float distance = glm::dot(normal, center) + frustum.planes[p].w + glm::dot(glm::abs(normal), extent);
+		if ( distance < 0.0f )
+			return false;
+	}
+	return true;
+}
+
+bool isSphereVisible(const Frustum & frustum, glm::vec3 center, float radius){
+	for ( int p=0; p<6; p++ )
+		if ( glm::dot(glm::vec3(frustum.planes[p]), center) + frustum.planes[p].w < -radius )
+			return false;
+	return true;
+}
+
+void clearBoundingBoxes(BoundingBoxes & boxes){
+	boxes.centerX.clear(); boxes.centerY.clear(); boxes.centerZ.clear();
+	boxes.extentX.clear(); boxes.extentY.clear(); boxes.extentZ.clear();
+}
+
+void addBoundingBox(BoundingBoxes & boxes, glm::vec3 boxMin, glm::vec3 boxMax){
+	glm::vec3 center = (boxMin + boxMax) * 0.5f;
+	glm::vec3 extent = (boxMax - boxMin) * 0.5f;
+	boxes.centerX.push_back(center.x); boxes.centerY.push_back(center.y); boxes.centerZ.push_back(center.z);
+	boxes.extentX.push_back(extent.x); boxes.extentY.push_back(extent.y); boxes.extentZ.push_back(extent.z);
+}
+
+void addBoundingSphere(BoundingBoxes & boxes, glm::vec3 center, float radius){
+	addBoundingBox(boxes, center - glm::vec3(radius), center + glm::vec3(radius));
+}
+
+static bool isBoxVisible(const Frustum & frustum, const BoundingBoxes & boxes, unsigned int i){
+	glm::vec3 center(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+	glm::vec3 extent(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+	return isBoxVisible(frustum, center - extent, center + extent);
+}
+
+unsigned int cullBoundingBoxesScalar(const Frustum & frustum, const BoundingBoxes & boxes, unsigned char * visible){
+	unsigned int count = (unsigned int)boxes.centerX.size();
+	unsigned int visibleCount = 0;
+	for ( unsigned int i=0; i<count; i++ ){
+		visible[i] = isBoxVisible(frustum, boxes, i) ? 1 : 0;
+		visibleCount += visible[i];
+	}
+	return visibleCount;
+}
+
+unsigned int cullBoundingBoxes(const Frustum & frustum, const BoundingBoxes & boxes, unsigned char * visible){
+	unsigned int count = (unsigned int)boxes.centerX.size();
+	unsigned int visibleCount = 0;
+	unsigned int i = 0;
+
+#ifdef FRUSTUM_SSE
+	// Each plane component, and its absolute value, in all 4 lanes
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for ( int p=0; p<6; p++ ){
+		planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+		planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+		planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+		planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+		absX[p]   = _mm_set1_ps(fabsf(frustum.planes[p].x));
+		absY[p]   = _mm_set1_ps(fabsf(frustum.planes[p].y));
+		absZ[p]   = _mm_set1_ps(fabsf(frustum.planes[p].z));
+	}
+	const __m128 zero = _mm_setzero_ps();
+
+	// 4 boxes per iteration, same test as isBoxVisible
+	for ( ; i + 4 <= count; i += 4 ){
+		__m128 cx = _mm_loadu_ps(&boxes.centerX[i]), cy = _mm_loadu_ps(&boxes.centerY[i]), cz = _mm_loadu_ps(&boxes.centerZ[i]);
+		__m128 ex = _mm_loadu_ps(&boxes.extentX[i]), ey = _mm_loadu_ps(&boxes.extentY[i]), ez = _mm_loadu_ps(&boxes.extentZ[i]);
+		__m128 outside = zero;
+		for ( int p=0; p<6; p++ ){
+			// Added in the same order as the scalar version, for the same results
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)), _mm_mul_ps(planeZ[p], cz)), planeW[p]);
+			__m128 reach    = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+		}
+		int mask = _mm_movemask_ps(outside); // Bit k set : box i+k is outside
+		for ( int k=0; k<4; k++ ){
+			visible[i+k] = (mask >> k) & 1 ? 0 : 1;
+			visibleCount += visible[i+k];
+		}
+	}
+#endif
+
+	// What's left, one by one
+	for ( ; i<count; i++ ){
+		visible[i] = isBoxVisible(frustum, boxes, i) ? 1 : 0;
+		visibleCount += visible[i];
+	}
+	return visibleCount;
+}
@@ -0,0 +1,42 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+// The 6 planes of the view frustum : left, right, bottom, top, near, far.
+// A point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0. The normals are unit length.
+struct Frustum {
+	glm::vec4 planes[6];
+};
+
+// From ProjectionMatrix * ViewMatrix : world space planes
+void extractFrustum(Frustum & frustum, const glm::mat4 & viewProjection);
+
+// false only when the volume is entirely outside. Near the corners of the frustum,
+// a box or a sphere may be reported visible although it is not : it's just drawn for nothing.
+bool isBoxVisible(const Frustum & frustum, glm::vec3 boxMin, glm::vec3 boxMax);
+bool isSphereVisible(const Frustum & frustum, glm::vec3 center, float radius);
+
+// Many boxes, as center + half size, stored as a structure of arrays so that
+// cullBoundingBoxes tests 4 of them against each plane at once (SSE)
+struct BoundingBoxes {
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+};
+
+void clearBoundingBoxes(BoundingBoxes & boxes);
+void addBoundingBox(BoundingBoxes & boxes, glm::vec3 boxMin, glm::vec3 boxMax);
+// A box around a sphere
+void addBoundingSphere(BoundingBoxes & boxes, glm::vec3 center, float radius);
+
+// visible[i] = 1 if box i may be visible, 0 otherwise. Returns the number of visible boxes.
+unsigned int cullBoundingBoxes(const Frustum & frustum, const BoundingBoxes & boxes, unsigned char * visible);
+
+// Plain C++ version, one box at a time. For reference and benchmarks.
+unsigned int cullBoundingBoxesScalar(const Frustum & frustum, const BoundingBoxes & boxes, unsigned char * visible);
+
+// What was drawn this frame, and what was not
+struct CullStats {
+	unsigned int visible;
+	unsigned int culled;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include <atomic>
+
+// Include GLFW
+#include <GLFW/glfw3.h>
+
+#include "input.hpp"
+
+// The ring : the producer only writes tail, the consumer only writes head. One slot stays empty,
+// so head == tail means empty.
+InputEvent inputEvents[INPUT_QUEUE_CAPACITY];
+std::atomic<unsigned int> inputHead(0);
+std::atomic<unsigned int> inputTail(0);
+std::atomic<unsigned int> droppedInputEvents(0);
+
+// What was installed before initInput, called after the events are queued
+GLFWkeyfun previousKeyCallback;
+GLFWcursorposfun previousCursorCallback;
+GLFWscrollfun previousScrollCallback;
+GLFWframebuffersizefun previousFramebufferSizeCallback;
+
+bool pushInputEvent(const InputEvent & event) {
+	unsigned int tail = inputTail.load(std::memory_order_relaxed);
+	unsigned int next = (tail + 1) % INPUT_QUEUE_CAPACITY;
+	if (next == inputHead.load(std::memory_order_acquire)) {
+		droppedInputEvents.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	inputEvents[tail] = event;
+	// The event is written before the consumer can see the new tail
+	inputTail.store(next, std::memory_order_release);
+	return true;
+}
+
+bool popInputEvent(InputEvent & event) {
+	unsigned int head = inputHead.load(std::memory_order_relaxed);
+	if (head == inputTail.load(std::memory_order_acquire))
+		return false;
+	event = inputEvents[head];
+	// The slot is read before the producer can reuse it
+	inputHead.store((head + 1) % INPUT_QUEUE_CAPACITY, std::memory_order_release);
+	return true;
+}
+
+unsigned int getDroppedInputEvents() {
+	return droppedInputEvents.load(std::memory_order_relaxed);
+}
+
+static void queueEvent(int type, double x, double y, int key, int action, int mods) {
+	InputEvent event;
+	event.time = glfwGetTime();
+	event.x = x;
+	event.y = y;
+	event.type = type;
+	event.key = key;
+	event.action = action;
+	event.mods = mods;
+	pushInputEvent(event);
+}
+
+static void keyCallback(GLFWwindow * window, int key, int scancode, int action, int mods) {
+	queueEvent(INPUT_KEY, 0.0, 0.0, key, action, mods);
+	if (previousKeyCallback)
+		previousKeyCallback(window, key, scancode, action, mods);
+}
+
+static void cursorCallback(GLFWwindow * window, double x, double y) {
+	queueEvent(INPUT_CURSOR, x, y, 0, 0, 0);
+	if (previousCursorCallback)
+		previousCursorCallback(window, x, y);
+}
+
+static void scrollCallback(GLFWwindow * window, double x, double y) {
+	queueEvent(INPUT_SCROLL, x, y, 0, 0, 0);
+	if (previousScrollCallback)
+		previousScrollCallback(window, x, y);
+}
+
+static void framebufferSizeCallback(GLFWwindow * window, int width, int height) {
+	queueEvent(INPUT_FRAMEBUFFER_SIZE, width, height, 0, 0, 0);
+	if (previousFramebufferSizeCallback)
+		previousFramebufferSizeCallback(window, width, height);
+}
+
+void initInput(GLFWwindow * window) {
+	droppedInputEvents.store(0, std::memory_order_relaxed);
+
+	// The cursor is never brought back to the center : hidden, it moves as far as the mouse goes
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	previousKeyCallback = glfwSetKeyCallback(window, keyCallback);
+	previousCursorCallback = glfwSetCursorPosCallback(window, cursorCallback);
+	previousScrollCallback = glfwSetScrollCallback(window, scrollCallback);
+	previousFramebufferSizeCallback = glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+
+	// The callbacks only say what changes
+	int width, height;
+	glfwGetFramebufferSize(window, &width, &height);
+	queueEvent(INPUT_FRAMEBUFFER_SIZE, width, height, 0, 0, 0);
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	queueEvent(INPUT_CURSOR, x, y, 0, 0, 0);
+
+	// A key already held will only send its release : a press for each, as if it was pressed now
+	bool sticky = glfwGetInputMode(window, GLFW_STICKY_KEYS) == GL_TRUE;
+	for (int key = GLFW_KEY_SPACE; key <= GLFW_KEY_LAST; key++) {
+		if (glfwGetKey(window, key) != GLFW_PRESS)
+			continue;
+		queueEvent(INPUT_KEY, 0.0, 0.0, key, GLFW_PRESS, 0);
+		// Sticky keys say PRESS once for a key pressed and released already : that was a tap
+		if (sticky && glfwGetKey(window, key) != GLFW_PRESS)
+			queueEvent(INPUT_KEY, 0.0, 0.0, key, GLFW_RELEASE, 0);
+	}
+}
+
+void cleanupInput(GLFWwindow * window) {
+	glfwSetKeyCallback(window, previousKeyCallback);
+	glfwSetCursorPosCallback(window, previousCursorCallback);
+	glfwSetScrollCallback(window, previousScrollCallback);
+	glfwSetFramebufferSizeCallback(window, previousFramebufferSizeCallback);
+	previousKeyCallback = NULL;
+	previousCursorCallback = NULL;
+	previousScrollCallback = NULL;
+	previousFramebufferSizeCallback = NULL;
+}
@@ -0,0 +1,46 @@
+#ifndef INPUT_HPP
+#define INPUT_HPP
+
+// Input as events rather than polled state : the GLFW key, cursor, scroll and framebuffer size
+// callbacks push what happened into a queue, and the game pops them once per frame
+// (computeMatricesFromInputs in controls.hpp). Nothing is asked to GLFW when nothing happened.
+//
+// The queue is a lock-free ring with one producer and one consumer : the callbacks (during
+// glfwPollEvents), or whatever replays recorded events, on one side, the game on the other.
+// They may be on different threads.
+
+enum InputEventType {
+	INPUT_KEY,                // key : GLFW_KEY_*, action : GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+	INPUT_CURSOR,             // x, y : the cursor, in screen coordinates
+	INPUT_SCROLL,             // x, y : the offsets of the wheel
+	INPUT_FRAMEBUFFER_SIZE    // x, y : in pixels
+};
+
+struct InputEvent {
+	double time;              // glfwGetTime()
+	double x, y;
+	int type;                 // InputEventType
+	int key;
+	int action;
+	int mods;
+};
+
+// Events that don't fit wait for the next frame... or are dropped when the queue is full
+#define INPUT_QUEUE_CAPACITY 1024
+
+// Installs the callbacks, chaining to the ones already set, and hides the cursor so that it moves
+// without limits. Queues the current framebuffer size, cursor position and held keys, so the
+// first frame knows them.
+void initInput(GLFWwindow * window);
+// Puts back the previous callbacks
+void cleanupInput(GLFWwindow * window);
+
+// Producer side. false (and the event is dropped) when the queue is full.
+bool pushInputEvent(const InputEvent & event);
+// Consumer side. false when the queue is empty.
+bool popInputEvent(InputEvent & event);
+
+// Since initInput
+unsigned int getDroppedInputEvents();
+
+#endif
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <string.h>
+
+// Include GLFW
+#include <GLFW/glfw3.h>
+
+#include "input.hpp"
+#include "rocketsim.hpp"
+#include "inputrecord.hpp"
+
+FILE * inputRecordFile = NULL;
+bool inputRecording = false;
+bool inputReplayOver = false;
+double inputRecordStart;    // glfwGetTime() when the recording started
+
+// Little endian whatever the machine, so that a recording replays anywhere
+static bool writeBytes(unsigned long long value, int count) {
+	unsigned char bytes[8];
+	for (int i = 0; i < count; i++)
+		bytes[i] = (unsigned char)(value >> (8 * i));
+	return fwrite(bytes, 1, count, inputRecordFile) == (size_t)count;
+}
+
+static bool readBytes(unsigned long long & value, int count) {
+	unsigned char bytes[8];
+	if (fread(bytes, 1, count, inputRecordFile) != (size_t)count)
+		return false;
+	value = 0;
+	for (int i = 0; i < count; i++)
+		value |= (unsigned long long)bytes[i] << (8 * i);
+	return true;
+}
+
+static bool writeFloat(float value) {
+	unsigned int bits;
+	memcpy(&bits, &value, 4);
+	return writeBytes(bits, 4);
+}
+
+static bool writeDouble(double value) {
+	unsigned long long bits;
+	memcpy(&bits, &value, 8);
+	return writeBytes(bits, 8);
+}
+
+static bool readFloat(float & value) {
+	unsigned long long bits;
+	if (!readBytes(bits, 4))
+		return false;
+	unsigned int low = (unsigned int)bits;
+	memcpy(&value, &low, 4);
+	return true;
+}
+
+static bool readDouble(double & value) {
+	unsigned long long bits;
+	if (!readBytes(bits, 8))
+		return false;
+	memcpy(&value, &bits, 8);
+	return true;
+}
+
+bool startInputRecording(const char * path) {
+	stopInputRecord();
+	inputRecordFile = fopen(path, "wb");
+	if (!inputRecordFile) {
+		printf("%s could not be created\n", path);
+		return false;
+	}
+	if (fwrite("OGLI", 1, 4, inputRecordFile) != 4 || !writeBytes(INPUT_RECORD_VERSION, 4)
+		|| !writeBytes(ROCKET_TICKS_PER_SECOND, 4) || fflush(inputRecordFile) != 0) {
+		printf("%s could not be written\n", path);
+		fclose(inputRecordFile);
+		inputRecordFile = NULL;
+		return false;
+	}
+	inputRecording = true;
+	inputRecordStart = glfwGetTime();
+	return true;
+}
+
+bool startInputReplay(const char * path) {
+	stopInputRecord();
+	inputRecordFile = fopen(path, "rb");
+	if (!inputRecordFile) {
+		printf("%s could not be opened. Are you in the right directory ?\n", path);
+		return false;
+	}
+	char magic[4];
+	unsigned long long version, ticksPerSecond;
+	if (fread(magic, 1, 4, inputRecordFile) != 4 || memcmp(magic, "OGLI", 4) != 0
+		|| !readBytes(version, 4) || version != INPUT_RECORD_VERSION || !readBytes(ticksPerSecond, 4)) {
+		printf("%s is not an input recording of version %d\n", path, INPUT_RECORD_VERSION);
+		stopInputRecord();
+		return false;
+	}
+	// Recorded with another simulation : the same input would not fly the same
+	if (ticksPerSecond != ROCKET_TICKS_PER_SECOND) {
+		printf("%s was recorded at %llu ticks per second, not %d\n", path, ticksPerSecond, ROCKET_TICKS_PER_SECOND);
+		stopInputRecord();
+		return false;
+	}
+	inputRecording = false;
+	inputReplayOver = false;
+	return true;
+}
+
+void stopInputRecord() {
+	if (inputRecordFile && fclose(inputRecordFile) != 0 && inputRecording)
+		printf("The input recording could not be written : its end is lost\n");
+	inputRecordFile = NULL;
+	inputRecording = false;
+}
+
+bool isRecordingInput() {
+	return inputRecordFile != NULL && inputRecording;
+}
+
+bool isReplayingInput() {
+	return inputRecordFile != NULL && !inputRecording;
+}
+
+bool isInputReplayOver() {
+	return inputReplayOver;
+}
+
+bool writeInputFrame(const InputFrame & frame) {
+	if (!isRecordingInput())
+		return false;
+	bool ok = writeBytes(frame.tick, 4) && writeFloat(frame.deltaTime) && writeBytes(frame.eventCount, 2);
+	for (unsigned int i = 0; i < frame.eventCount && ok; i++) {
+		const InputEvent & event = frame.events[i];
+		ok = writeBytes(event.type, 1) && writeFloat(float(event.time - inputRecordStart));
+		if (event.type == INPUT_KEY)
+			ok = ok && writeBytes((unsigned short)event.key, 2) && writeBytes(event.action, 1) && writeBytes(event.mods, 1);
+		else
+			ok = ok && writeDouble(event.x) && writeDouble(event.y);
+	}
+	// To the OS every frame : if the program crashes, the session is there up to the last frame
+	if (ok && fflush(inputRecordFile) == 0)
+		return true;
+
+	// The disk is full, or gone : what was recorded until now is kept, but nothing more
+	printf("The input recording could not be written : stopped at tick %llu\n", frame.tick);
+	inputRecording = false;
+	fclose(inputRecordFile);
+	inputRecordFile = NULL;
+	return false;
+}
+
+bool readInputFrame(InputFrame & frame) {
+	if (!isReplayingInput() || inputReplayOver)
+		return false;
+	unsigned long long tick, eventCount;
+	if (!readBytes(tick, 4) || !readFloat(frame.deltaTime) || !readBytes(eventCount, 2) || eventCount > INPUT_QUEUE_CAPACITY) {
+		inputReplayOver = true;
+		return false;
+	}
+	frame.tick = tick;
+	frame.eventCount = 0;
+	for (unsigned int i = 0; i < eventCount; i++) {
+		InputEvent & event = frame.events[i];
+		unsigned long long type;
+		float time;
+		if (!readBytes(type, 1) || !readFloat(time)) {
+			inputReplayOver = true;
+			return false;
+		}
+		event.type = (int)type;
+		event.time = time;
+		event.key = event.action = event.mods = 0;
+		event.x = event.y = 0.0;
+		bool ok;
+		if (event.type == INPUT_KEY) {
+			unsigned long long key, action, mods;
+			ok = readBytes(key, 2) && readBytes(action, 1) && readBytes(mods, 1);
+			event.key = (short)key;
+			event.action = (int)action;
+			event.mods = (int)mods;
+		} else {
+			ok = readDouble(event.x) && readDouble(event.y);
+		}
+		if (!ok) {
+			inputReplayOver = true;
+			return false;
+		}
+	}
+	frame.eventCount = (unsigned int)eventCount;
+	return true;
+}
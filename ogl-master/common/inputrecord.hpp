@@ -0,0 +1,49 @@
+#ifndef INPUTRECORD_HPP
+#define INPUTRECORD_HPP
+
+// Input sessions saved to a file and played back, for benchmarks that must do the same thing
+// every time. computeMatricesFromInputs (controls.hpp) writes, or reads, one frame per call :
+// the simulation tick it starts at, how long it lasted, and the input events it applied. A
+// replay runs the same frames with the same durations and the same events, so the camera and
+// the player's rocket go through the same ticks, whatever the speed of the machine; only the
+// time it takes to draw them changes. See tutorial04 --record and --replay.
+//
+// What runs on other threads must be waited for : tutorial04 draws the fleet (rocketfleet.hpp)
+// from whatever snapshot its threads have finished, so when replaying it waits for the snapshot
+// of the current tick (waitForRocketFleet). The states are the same as long as the floating
+// point math is : same build, same kind of CPU.
+//
+// The file, little endian :
+//   "OGLI", version (u32), ROCKET_TICKS_PER_SECOND (u32)
+//   then per frame : tick (u32), frame time in seconds (f32), event count (u16), the events :
+//     type (u8), seconds since the recording started (f32), then
+//     INPUT_KEY : key (i16), action (u8), mods (u8)
+//     the others : x, y (f64)
+
+#define INPUT_RECORD_VERSION 1
+
+struct InputFrame {
+	unsigned long long tick;
+	float deltaTime;
+	unsigned int eventCount;
+	InputEvent events[INPUT_QUEUE_CAPACITY];
+};
+
+// One at a time : starting one stops the other
+bool startInputRecording(const char * path);
+bool startInputReplay(const char * path);
+// Closes the file
+void stopInputRecord();
+
+bool isRecordingInput();
+bool isReplayingInput();
+// The last frame was read : stop the main loop
+bool isInputReplayOver();
+
+// Flushed to the OS every frame. false, with a message, if it can't be written : the recording
+// then stops, and the file keeps the frames before.
+bool writeInputFrame(const InputFrame & frame);
+// false at the end of the recording, or if the file is cut short
+bool readInputFrame(InputFrame & frame);
+
+#endif
@@ -0,0 +1,158 @@
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "jobsystem.hpp"
+
+struct Job {
+	JobFunction function;
+	void * data;
+	unsigned int first;
+	unsigned int last;
+	std::atomic<unsigned int> * pending; // Jobs of the same parallelFor still to finish
+};
+
+// Each worker owns one. The owner pushes and pops at the back, thieves take from the front.
+struct WorkerQueue {
+	std::mutex mutex;
+	std::deque<Job> jobs;
+};
+
+struct JobSystem {
+	std::vector<std::thread> threads;
+	std::vector<WorkerQueue*> queues;   // queues[0] belongs to the thread calling parallelFor
+
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<unsigned int> queuedJobs;
+	bool quit;
+};
+
+static bool popJob(WorkerQueue * queue, Job & job){
+	std::lock_guard<std::mutex> lock(queue->mutex);
+	if (queue->jobs.empty())
+		return false;
+	job = queue->jobs.back();
+	queue->jobs.pop_back();
+	return true;
+}
+
+static bool stealJob(WorkerQueue * queue, Job & job){
+	std::lock_guard<std::mutex> lock(queue->mutex);
+	if (queue->jobs.empty())
+		return false;
+	job = queue->jobs.front();
+	queue->jobs.pop_front();
+	return true;
+}
+
+// Own queue first, then the others, starting with the next one
+static bool findJob(JobSystem * jobs, unsigned int worker, Job & job){
+	if (popJob(jobs->queues[worker], job))
+		return true;
+	unsigned int queueCount = (unsigned int)jobs->queues.size();
+	for (unsigned int i = 1; i < queueCount; i++) {
+		if (stealJob(jobs->queues[(worker + i) % queueCount], job))
+			return true;
+	}
+	return false;
+}
+
+static void runJob(JobSystem * jobs, Job & job){
+	jobs->queuedJobs--;
+	job.function(job.data, job.first, job.last);
+	(*job.pending)--;
+}
+
+static void workerLoop(JobSystem * jobs, unsigned int worker){
+	while (true) {
+		Job job;
+		if (findJob(jobs, worker, job)) {
+			runJob(jobs, job);
+			continue;
+		}
+
+		// Nothing to do : sleep until parallelFor queues more work
+		std::unique_lock<std::mutex> lock(jobs->sleepMutex);
+		jobs->wake.wait(lock, [jobs]{ return jobs->quit || jobs->queuedJobs > 0; });
+		if (jobs->quit)
+			return;
+	}
+}
+
+JobSystem * createJobSystem(unsigned int workerCount){
+	if (workerCount == 0)
+		workerCount = std::thread::hardware_concurrency();
+	if (workerCount == 0)
+		workerCount = 1;
+
+	JobSystem * jobs = new JobSystem;
+	jobs->queuedJobs = 0;
+	jobs->quit = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+		jobs->queues.push_back(new WorkerQueue);
+
+	// The calling thread is worker 0 : start the others
+	for (unsigned int i = 1; i < workerCount; i++)
+		jobs->threads.push_back(std::thread(workerLoop, jobs, i));
+	return jobs;
+}
+
+void destroyJobSystem(JobSystem * jobs){
+	{
+		std::lock_guard<std::mutex> lock(jobs->sleepMutex);
+		jobs->quit = true;
+	}
+	jobs->wake.notify_all();
+	for (size_t i = 0; i < jobs->threads.size(); i++)
+		jobs->threads[i].join();
+	for (size_t i = 0; i < jobs->queues.size(); i++)
+		delete jobs->queues[i];
+	delete jobs;
+}
+
+unsigned int getJobSystemWorkerCount(const JobSystem * jobs){
+	return (unsigned int)jobs->queues.size();
+}
+
+void parallelFor(JobSystem * jobs, unsigned int count, unsigned int chunkSize, JobFunction function, void * data){
+	if (count == 0)
+		return;
+	if (chunkSize == 0)
+		chunkSize = 1;
+
+	unsigned int chunkCount = (count + chunkSize - 1) / chunkSize;
+	std::atomic<unsigned int> pending(chunkCount);
+
+	// Deal the chunks round-robin, so that every worker starts with local work
+	unsigned int queueCount = (unsigned int)jobs->queues.size();
+	for (unsigned int chunk = 0; chunk < chunkCount; chunk++) {
+		Job job;
+		job.function = function;
+		job.data = data;
+		job.first = chunk * chunkSize;
+		job.last = job.first + chunkSize < count ? job.first + chunkSize : count;
+		job.pending = &pending;
+
+		WorkerQueue * queue = jobs->queues[chunk % queueCount];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(job);
+	}
+	{
+		std::lock_guard<std::mutex> lock(jobs->sleepMutex);
+		jobs->queuedJobs += chunkCount;
+	}
+	jobs->wake.notify_all();
+
+	// Help until everything is done
+	while (pending > 0) {
+		Job job;
+		if (findJob(jobs, 0, job))
+			runJob(jobs, job);
+		else
+			std::this_thread::yield(); // The last chunks are running on other workers
+	}
+}
@@ -0,0 +1,23 @@
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+
+// A small job system : one thread per core, each with its own queue of jobs.
+// A thread takes its newest job first; when its queue is empty it steals the oldest job of another thread.
+struct JobSystem;
+
+// Processes the items [first, last) of whatever data points to
+typedef void (*JobFunction)(void * data, unsigned int first, unsigned int last);
+
+// workerCount = 0 : one worker per hardware thread. The calling thread counts as a worker.
+JobSystem * createJobSystem(unsigned int workerCount = 0);
+void destroyJobSystem(JobSystem * jobs);
+
+unsigned int getJobSystemWorkerCount(const JobSystem * jobs);
+
+// Splits [0, count) into chunks of chunkSize items, runs function on every chunk, and returns
+// once they are all done. The calling thread works too.
+// The chunks only depend on count and chunkSize, never on the number of workers.
+// Call it from one thread at a time.
+void parallelFor(JobSystem * jobs, unsigned int count, unsigned int chunkSize, JobFunction function, void * data);
+
+#endif
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+
+bool openMappedFile(MappedFile & file, const char * path){
+	file.data = NULL;
+	file.size = 0;
+	file.mappingHandle = NULL;
+	file.fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if ( file.fileHandle == INVALID_HANDLE_VALUE ){
+		file.fileHandle = NULL;
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx(file.fileHandle, &size);
+	file.size = (size_t)size.QuadPart;
+	if ( file.size == 0 )
+		return true; // Nothing to map : data stays NULL
+
+	file.mappingHandle = CreateFileMappingA(file.fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if ( file.mappingHandle != NULL )
+		file.data = (const unsigned char *)MapViewOfFile(file.mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if ( file.data == NULL ){
+		closeMappedFile(file);
+		return false;
+	}
+	return true;
+}
+
+void closeMappedFile(MappedFile & file){
+	if ( file.data != NULL )          UnmapViewOfFile(file.data);
+	if ( file.mappingHandle != NULL ) CloseHandle(file.mappingHandle);
+	if ( file.fileHandle != NULL )    CloseHandle(file.fileHandle);
+	file.data = NULL;
+	file.size = 0;
+	file.mappingHandle = NULL;
+	file.fileHandle = NULL;
+}
+
+#else
+
+bool openMappedFile(MappedFile & file, const char * path){
+	file.data = NULL;
+	file.size = 0;
+	file.descriptor = open(path, O_RDONLY);
+	if ( file.descriptor < 0 )
+		return false;
+
+	struct stat status;
+	if ( fstat(file.descriptor, &status) != 0 ){
+		closeMappedFile(file);
+		return false;
+	}
+	file.size = (size_t)status.st_size;
+	if ( file.size == 0 )
+		return true; // Nothing to map : data stays NULL
+
+	void * data = mmap(NULL, file.size, PROT_READ, MAP_PRIVATE, file.descriptor, 0);
+	if ( data == MAP_FAILED ){
+		closeMappedFile(file);
+		return false;
+	}
+	// The whole file will be read, in order : tell the OS to read ahead
+	madvise(data, file.size, MADV_SEQUENTIAL);
+	madvise(data, file.size, MADV_WILLNEED);
+	file.data = (const unsigned char *)data;
+	return true;
+}
+
+void closeMappedFile(MappedFile & file){
+	if ( file.data != NULL )
+		munmap((void*)file.data, file.size);
+	if ( file.descriptor >= 0 )
+		close(file.descriptor);
+	file.data = NULL;
+	file.size = 0;
+	file.descriptor = -1;
+}
+
+#endif
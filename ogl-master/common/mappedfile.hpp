@@ -0,0 +1,20 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+// A whole file mapped in memory, read-only : the pages are read from the disk when first touched,
+// and shared with the file cache of the OS instead of being copied.
+struct MappedFile {
+	const unsigned char * data;
+	size_t size;
+#ifdef _WIN32
+	void * fileHandle;
+	void * mappingHandle;
+#else
+	int descriptor;
+#endif
+};
+
+bool openMappedFile(MappedFile & file, const char * path);
+void closeMappedFile(MappedFile & file);
+
+#endif
@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "mappedfile.hpp"
+#include "meshcache.hpp"
+#include "objloader.hpp"
+#include "vboindexer.hpp"
+#include "meshoptimizer.hpp"
+
+static const unsigned int MESHCACHE_ALIGNMENT = 16;
+
+static const unsigned int attributeComponents[MESHCACHE_ATTRIBUTE_COUNT] = { 3, 2, 3, 3, 3 };
+
+static unsigned int alignOffset(unsigned int offset){
+	return (offset + MESHCACHE_ALIGNMENT - 1) & ~(MESHCACHE_ALIGNMENT - 1);
+}
+
+// Size and modification time : enough to notice an edited OBJ without reading it.
+// false if there is no such file.
+static bool getSourceStamp(const char * path, unsigned long long & size, long long & time){
+	struct stat status;
+	if ( path == NULL || stat(path, &status) != 0 )
+		return false;
+	size = (unsigned long long)status.st_size;
+	time = (long long)status.st_mtime;
+	return true;
+}
+
+bool writeMeshCache(
+	const char * path,
+	const char * sourcePath,
+	unsigned int vertexCount,
+	const glm::vec3 * positions,
+	const glm::vec2 * uvs,
+	const glm::vec3 * normals,
+	const void * indices, unsigned int indexCount, GLenum indexType,
+	const glm::vec3 * tangents,
+	const glm::vec3 * bitangents
+){
+	const void * streams[MESHCACHE_ATTRIBUTE_COUNT] = { positions, uvs, normals, tangents, bitangents };
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "OGLM", 4);
+	header.version     = MESHCACHE_VERSION;
+	header.vertexCount = vertexCount;
+	header.indexCount  = indexCount;
+	header.indexType   = indexType;
+	if ( !getSourceStamp(sourcePath, header.sourceSize, header.sourceTime) ){
+		header.sourceSize = 0;
+		header.sourceTime = 0;
+	}
+
+	glm::vec3 boxMin(0.0f), boxMax(0.0f);
+	for ( unsigned int i=0; i<vertexCount; i++ ){
+		boxMin = i == 0 ? positions[i] : glm::min(boxMin, positions[i]);
+		boxMax = i == 0 ? positions[i] : glm::max(boxMax, positions[i]);
+	}
+	memcpy(header.boxMin, &boxMin[0], sizeof(header.boxMin));
+	memcpy(header.boxMax, &boxMax[0], sizeof(header.boxMax));
+
+	// Where everything goes
+	unsigned int offset = alignOffset(sizeof(MeshCacheHeader));
+	for ( int a=0; a<MESHCACHE_ATTRIBUTE_COUNT; a++ ){
+		if ( streams[a] == NULL )
+			continue;
+		header.streams[a].offset     = offset;
+		header.streams[a].size       = vertexCount * attributeComponents[a] * sizeof(float);
+		header.streams[a].components = attributeComponents[a];
+		header.streams[a].type       = GL_FLOAT;
+		offset = alignOffset(offset + header.streams[a].size);
+	}
+	header.indexOffset = offset;
+	header.indexSize   = indexCount * (indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int));
+
+	FILE * file = fopen(path, "wb");
+	if ( file == NULL ){
+		printf("%s could not be written.\n", path);
+		return false;
+	}
+
+	static const char padding[MESHCACHE_ALIGNMENT] = { 0 };
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	unsigned int written = sizeof(header);
+	for ( int a=0; a<=MESHCACHE_ATTRIBUTE_COUNT && ok; a++ ){
+		const void * data = a < MESHCACHE_ATTRIBUTE_COUNT ? streams[a] : indices;
+		unsigned int start = a < MESHCACHE_ATTRIBUTE_COUNT ? header.streams[a].offset : header.indexOffset;
+		unsigned int size  = a < MESHCACHE_ATTRIBUTE_COUNT ? header.streams[a].size   : header.indexSize;
+		if ( data == NULL || size == 0 )
+			continue;
+		ok = ok && fwrite(padding, 1, start - written, file) == start - written;
+		ok = ok && fwrite(data, 1, size, file) == size;
+		written = start + size;
+	}
+	fclose(file);
+
+	if ( !ok )
+		printf("%s could not be written.\n", path);
+	return ok;
+}
+
+bool openMeshCache(const char * path, MeshCache & cache, const char * sourcePath){
+	cache.header = NULL;
+	if ( !openMappedFile(cache.file, path) )
+		return false;
+
+	const MeshCacheHeader * header = (const MeshCacheHeader *)cache.file.data;
+	bool valid = cache.file.size >= sizeof(MeshCacheHeader)
+		&& memcmp(header->magic, "OGLM", 4) == 0
+		&& header->version == MESHCACHE_VERSION
+		&& (header->indexType == GL_UNSIGNED_SHORT || header->indexType == GL_UNSIGNED_INT)
+		&& (size_t)header->indexOffset + header->indexSize <= cache.file.size
+		&& header->streams[MESHCACHE_POSITION].size > 0;
+	for ( int a=0; a<MESHCACHE_ATTRIBUTE_COUNT && valid; a++ ){
+		const MeshCacheStream & stream = header->streams[a];
+		valid = (size_t)stream.offset + stream.size <= cache.file.size
+			&& (stream.size == 0 || stream.size == header->vertexCount * attributeComponents[a] * sizeof(float));
+	}
+	if ( valid ){
+		// Each index must name a vertex that is in the file : the GPU doesn't check
+		size_t indexBytes = header->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+		valid = (size_t)header->indexCount * indexBytes == header->indexSize;
+		const unsigned char * indices = cache.file.data + header->indexOffset;
+		for ( unsigned int i=0; i<header->indexCount && valid; i++ ){
+			unsigned int index;
+			if ( header->indexType == GL_UNSIGNED_SHORT )
+				index = ((const unsigned short *)indices)[i];
+			else
+				index = ((const unsigned int *)indices)[i];
+			valid = index < header->vertexCount;
+		}
+	}
+	if ( !valid ){
+		printf("%s is not a valid mesh cache of version %d\n", path, MESHCACHE_VERSION);
+		closeMeshCache(cache);
+		return false;
+	}
+
+	// Without the OBJ (shipped alone, say), the cache is all there is
+	unsigned long long sourceSize;
+	long long sourceTime;
+	if ( header->sourceSize != 0 && getSourceStamp(sourcePath, sourceSize, sourceTime)
+		&& (sourceSize != header->sourceSize || sourceTime != header->sourceTime) ){
+		printf("%s is out of date : %s changed since\n", path, sourcePath);
+		closeMeshCache(cache);
+		return false;
+	}
+
+	cache.header = header;
+	return true;
+}
+
+const void * getMeshCacheStream(const MeshCache & cache, MeshCacheAttribute attribute){
+	const MeshCacheStream & stream = cache.header->streams[attribute];
+	return stream.size > 0 ? cache.file.data + stream.offset : NULL;
+}
+
+const void * getMeshCacheIndices(const MeshCache & cache){
+	return cache.file.data + cache.header->indexOffset;
+}
+
+void closeMeshCache(MeshCache & cache){
+	closeMappedFile(cache.file);
+	cache.header = NULL;
+}
+
+
+bool loadIndexedMesh(const char * objPath, IndexedMesh & mesh){
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	if ( !loadOBJ(objPath, vertices, uvs, normals) )
+		return false;
+
+	mesh.shortIndices.clear();
+	mesh.indexType = GL_UNSIGNED_INT;
+	return indexVBO(vertices, uvs, normals, mesh.indices, mesh.positions, mesh.uvs, mesh.normals) && !mesh.indices.empty();
+}
+
+void optimizeIndexedMesh(IndexedMesh & mesh){
+	optimizeVertexCache(mesh.indices, mesh.positions.size());
+	optimizeOverdraw(mesh.indices, mesh.positions);
+	std::vector<unsigned int> remap;
+	size_t used = optimizeVertexFetch(mesh.indices, mesh.positions.size(), remap);
+	remapVertices(mesh.positions, remap, used);
+	remapVertices(mesh.uvs, remap, used);
+	remapVertices(mesh.normals, remap, used);
+
+	mesh.shortIndices.clear();
+	mesh.indexType = GL_UNSIGNED_INT;
+	if ( mesh.positions.size() <= 65536 ){
+		mesh.shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+		mesh.indexType = GL_UNSIGNED_SHORT;
+	}
+}
+
+const void * getIndexedMeshIndices(const IndexedMesh & mesh){
+	if ( mesh.indexType == GL_UNSIGNED_SHORT )
+		return &mesh.shortIndices[0];
+	return &mesh.indices[0];
+}
+
+bool writeIndexedMesh(const char * path, const char * sourcePath, const IndexedMesh & mesh){
+	return writeMeshCache(path, sourcePath, (unsigned int)mesh.positions.size(), &mesh.positions[0], &mesh.uvs[0], &mesh.normals[0],
+		getIndexedMeshIndices(mesh), (unsigned int)mesh.indices.size(), mesh.indexType);
+}
+
+
+static GLuint createBuffer(GLenum target, const void * data, size_t size){
+	GLuint buffer = 0;
+	if ( data == NULL )
+		return 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	glBufferData(target, size, data, GL_STATIC_DRAW);
+	return buffer;
+}
+
+bool loadMeshBuffers(const char * cachePath, const char * objPath, MeshBuffers & buffers){
+	MeshCache cache;
+	if ( openMeshCache(cachePath, cache, objPath) ){
+		// The mapped pages go straight to the driver
+		const MeshCacheHeader & header = *cache.header;
+		buffers.vertexbuffer  = createBuffer(GL_ARRAY_BUFFER, getMeshCacheStream(cache, MESHCACHE_POSITION), header.streams[MESHCACHE_POSITION].size);
+		buffers.uvbuffer      = createBuffer(GL_ARRAY_BUFFER, getMeshCacheStream(cache, MESHCACHE_UV), header.streams[MESHCACHE_UV].size);
+		buffers.normalbuffer  = createBuffer(GL_ARRAY_BUFFER, getMeshCacheStream(cache, MESHCACHE_NORMAL), header.streams[MESHCACHE_NORMAL].size);
+		buffers.elementbuffer = createBuffer(GL_ELEMENT_ARRAY_BUFFER, getMeshCacheIndices(cache), header.indexSize);
+		buffers.indexCount    = (GLsizei)header.indexCount;
+		buffers.indexType     = header.indexType;
+		closeMeshCache(cache);
+		return true;
+	}
+
+	// No cache yet, or an old one : the slow way, once
+	IndexedMesh mesh;
+	if ( !loadIndexedMesh(objPath, mesh) )
+		return false;
+	optimizeIndexedMesh(mesh);
+
+	const void * indexData = getIndexedMeshIndices(mesh);
+	size_t indexSize = mesh.indices.size() * (mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int));
+	buffers.vertexbuffer  = createBuffer(GL_ARRAY_BUFFER, &mesh.positions[0], mesh.positions.size() * sizeof(glm::vec3));
+	buffers.uvbuffer      = createBuffer(GL_ARRAY_BUFFER, &mesh.uvs[0], mesh.uvs.size() * sizeof(glm::vec2));
+	buffers.normalbuffer  = createBuffer(GL_ARRAY_BUFFER, &mesh.normals[0], mesh.normals.size() * sizeof(glm::vec3));
+	buffers.elementbuffer = createBuffer(GL_ELEMENT_ARRAY_BUFFER, indexData, indexSize);
+	buffers.indexCount    = (GLsizei)mesh.indices.size();
+	buffers.indexType     = mesh.indexType;
+
+	writeIndexedMesh(cachePath, objPath, mesh);
+	return true;
+}
+
+void cleanupMeshBuffers(MeshBuffers & buffers){
+	glDeleteBuffers(1, &buffers.vertexbuffer);
+	glDeleteBuffers(1, &buffers.uvbuffer);
+	glDeleteBuffers(1, &buffers.normalbuffer);
+	glDeleteBuffers(1, &buffers.elementbuffer);
+	buffers.vertexbuffer = buffers.uvbuffer = buffers.normalbuffer = buffers.elementbuffer = 0;
+}
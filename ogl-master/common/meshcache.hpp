@@ -0,0 +1,116 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+// Binary mesh files : the indexed vertex streams, exactly as glBufferData wants them.
+// Loading one is mapping the file and pointing OpenGL at it, no parsing.
+//
+// Layout (little-endian) : a MeshCacheHeader, then the streams and the indices,
+// each starting on a 16-byte boundary. Make them with misc07_tools/obj2mesh.
+//
+// A cache remembers the size and modification time of the OBJ it was made from : when the OBJ
+// changes, the cache is out of date and loadMeshBuffers makes it again.
+
+#define MESHCACHE_VERSION 2
+
+enum MeshCacheAttribute {
+	MESHCACHE_POSITION,   // 3 floats
+	MESHCACHE_UV,         // 2 floats
+	MESHCACHE_NORMAL,     // 3 floats
+	MESHCACHE_TANGENT,    // 3 floats
+	MESHCACHE_BITANGENT,  // 3 floats
+	MESHCACHE_ATTRIBUTE_COUNT
+};
+
+struct MeshCacheStream {
+	unsigned int offset;      // In bytes, from the start of the file
+	unsigned int size;        // In bytes. 0 : the mesh doesn't have this attribute
+	unsigned int components;
+	unsigned int type;        // GL_FLOAT
+};
+
+struct MeshCacheHeader {
+	char magic[4];            // "OGLM"
+	unsigned int version;     // MESHCACHE_VERSION
+	unsigned long long sourceSize;   // Of the OBJ, in bytes. 0 : unknown, never out of date
+	long long sourceTime;            // Of the OBJ, in seconds since 1970
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	unsigned int indexType;   // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int indexOffset;
+	unsigned int indexSize;
+	float boxMin[3];          // Bounding box of the positions
+	float boxMax[3];
+	MeshCacheStream streams[MESHCACHE_ATTRIBUTE_COUNT];
+};
+
+// Writes an indexed mesh. Any attribute but the positions can be NULL.
+// indices are unsigned shorts or unsigned ints, as given by indexType.
+// sourcePath is the OBJ the mesh comes from, NULL if none.
+bool writeMeshCache(
+	const char * path,
+	const char * sourcePath,
+	unsigned int vertexCount,
+	const glm::vec3 * positions,
+	const glm::vec2 * uvs,
+	const glm::vec3 * normals,
+	const void * indices, unsigned int indexCount, GLenum indexType,
+	const glm::vec3 * tangents = NULL,
+	const glm::vec3 * bitangents = NULL
+);
+
+// An opened mesh file. The pointers are valid until closeMeshCache.
+struct MeshCache {
+	MappedFile file;
+	const MeshCacheHeader * header;
+};
+
+// Maps the file and checks it. false if it is missing, of another version, truncated, has indices
+// past the last vertex, or if sourcePath is given and has changed since the cache was written.
+bool openMeshCache(const char * path, MeshCache & cache, const char * sourcePath = NULL);
+
+// NULL if the mesh doesn't have this attribute
+const void * getMeshCacheStream(const MeshCache & cache, MeshCacheAttribute attribute);
+const void * getMeshCacheIndices(const MeshCache & cache);
+
+void closeMeshCache(MeshCache & cache);
+
+
+// What goes in a mesh cache : an OBJ indexed with indexVBO, then optimized (meshoptimizer.hpp).
+// The one pipeline behind loadMeshBuffers and obj2mesh.
+struct IndexedMesh {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<unsigned int> indices;
+	std::vector<unsigned short> shortIndices;   // The same, when indexType is GL_UNSIGNED_SHORT
+	GLenum indexType;
+};
+
+// loadOBJ, then indexVBO. false if the file can't be read or has no triangles.
+bool loadIndexedMesh(const char * objPath, IndexedMesh & mesh);
+// Triangles in vertex cache friendly order, then vertices in the order they are used. Picks
+// 16-bit indices whenever they are enough : half the memory and bandwidth.
+void optimizeIndexedMesh(IndexedMesh & mesh);
+// indices or shortIndices, as given by indexType
+const void * getIndexedMeshIndices(const IndexedMesh & mesh);
+bool writeIndexedMesh(const char * path, const char * sourcePath, const IndexedMesh & mesh);
+
+
+// The GL buffers of a mesh, as the tutorials use them : one VBO per attribute, and the indices
+struct MeshBuffers {
+	GLuint vertexbuffer;
+	GLuint uvbuffer;
+	GLuint normalbuffer;
+	GLuint elementbuffer;
+	GLsizei indexCount;
+	GLenum indexType;
+};
+
+// Uploads the mesh of cachePath straight from the mapped file. If there is no valid cache, or
+// objPath changed since it was written, loads objPath with loadIndexedMesh and
+// optimizeIndexedMesh instead, and writes cachePath for the next time.
+bool loadMeshBuffers(const char * cachePath, const char * objPath, MeshBuffers & buffers);
+
+void cleanupMeshBuffers(MeshBuffers & buffers);
+
+#endif
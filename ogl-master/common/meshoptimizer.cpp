@@ -0,0 +1,340 @@
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include <glm/glm.hpp>
+
+#include "meshoptimizer.hpp"
+
+template <typename Index>
+static VertexCacheStats analyzeVertexCacheT(const std::vector<Index> & indices, size_t vertexCount, unsigned int cacheSize){
+	// FIFO : a vertex stays in the cache until cacheSize other vertices were transformed after it.
+	// With a timestamp per vertex, no need to actually move anything around.
+	std::vector<unsigned int> transformedAt(vertexCount, 0);
+	unsigned int time = cacheSize + 1; // Everything starts out of the cache
+	VertexCacheStats stats;
+	stats.transformed = 0;
+	for ( size_t i=0; i<indices.size(); i++ ){
+		Index v = indices[i];
+		if ( time - transformedAt[v] > cacheSize ){
+			transformedAt[v] = time++;
+			stats.transformed++;
+		}
+	}
+	size_t triangles = indices.size() / 3;
+	stats.acmr = triangles   > 0 ? (float)stats.transformed / triangles   : 0.0f;
+	stats.atvr = vertexCount > 0 ? (float)stats.transformed / vertexCount : 0.0f;
+	return stats;
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned short> & indices, size_t vertexCount, unsigned int cacheSize){
+	return analyzeVertexCacheT(indices, vertexCount, cacheSize);
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> & indices, size_t vertexCount, unsigned int cacheSize){
+	return analyzeVertexCacheT(indices, vertexCount, cacheSize);
+}
+
+
+// Forsyth's "Linear-Speed Vertex Cache Optimisation" : every vertex has a score, higher when it's
+// recently used (in a simulated LRU cache) and when few triangles still need it. Each step draws
+// the triangle with the best total score among those that use cached vertices.
+#define FORSYTH_CACHE_SIZE    32
+#define FORSYTH_MAX_VALENCE   32
+
+struct ForsythScores {
+	float cache[FORSYTH_CACHE_SIZE];       // By position in the cache
+	float valence[FORSYTH_MAX_VALENCE];    // By number of triangles left
+};
+
+static void initForsythScores(ForsythScores & scores){
+	for ( int i=0; i<FORSYTH_CACHE_SIZE; i++ ){
+		if ( i < 3 ){
+			scores.cache[i] = 0.75f; // The last triangle : using it again gains nothing in practice
+		}else{
+			float scaler = 1.0f - (float)(i - 3) / (FORSYTH_CACHE_SIZE - 3);
+			scores.cache[i] = powf(scaler, 1.5f);
+		}
+	}
+	scores.valence[0] = 0.0f;
+	for ( int i=1; i<FORSYTH_MAX_VALENCE; i++ )
+		scores.valence[i] = 2.0f / sqrtf((float)i); // Finish off vertices with few triangles left
+}
+
+static inline float vertexScore(const ForsythScores & scores, int cachePosition, unsigned int remaining){
+	if ( remaining == 0 )
+		return -1.0f; // No triangle left : never worth anything
+	float score = cachePosition >= 0 ? scores.cache[cachePosition] : 0.0f;
+	return score + (remaining < FORSYTH_MAX_VALENCE ? scores.valence[remaining] : 2.0f / sqrtf((float)remaining));
+}
+
+template <typename Index>
+static void optimizeVertexCacheT(std::vector<Index> & indices, size_t vertexCount){
+	size_t triangleCount = indices.size() / 3;
+	if ( triangleCount == 0 )
+		return;
+	ForsythScores scores;
+	initForsythScores(scores);
+
+	// Triangles of each vertex, all in one array
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for ( size_t i=0; i<triangleCount*3; i++ )
+		remaining[indices[i]]++;
+	std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+	for ( size_t v=0; v<vertexCount; v++ )
+		firstTriangle[v+1] = firstTriangle[v] + remaining[v];
+	std::vector<unsigned int> vertexTriangles(triangleCount * 3);
+	{
+		std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for ( size_t i=0; i<triangleCount*3; i++ )
+			vertexTriangles[filled[indices[i]]++] = (unsigned int)(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+	for ( size_t v=0; v<vertexCount; v++ )
+		score[v] = vertexScore(scores, -1, remaining[v]);
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for ( size_t t=0; t<triangleCount; t++ )
+		triangleScore[t] = score[indices[3*t]] + score[indices[3*t+1]] + score[indices[3*t+2]];
+
+	// The cache, most recent first. 3 more entries for the vertices pushed out by a triangle.
+	unsigned int cache[FORSYTH_CACHE_SIZE + 3];
+	unsigned int cacheCount = 0;
+
+	std::vector<Index> out(triangleCount * 3);
+	size_t nextUnemitted = 0;
+	long long best = 0;
+	for ( size_t t=1; t<triangleCount; t++ )
+		if ( triangleScore[t] > triangleScore[best] )
+			best = (long long)t;
+
+	for ( size_t drawn=0; drawn<triangleCount; drawn++ ){
+		if ( best < 0 ){
+			// Nothing in the cache is used by a triangle that's left : start again anywhere
+			while ( emitted[nextUnemitted] )
+				nextUnemitted++;
+			best = (long long)nextUnemitted;
+		}
+		const Index * triangle = &indices[3 * best];
+		out[3*drawn+0] = triangle[0];
+		out[3*drawn+1] = triangle[1];
+		out[3*drawn+2] = triangle[2];
+		emitted[best] = true;
+
+		// The vertices of this triangle have one triangle less to wait for
+		for ( int c=0; c<3; c++ ){
+			unsigned int v = triangle[c];
+			unsigned int * list = &vertexTriangles[firstTriangle[v]];
+			for ( unsigned int k=0; k<remaining[v]; k++ ){
+				if ( list[k] == (unsigned int)best ){
+					list[k] = list[remaining[v] - 1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// New cache : the triangle first, then what was there before
+		unsigned int newCache[FORSYTH_CACHE_SIZE + 3];
+		unsigned int newCount = 0;
+		for ( int c=0; c<3; c++ ){
+			unsigned int v = triangle[c];
+			bool duplicate = false; // Degenerate triangles
+			for ( unsigned int k=0; k<newCount; k++ )
+				duplicate |= newCache[k] == v;
+			if ( !duplicate )
+				newCache[newCount++] = v;
+		}
+		for ( unsigned int k=0; k<cacheCount; k++ ){
+			unsigned int v = cache[k];
+			if ( v != triangle[0] && v != triangle[1] && v != triangle[2] )
+				newCache[newCount++] = v;
+		}
+
+		// New scores for the vertices that moved or fell out, and for their triangles
+		for ( unsigned int k=0; k<newCount; k++ ){
+			unsigned int v = newCache[k];
+			cachePosition[v] = k < FORSYTH_CACHE_SIZE ? (int)k : -1;
+			score[v] = vertexScore(scores, cachePosition[v], remaining[v]);
+		}
+		best = -1;
+		float bestScore = -1e30f;
+		for ( unsigned int k=0; k<newCount; k++ ){
+			unsigned int v = newCache[k];
+			const unsigned int * list = &vertexTriangles[firstTriangle[v]];
+			for ( unsigned int j=0; j<remaining[v]; j++ ){
+				unsigned int t = list[j];
+				float s = score[indices[3*t]] + score[indices[3*t+1]] + score[indices[3*t+2]];
+				triangleScore[t] = s;
+				if ( s > bestScore ){
+					bestScore = s;
+					best = (long long)t;
+				}
+			}
+		}
+
+		cacheCount = newCount < FORSYTH_CACHE_SIZE ? newCount : FORSYTH_CACHE_SIZE;
+		for ( unsigned int k=0; k<cacheCount; k++ )
+			cache[k] = newCache[k];
+	}
+
+	indices.swap(out);
+}
+
+void optimizeVertexCache(std::vector<unsigned short> & indices, size_t vertexCount){
+	optimizeVertexCacheT(indices, vertexCount);
+}
+
+void optimizeVertexCache(std::vector<unsigned int> & indices, size_t vertexCount){
+	optimizeVertexCacheT(indices, vertexCount);
+}
+
+
+// Overdraw (Tipsify, Sander et al.) : in the order the cache optimizer made, a cluster grows
+// until its own ACMR, counted from an empty cache, is back within threshold times the ACMR of the
+// whole mesh. Every cluster then costs about the same, wherever it is drawn, so moving whole
+// clusters around hardly changes the ACMR. The clusters that face away from the center of the
+// mesh are the ones most likely to be in front, from any point of view : they are drawn first.
+struct OverdrawCluster {
+	size_t first;     // In triangles
+	size_t count;
+	float sortKey;
+};
+
+static bool compareClusters(const OverdrawCluster & a, const OverdrawCluster & b){
+	return a.sortKey > b.sortKey;
+}
+
+template <typename Index>
+static bool optimizeOverdrawT(std::vector<Index> & indices, const std::vector<glm::vec3> & vertices, float threshold, size_t * clusterCount){
+	size_t triangleCount = indices.size() / 3;
+	if ( clusterCount )
+		*clusterCount = 0;
+	if ( triangleCount == 0 )
+		return true;
+	VertexCacheStats before = analyzeVertexCacheT(indices, vertices.size(), 16);
+	float targetACMR = before.acmr * threshold;
+
+	// Cut into clusters. Each starts with an empty cache : moving the time forward by more than
+	// the cache size makes every vertex a miss again.
+	std::vector<OverdrawCluster> clusters;
+	std::vector<unsigned int> transformedAt(vertices.size(), 0);
+	unsigned int time = 17;
+	size_t clusterFirst = 0, clusterMisses = 0;
+	for ( size_t t=0; t<triangleCount; t++ ){
+		for ( int c=0; c<3; c++ ){
+			Index v = indices[3*t + c];
+			if ( time - transformedAt[v] > 16 ){
+				transformedAt[v] = time++;
+				clusterMisses++;
+			}
+		}
+		// Cheap enough now : the next triangle starts a new cluster
+		size_t count = t + 1 - clusterFirst;
+		bool cheap = clusterMisses <= targetACMR * count;
+		if ( !cheap && t + 1 == triangleCount && !clusters.empty() ){
+			// The rest never got cheap enough on its own : it goes on with the cluster before it
+			clusters.back().count += count;
+		}else if ( cheap || t + 1 == triangleCount ){
+			OverdrawCluster cluster = { clusterFirst, count, 0.0f };
+			clusters.push_back(cluster);
+			clusterFirst = t + 1;
+			clusterMisses = 0;
+			time += 17;
+		}
+	}
+	if ( clusterCount )
+		*clusterCount = clusters.size();
+	if ( clusters.size() < 2 )
+		return true;
+
+	// Center of the mesh : centroid of the surface
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	for ( size_t t=0; t<triangleCount; t++ ){
+		const glm::vec3 & a = vertices[indices[3*t]], & b = vertices[indices[3*t+1]], & c = vertices[indices[3*t+2]];
+		float area = glm::length(glm::cross(b - a, c - a));
+		meshCenter += area * (a + b + c);
+		meshArea += area;
+	}
+	meshCenter /= meshArea > 0.0f ? 3.0f * meshArea : 1.0f;
+
+	for ( size_t k=0; k<clusters.size(); k++ ){
+		OverdrawCluster & cluster = clusters[k];
+		glm::vec3 center(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for ( size_t t=cluster.first; t<cluster.first+cluster.count; t++ ){
+			const glm::vec3 & a = vertices[indices[3*t]], & b = vertices[indices[3*t+1]], & c = vertices[indices[3*t+2]];
+			glm::vec3 n = glm::cross(b - a, c - a); // Length is twice the area
+			float triangleArea = glm::length(n);
+			center += triangleArea * (a + b + c);
+			normal += n;
+			area += triangleArea;
+		}
+		center /= area > 0.0f ? 3.0f * area : 1.0f;
+		float length = glm::length(normal);
+		cluster.sortKey = length > 0.0f ? glm::dot(center - meshCenter, normal / length) : 0.0f;
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), compareClusters);
+
+	std::vector<Index> sorted;
+	sorted.reserve(indices.size());
+	for ( size_t k=0; k<clusters.size(); k++ )
+		sorted.insert(sorted.end(), indices.begin() + 3 * clusters[k].first, indices.begin() + 3 * (clusters[k].first + clusters[k].count));
+
+	VertexCacheStats after = analyzeVertexCacheT(sorted, vertices.size(), 16);
+	if ( after.acmr > before.acmr * threshold )
+		return false;
+	indices.swap(sorted);
+	return true;
+}
+
+bool optimizeOverdraw(std::vector<unsigned short> & indices, const std::vector<glm::vec3> & vertices, float threshold, size_t * clusterCount){
+	return optimizeOverdrawT(indices, vertices, threshold, clusterCount);
+}
+
+bool optimizeOverdraw(std::vector<unsigned int> & indices, const std::vector<glm::vec3> & vertices, float threshold, size_t * clusterCount){
+	return optimizeOverdrawT(indices, vertices, threshold, clusterCount);
+}
+
+
+template <typename Index>
+static size_t optimizeVertexFetchT(std::vector<Index> & indices, size_t vertexCount, std::vector<unsigned int> & remap){
+	remap.assign(vertexCount, 0xFFFFFFFFu);
+	unsigned int used = 0;
+	for ( size_t i=0; i<indices.size(); i++ ){
+		Index v = indices[i];
+		if ( remap[v] == 0xFFFFFFFFu )
+			remap[v] = used++;
+		indices[i] = (Index)remap[v];
+	}
+	return used;
+}
+
+size_t optimizeVertexFetch(std::vector<unsigned short> & indices, size_t vertexCount, std::vector<unsigned int> & remap){
+	return optimizeVertexFetchT(indices, vertexCount, remap);
+}
+
+size_t optimizeVertexFetch(std::vector<unsigned int> & indices, size_t vertexCount, std::vector<unsigned int> & remap){
+	return optimizeVertexFetchT(indices, vertexCount, remap);
+}
+
+template <typename T>
+static void remapVerticesT(std::vector<T> & stream, const std::vector<unsigned int> & remap, size_t usedCount){
+	std::vector<T> out(usedCount);
+	for ( size_t v=0; v<stream.size() && v<remap.size(); v++ )
+		if ( remap[v] != 0xFFFFFFFFu )
+			out[remap[v]] = stream[v];
+	stream.swap(out);
+}
+
+void remapVertices(std::vector<glm::vec2> & stream, const std::vector<unsigned int> & remap, size_t usedCount){
+	remapVerticesT(stream, remap, usedCount);
+}
+
+void remapVertices(std::vector<glm::vec3> & stream, const std::vector<unsigned int> & remap, size_t usedCount){
+	remapVerticesT(stream, remap, usedCount);
+}
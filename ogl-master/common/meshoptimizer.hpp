@@ -0,0 +1,45 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+// Reordering of indexed meshes, to run after indexVBO. Nothing changes the picture, only the
+// order in which the GPU gets the triangles and the vertices :
+//
+// 1. optimizeVertexCache : triangles that share vertices are drawn close together, so that
+//    the vertex shader results are still in the post-transform cache (Forsyth's algorithm).
+// 2. optimizeOverdraw    : (optional) the triangles are cut in clusters and the clusters that
+//    face outwards are drawn first, so that more pixels fail the depth test early.
+// 3. optimizeVertexFetch : the vertices are stored in the order the triangles use them, so
+//    that fetching them reads memory linearly. Then apply the remap to every vertex stream.
+//
+// analyzeVertexCache measures the result, no GPU needed.
+
+// Simulated post-transform cache (FIFO, like most GPUs)
+struct VertexCacheStats {
+	unsigned int transformed; // Vertex shader runs
+	float acmr;               // Average Cache Miss Ratio : transformed vertices per triangle. 0.5 is perfect, 3 is no cache at all.
+	float atvr;               // Average Transformed Vertex Ratio : transformed vertices per vertex. 1 is perfect.
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned short> & indices, size_t vertexCount, unsigned int cacheSize = 16);
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>   & indices, size_t vertexCount, unsigned int cacheSize = 16);
+
+void optimizeVertexCache(std::vector<unsigned short> & indices, size_t vertexCount);
+void optimizeVertexCache(std::vector<unsigned int>   & indices, size_t vertexCount);
+
+// Call after optimizeVertexCache : the clusters are runs of the triangles it ordered, each cut as
+// soon as its own ACMR, from an empty cache, is within threshold times the ACMR of the mesh.
+// If sorting them still makes the ACMR worse than threshold times what it was, the order is kept
+// and false is returned. clusterCount, if not NULL, gets the number of clusters.
+bool optimizeOverdraw(std::vector<unsigned short> & indices, const std::vector<glm::vec3> & vertices, float threshold = 1.05f, size_t * clusterCount = NULL);
+bool optimizeOverdraw(std::vector<unsigned int>   & indices, const std::vector<glm::vec3> & vertices, float threshold = 1.05f, size_t * clusterCount = NULL);
+
+// Renumbers the vertices in order of first use, and fills remap : remap[old index] = new index,
+// or 0xFFFFFFFF for vertices no triangle uses. Returns the number of vertices used.
+size_t optimizeVertexFetch(std::vector<unsigned short> & indices, size_t vertexCount, std::vector<unsigned int> & remap);
+size_t optimizeVertexFetch(std::vector<unsigned int>   & indices, size_t vertexCount, std::vector<unsigned int> & remap);
+
+// Reorders a vertex stream with the remap of optimizeVertexFetch. Unused vertices are dropped.
+void remapVertices(std::vector<glm::vec2> & stream, const std::vector<unsigned int> & remap, size_t usedCount);
+void remapVertices(std::vector<glm::vec3> & stream, const std::vector<unsigned int> & remap, size_t usedCount);
+
+#endif
@@ -0,0 +1,217 @@
+#include <vector>
+#include <map>
+#include <string.h> // for memcmp
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "vertexformat.hpp"
+#include "meshregistry.hpp"
+
+// Same trick as PackedVertex in vboindexer.cpp : exact, bitwise comparison.
+struct MeshVertexKey {
+	MeshVertex vertex;
+	bool operator<(const MeshVertexKey & that) const{
+		return memcmp((const void*)this, (const void*)&that, sizeof(MeshVertexKey))>0;
+	};
+};
+
+void initMeshRegistry(MeshRegistry & registry){
+	registry.vertices.clear();
+	registry.indices.clear();
+	registry.meshes.clear();
+	registry.vertexArrayID = 0;
+	registry.vertexBufferID = 0;
+	registry.elementBufferID = 0;
+	initVertexFormat(registry.format, VERTEX_FLOAT, VERTEX_ABSENT, VERTEX_ABSENT, VERTEX_FLOAT);
+}
+
+unsigned int addMesh(
+	MeshRegistry & registry,
+	GLenum mode,
+	const MeshVertex * vertices, unsigned int vertexCount,
+	const unsigned int * indices, unsigned int indexCount
+){
+	MeshRange range;
+	range.mode       = mode;
+	range.baseVertex = (GLint)registry.vertices.size();
+	range.firstIndex = (GLuint)registry.indices.size();
+
+	if ( indices != NULL ){
+		// Already indexed : copy as-is. Indices are relative to the mesh, baseVertex does the rest.
+		registry.vertices.insert(registry.vertices.end(), vertices, vertices + vertexCount);
+		registry.indices .insert(registry.indices .end(), indices , indices  + indexCount );
+		range.indexCount = (GLsizei)indexCount;
+	}else{
+		// Weld identical vertices so that each one is stored and transformed once
+		std::map<MeshVertexKey, unsigned int> VertexToOutIndex;
+		for ( unsigned int i=0; i<vertexCount; i++ ){
+			MeshVertexKey key = { vertices[i] }; // 6 floats, no padding to compare
+
+			std::map<MeshVertexKey, unsigned int>::iterator it = VertexToOutIndex.find(key);
+			if ( it != VertexToOutIndex.end() ){
+				registry.indices.push_back( it->second );
+			}else{
+				unsigned int newindex = (unsigned int)(registry.vertices.size() - range.baseVertex);
+				registry.vertices.push_back( vertices[i] );
+				registry.indices .push_back( newindex );
+				VertexToOutIndex[ key ] = newindex;
+			}
+		}
+		range.indexCount = (GLsizei)vertexCount;
+	}
+
+	range.boxMin = glm::vec3( 1e30f);
+	range.boxMax = glm::vec3(-1e30f);
+	for ( size_t i=range.baseVertex; i<registry.vertices.size(); i++ ){
+		range.boxMin = glm::min(range.boxMin, registry.vertices[i].position);
+		range.boxMax = glm::max(range.boxMax, registry.vertices[i].position);
+	}
+	range.dequantize = glm::mat4(1.0f);
+
+	registry.meshes.push_back(range);
+	return (unsigned int)registry.meshes.size() - 1;
+}
+
+unsigned int addMesh(
+	MeshRegistry & registry,
+	GLenum mode,
+	const GLfloat * positions, const GLfloat * colors, unsigned int vertexCount,
+	glm::vec3 constantColor,
+	const unsigned int * indices, unsigned int indexCount
+){
+	std::vector<MeshVertex> interleaved(vertexCount);
+	for ( unsigned int i=0; i<vertexCount; i++ ){
+		interleaved[i].position = glm::vec3(positions[3*i+0], positions[3*i+1], positions[3*i+2]);
+		if ( colors != NULL )
+			interleaved[i].color = glm::vec3(colors[3*i+0], colors[3*i+1], colors[3*i+2]);
+		else
+			interleaved[i].color = constantColor;
+	}
+	return addMesh(registry, mode, vertexCount ? &interleaved[0] : NULL, vertexCount, indices, indexCount);
+}
+
+void uploadMeshRegistry(MeshRegistry & registry, bool quantize){
+
+	// All the meshes share the attribute setup...
+	if ( quantize )
+		initVertexFormat(registry.format, VERTEX_UNORM16, VERTEX_ABSENT, VERTEX_ABSENT, VERTEX_RGBA8);
+	else
+		initVertexFormat(registry.format, VERTEX_FLOAT, VERTEX_ABSENT, VERTEX_ABSENT, VERTEX_FLOAT);
+
+	size_t vertexCount = registry.vertices.size();
+	std::vector<glm::vec3> positions(vertexCount), colors(vertexCount);
+	for ( size_t i=0; i<vertexCount; i++ ){
+		positions[i] = registry.vertices[i].position;
+		colors[i]    = registry.vertices[i].color;
+	}
+
+	// ... but not the quantization box : a small mesh next to a big one keeps all its precision
+	std::vector<unsigned char> packed(vertexCount * registry.format.stride);
+	for ( size_t m=0; m<registry.meshes.size(); m++ ){
+		MeshRange & range = registry.meshes[m];
+		size_t first = (size_t)range.baseVertex;
+		size_t last = m + 1 < registry.meshes.size() ? (size_t)registry.meshes[m + 1].baseVertex : vertexCount;
+		VertexFormat meshFormat = registry.format;
+		if ( quantize )
+			initVertexFormat(meshFormat, VERTEX_UNORM16, VERTEX_ABSENT, VERTEX_ABSENT, VERTEX_RGBA8, range.boxMin, range.boxMax);
+		range.dequantize = getDequantizeMatrix(meshFormat);
+		if ( last > first )
+			packVertices(meshFormat, last - first, &positions[first], NULL, NULL, &colors[first], &packed[first * registry.format.stride]);
+	}
+	if ( quantize )
+		reportVertexFormat("Mesh registry", registry.format, vertexCount);
+
+	glGenVertexArrays(1, &registry.vertexArrayID);
+	glBindVertexArray(registry.vertexArrayID);
+
+	glGenBuffers(1, &registry.vertexBufferID);
+	glBindBuffer(GL_ARRAY_BUFFER, registry.vertexBufferID);
+	glBufferData(GL_ARRAY_BUFFER, packed.size(), &packed[0], GL_STATIC_DRAW);
+
+	// The element buffer binding is part of the VAO state
+	glGenBuffers(1, &registry.elementBufferID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, registry.elementBufferID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, registry.indices.size() * sizeof(unsigned int), &registry.indices[0], GL_STATIC_DRAW);
+
+	// Must match the layout in the shader : location 0 = position, location 1 = color
+	const GLint locations[VERTEX_ATTRIBUTE_COUNT] = { 0, -1, -1, 1 };
+	setVertexAttribPointers(registry.format, locations);
+
+	glBindVertexArray(0);
+}
+
+void bindMeshRegistry(const MeshRegistry & registry){
+	glBindVertexArray(registry.vertexArrayID);
+}
+
+void drawMesh(const MeshRegistry & registry, unsigned int mesh){
+	const MeshRange & range = registry.meshes[mesh];
+	glDrawElementsBaseVertex(
+		range.mode,
+		range.indexCount,
+		GL_UNSIGNED_INT,
+		(void*)(range.firstIndex * sizeof(unsigned int)),
+		range.baseVertex
+	);
+}
+
+void drawMeshInstanced(const MeshRegistry & registry, unsigned int mesh, GLsizei instanceCount){
+	const MeshRange & range = registry.meshes[mesh];
+	glDrawElementsInstancedBaseVertex(
+		range.mode,
+		range.indexCount,
+		GL_UNSIGNED_INT,
+		(void*)(range.firstIndex * sizeof(unsigned int)),
+		instanceCount,
+		range.baseVertex
+	);
+}
+
+void cleanupMeshRegistry(MeshRegistry & registry){
+	glDeleteBuffers(1, &registry.vertexBufferID);
+	glDeleteBuffers(1, &registry.elementBufferID);
+	glDeleteVertexArrays(1, &registry.vertexArrayID);
+	initMeshRegistry(registry);
+}
+
+void initInstanceBuffer(InstanceBuffer & buffer, unsigned int capacity){
+	buffer.capacity = capacity;
+	glGenBuffers(1, &buffer.bufferID);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.bufferID);
+	// Initialize with empty (NULL) buffer : it will be updated later, each frame.
+	glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+}
+
+void streamInstances(InstanceBuffer & buffer, const glm::mat4 * models, unsigned int count){
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.bufferID);
+	// Buffer orphaning, a common way to improve streaming perf : the driver gives us a new
+	// storage instead of waiting for the draws of the previous frame to finish.
+	glBufferData(GL_ARRAY_BUFFER, buffer.capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+	if ( count > 0 )
+		glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), models);
+}
+
+void bindInstanceBuffer(const InstanceBuffer & buffer, unsigned int firstInstance){
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.bufferID);
+	for ( int column=0; column<4; column++ ){
+		GLuint attribute = 2 + column;
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribPointer(
+			attribute,
+			4,                                   // one column of the matrix
+			GL_FLOAT,
+			GL_FALSE,
+			sizeof(glm::mat4),
+			(void*)(firstInstance * sizeof(glm::mat4) + column * sizeof(glm::vec4))
+		);
+		glVertexAttribDivisor(attribute, 1); // one matrix per instance, not per vertex
+	}
+}
+
+void cleanupInstanceBuffer(InstanceBuffer & buffer){
+	glDeleteBuffers(1, &buffer.bufferID);
+	buffer.bufferID = 0;
+	buffer.capacity = 0;
+}
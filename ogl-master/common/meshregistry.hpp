@@ -0,0 +1,94 @@
+#ifndef MESHREGISTRY_HPP
+#define MESHREGISTRY_HPP
+
+// One vertex of the interleaved position + color format used by the colored tutorials.
+// Matches the layout of TransformVertexShader : location 0 = position, location 1 = color.
+struct MeshVertex {
+	glm::vec3 position;
+	glm::vec3 color;
+};
+
+// Where a registered mesh lives inside the shared buffers.
+// Drawn with glDrawElementsBaseVertex(mode, indexCount, GL_UNSIGNED_INT, firstIndex, baseVertex).
+struct MeshRange {
+	GLenum  mode;        // GL_TRIANGLES, GL_TRIANGLE_FAN, GL_LINES, ...
+	GLint   baseVertex;  // Added to every index of the mesh
+	GLuint  firstIndex;  // Offset of the first index, in indices (not bytes)
+	GLsizei indexCount;
+	glm::vec3 boxMin;    // Bounding box of the vertices, in model space
+	glm::vec3 boxMax;
+	glm::mat4 dequantize; // From the stored positions to model space (see uploadMeshRegistry)
+};
+
+// All the meshes that share a vertex format, packed in one vertex buffer and one index buffer
+// behind a single VAO. Create one registry per vertex format.
+struct MeshRegistry {
+	std::vector<MeshVertex>   vertices;
+	std::vector<unsigned int> indices;
+	std::vector<MeshRange>    meshes;
+
+	GLuint vertexArrayID;
+	GLuint vertexBufferID;
+	GLuint elementBufferID;
+
+	// How the vertices are stored in the vertex buffer (see vertexformat.hpp). Quantized, each
+	// mesh has its own box : MeshRange::dequantize brings its positions back to model space.
+	VertexFormat format;
+};
+
+void initMeshRegistry(MeshRegistry & registry);
+
+// Adds a mesh and returns its handle. If indices is NULL, the vertices are a triangle soup
+// (or line list, or fan...) : identical vertices are welded and an index list is generated.
+unsigned int addMesh(
+	MeshRegistry & registry,
+	GLenum mode,
+	const MeshVertex * vertices, unsigned int vertexCount,
+	const unsigned int * indices = NULL, unsigned int indexCount = 0
+);
+
+// Same as above, from the separate position/color float arrays the tutorials are written with.
+// If colors is NULL, every vertex gets constantColor.
+unsigned int addMesh(
+	MeshRegistry & registry,
+	GLenum mode,
+	const GLfloat * positions, const GLfloat * colors, unsigned int vertexCount,
+	glm::vec3 constantColor = glm::vec3(1.0f),
+	const unsigned int * indices = NULL, unsigned int indexCount = 0
+);
+
+// Creates the VAO, VBO and IBO. Call once, after all the meshes are added.
+// quantize : 16-bit positions, each mesh in its own bounding box, and RGBA8 colors, 12 bytes per
+// vertex instead of 24. The shaders must then apply the dequantize matrix of the mesh they draw :
+// Model * meshes[mesh].dequantize * position. Identity without quantize.
+void uploadMeshRegistry(MeshRegistry & registry, bool quantize = false);
+
+// Binds the VAO : do it once, then draw as many meshes as needed.
+void bindMeshRegistry(const MeshRegistry & registry);
+void drawMesh(const MeshRegistry & registry, unsigned int mesh);
+
+// Instanced version : the per-instance attributes must have been set with bindInstanceBuffer
+void drawMeshInstanced(const MeshRegistry & registry, unsigned int mesh, GLsizei instanceCount);
+
+void cleanupMeshRegistry(MeshRegistry & registry);
+
+
+// A buffer of per-instance model matrices, re-filled every frame (see tutorial 18, particles).
+// The matrix is fed to attributes 2,3,4,5 (a mat4 takes 4 attribute slots).
+struct InstanceBuffer {
+	GLuint bufferID;
+	unsigned int capacity; // in instances
+};
+
+void initInstanceBuffer(InstanceBuffer & buffer, unsigned int capacity);
+
+// Orphans the buffer and uploads the new matrices. count must not exceed the capacity.
+void streamInstances(InstanceBuffer & buffer, const glm::mat4 * models, unsigned int count);
+
+// Points the instance attributes of the currently bound registry VAO at the matrices
+// starting at firstInstance. Several instance lists can share one buffer this way.
+void bindInstanceBuffer(const InstanceBuffer & buffer, unsigned int firstInstance);
+
+void cleanupInstanceBuffer(InstanceBuffer & buffer);
+
+#endif
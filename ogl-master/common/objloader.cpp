@@ -1,112 +1,463 @@
 #include <vector>
 #include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
 #include <string>
 #include <cstring>
 
 #include <glm/glm.hpp>
 
+#include "mappedfile.hpp"
+#include "jobsystem.hpp"
 #include "objloader.hpp"
 
-// Very, VERY simple OBJ loader.
+// Simple OBJ loader.
 // Here is a short list of features a real function would provide : 
 // - Binary files. Reading a model should be just a few memcpy's away, not parsing a file at runtime. In short : OBJ is not very great.
+//   (see meshcache.hpp for that)
 // - Animations & bones (includes bones weights)
 // - Multiple UVs
-// - All attributes should be optional, not "forced"
-// - More stable. Change a line in the OBJ file and it crashes.
-// - More secure. Change another line and you can inject code.
+// - Materials, groups, smoothing groups
 // - Loading from memory, stream, etc
+//
+// The file is mapped in memory and read twice : once to count the vertices, UVs, normals and
+// triangles so that every array is allocated once, once to parse them.
+// With a job system, both passes run on pieces of the file in parallel, and give exactly the
+// same arrays as the serial loader.
+
+// What a range of the file contains
+struct ObjCounts {
+	size_t positions;
+	size_t uvs;
+	size_t normals;
+	size_t triangles;
+};
+
+// Skips spaces and tabs, not line ends
+static inline const char * skipBlanks(const char * p, const char * end){
+	while ( p < end && (*p == ' ' || *p == '\t') )
+		p++;
+	return p;
+}
+
+static inline const char * skipToken(const char * p, const char * end){
+	while ( p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' )
+		p++;
+	return p;
+}
+
+static inline const char * nextLine(const char * p, const char * end){
+	const char * newline = (const char *)memchr(p, '\n', end - p);
+	return newline ? newline + 1 : end;
+}
+
+// Kind of line : "v ", "vt", "vn", "f ", or something we don't read (comments, groups, materials...)
+enum ObjLine { OBJ_OTHER, OBJ_POSITION, OBJ_UV, OBJ_NORMAL, OBJ_FACE };
+
+static inline ObjLine lineType(const char * & p, const char * end){
+	p = skipBlanks(p, end);
+	if ( end - p < 2 )
+		return OBJ_OTHER;
+	if ( p[0] == 'v' ){
+		if ( p[1] == ' ' || p[1] == '\t' )                               { p += 2; return OBJ_POSITION; }
+		if ( end - p > 2 && p[1] == 't' && (p[2] == ' ' || p[2] == '\t') ) { p += 3; return OBJ_UV; }
+		if ( end - p > 2 && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t') ) { p += 3; return OBJ_NORMAL; }
+	}else if ( p[0] == 'f' && (p[1] == ' ' || p[1] == '\t') ){
+		p += 2;
+		return OBJ_FACE;
+	}
+	return OBJ_OTHER;
+}
+
+// Number of corners of the face starting at p
+static inline size_t countCorners(const char * p, const char * end){
+	size_t corners = 0;
+	for ( ;; ){
+		p = skipBlanks(p, end);
+		if ( p == end || *p == '\n' || *p == '\r' )
+			return corners;
+		p = skipToken(p, end);
+		corners++;
+	}
+}
+
+static void countObj(const char * p, const char * end, ObjCounts & counts){
+	counts.positions = counts.uvs = counts.normals = counts.triangles = 0;
+	while ( p < end ){
+		switch ( lineType(p, end) ){
+		case OBJ_POSITION : counts.positions++; break;
+		case OBJ_UV       : counts.uvs++; break;
+		case OBJ_NORMAL   : counts.normals++; break;
+		case OBJ_FACE     : {
+			size_t corners = countCorners(p, end);
+			if ( corners >= 3 )
+				counts.triangles += corners - 2; // Polygons become fans of triangles
+			break;
+		}
+		default : break;
+		}
+		p = nextLine(p, end);
+	}
+}
+
+// strtod needs a terminating 0, which the mapped file doesn't have
+static bool parseFloatSlow(const char * start, const char * last, float & value){
+	char buffer[64];
+	size_t length = last - start < 63 ? last - start : 63;
+	memcpy(buffer, start, length);
+	buffer[length] = 0;
+	char * parsed;
+	value = (float)strtod(buffer, &parsed);
+	return parsed != buffer;
+}
+
+// Much faster than strtof/scanf : no locale, no errno. The common case (up to 15 significant
+// digits, small exponents) only does exact double operations; anything else goes through strtod.
+static inline bool parseFloat(const char * & p, const char * end, float & value){
+	static const double powersOf10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	p = skipBlanks(p, end);
+	const char * start = p;
+	bool negative = false;
+	if ( p < end && (*p == '-' || *p == '+') )
+		negative = *p++ == '-';
+
+	unsigned long long mantissa = 0;
+	int digits = 0, exponent = 0;
+	bool any = false;
+	for ( ; p < end && *p >= '0' && *p <= '9'; p++, any = true ){
+		if ( digits < 19 ){ mantissa = mantissa * 10 + (*p - '0'); if ( mantissa ) digits++; }
+		else exponent++;
+	}
+	if ( p < end && *p == '.' ){
+		for ( p++; p < end && *p >= '0' && *p <= '9'; p++, any = true ){
+			if ( digits < 19 ){ mantissa = mantissa * 10 + (*p - '0'); exponent--; if ( mantissa ) digits++; }
+		}
+	}
+	if ( !any ){
+		// inf, nan, or garbage : let the C library decide
+		p = skipToken(start, end);
+		return parseFloatSlow(start, p, value);
+	}
+	if ( p < end && (*p == 'e' || *p == 'E') ){
+		const char * e = p + 1;
+		bool negativeExponent = false;
+		if ( e < end && (*e == '-' || *e == '+') )
+			negativeExponent = *e++ == '-';
+		if ( e < end && *e >= '0' && *e <= '9' ){
+			int power = 0;
+			for ( ; e < end && *e >= '0' && *e <= '9'; e++ )
+				power = power < 10000 ? power * 10 + (*e - '0') : power;
+			exponent += negativeExponent ? -power : power;
+			p = e;
+		}
+	}
+
+	// Both the mantissa and the power of 10 are exact doubles : one rounding only
+	if ( mantissa >= (1ULL << 53) || exponent < -22 || exponent > 22 )
+		return parseFloatSlow(start, p, value);
+
+	double result = (double)mantissa;
+	if ( exponent < 0 ){
+		result /= powersOf10[-exponent];
+	}else{
+		result *= powersOf10[exponent];
+	}
+	value = (float)(negative ? -result : result);
+	return true;
+}
+
+static inline bool parseInt(const char * & p, const char * end, long long & value){
+	bool negative = false;
+	if ( p < end && (*p == '-' || *p == '+') )
+		negative = *p++ == '-';
+	if ( p == end || *p < '0' || *p > '9' )
+		return false;
+	long long result = 0;
+	for ( ; p < end && *p >= '0' && *p <= '9'; p++ )
+		result = result < 1000000000000LL ? result * 10 + (*p - '0') : result;
+	value = negative ? -result : result;
+	return true;
+}
+
+// OBJ indices start at 1; negative ones count back from the last element read so far.
+// Returns a 0-based index. Out of range indices are caught later : anything that doesn't fit
+// in an int becomes INT_MIN, which is never valid (-1 means "not given").
+static inline int resolveIndex(long long index, size_t countSoFar){
+	long long resolved = index > 0 ? index - 1 : (long long)countSoFar + index;
+	return resolved < 0 || resolved > INT_MAX ? INT_MIN : (int)resolved;
+}
+
+// One corner of a face : v, v/vt, v//vn or v/vt/vn. vt and vn are -1 when not given.
+static inline bool parseCorner(const char * & p, const char * end, const ObjCounts & read, int corner[3]){
+	long long index;
+	corner[1] = corner[2] = -1;
+	if ( !parseInt(p, end, index) || index == 0 )
+		return false;
+	corner[0] = resolveIndex(index, read.positions);
+	if ( p < end && *p == '/' ){
+		p++;
+		if ( p < end && *p != '/' ){
+			if ( !parseInt(p, end, index) || index == 0 )
+				return false;
+			corner[1] = resolveIndex(index, read.uvs);
+		}
+		if ( p < end && *p == '/' ){
+			p++;
+			if ( !parseInt(p, end, index) || index == 0 )
+				return false;
+			corner[2] = resolveIndex(index, read.normals);
+		}
+	}
+	return p == end || *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r';
+}
+
+// Parses [p, end) into arrays that countObj sized. base tells how many elements come before
+// this range in the file (all 0 for a whole file), so that relative indices resolve globally.
+// corners gets 3 indices per triangle corner : position, uv, normal.
+static bool parseObj(
+	const char * p, const char * end, const ObjCounts & base,
+	glm::vec3 * positions, glm::vec2 * uvs, glm::vec3 * normals, int * corners
+){
+	ObjCounts read = base;
+	int * corner = corners;
+	while ( p < end ){
+		const char * line = p;
+		bool ok = true;
+		switch ( lineType(p, end) ){
+		case OBJ_POSITION : {
+			glm::vec3 & vertex = positions[read.positions++ - base.positions];
+			ok = parseFloat(p, end, vertex.x) && parseFloat(p, end, vertex.y) && parseFloat(p, end, vertex.z);
+			break;
+		}
+		case OBJ_UV : {
+			glm::vec2 & uv = uvs[read.uvs++ - base.uvs];
+			ok = parseFloat(p, end, uv.x) && parseFloat(p, end, uv.y);
+			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
+			break;
+		}
+		case OBJ_NORMAL : {
+			glm::vec3 & normal = normals[read.normals++ - base.normals];
+			ok = parseFloat(p, end, normal.x) && parseFloat(p, end, normal.y) && parseFloat(p, end, normal.z);
+			break;
+		}
+		case OBJ_FACE : {
+			size_t count = countCorners(p, end);
+			if ( count < 3 )
+				break; // Points and lines : not triangles, skipped
+			int first[3], previous[3], current[3];
+			for ( size_t c=0; c<count && ok; c++ ){
+				p = skipBlanks(p, end);
+				ok = parseCorner(p, end, read, current);
+				if ( c == 0 )
+					memcpy(first, current, sizeof(first));
+				if ( c >= 2 ){
+					// Fan : (first, previous, current)
+					memcpy(corner    , first   , sizeof(first));
+					memcpy(corner + 3, previous, sizeof(first));
+					memcpy(corner + 6, current , sizeof(first));
+					corner += 9;
+				}
+				memcpy(previous, current, sizeof(previous));
+			}
+			break;
+		}
+		default : break;
+		}
+		if ( !ok ){
+			const char * lineEnd = nextLine(line, end);
+			printf("Can't read this OBJ line : %.*s\n", (int)(lineEnd - line > 80 ? 80 : lineEnd - line), line);
+			return false;
+		}
+		p = nextLine(p, end);
+	}
+	return true;
+}
+
+// Writes the attributes of triangles [first, last) to the outputs, which are already sized.
+// Corners without a normal get the normal of their triangle; without UV, (0,0).
+static bool expandTriangles(
+	const int * corners, size_t first, size_t last, const ObjCounts & counts,
+	const glm::vec3 * positions, const glm::vec2 * uvs, const glm::vec3 * normals,
+	glm::vec3 * out_vertices, glm::vec2 * out_uvs, glm::vec3 * out_normals
+){
+	for ( size_t t=first; t<last; t++ ){
+		const int * triangle = corners + 9 * t;
+		for ( int c=0; c<3; c++ ){
+			const int * corner = triangle + 3 * c;
+			if ( corner[0] < 0 || corner[0] >= (long long)counts.positions
+			  || corner[1] < -1 || corner[1] >= (long long)counts.uvs
+			  || corner[2] < -1 || corner[2] >= (long long)counts.normals ){
+				printf("OBJ face %u refers to a vertex, UV or normal that doesn't exist\n", (unsigned int)t);
+				return false;
+			}
+			out_vertices[3*t + c] = positions[corner[0]];
+			out_uvs     [3*t + c] = corner[1] >= 0 ? uvs[corner[1]] : glm::vec2(0.0f);
+		}
+		for ( int c=0; c<3; c++ ){
+			const int * corner = triangle + 3 * c;
+			if ( corner[2] >= 0 ){
+				out_normals[3*t + c] = normals[corner[2]];
+			}else{
+				glm::vec3 faceNormal = glm::cross(out_vertices[3*t+1] - out_vertices[3*t], out_vertices[3*t+2] - out_vertices[3*t]);
+				float length = glm::length(faceNormal);
+				out_normals[3*t + c] = length > 0.0f ? faceNormal / length : glm::vec3(0.0f);
+			}
+		}
+	}
+	return true;
+}
+
+// The parallel loader cuts the file into pieces of about this size, at line boundaries...
+#define OBJ_PARSE_CHUNK  (4 << 20)
+// ...and expands the triangles by groups of this many
+#define OBJ_EXPAND_CHUNK 65536
+
+// A piece of the file, and how many elements come before it
+struct ObjChunk {
+	const char * begin;
+	const char * end;
+	ObjCounts counts;
+	ObjCounts base;
+	bool ok;
+};
+
+// Everything the jobs of one load share
+struct ObjLoad {
+	std::vector<ObjChunk> chunks;
+	ObjCounts counts; // Whole file
+	glm::vec3 * positions;
+	glm::vec2 * uvs;
+	glm::vec3 * normals;
+	int * corners;
+	glm::vec3 * out_vertices;
+	glm::vec2 * out_uvs;
+	glm::vec3 * out_normals;
+	std::vector<char> expanded; // One flag per group of OBJ_EXPAND_CHUNK triangles
+};
+
+static void countObjChunks(void * data, unsigned int first, unsigned int last){
+	ObjLoad * load = (ObjLoad*)data;
+	for ( unsigned int i=first; i<last; i++ )
+		countObj(load->chunks[i].begin, load->chunks[i].end, load->chunks[i].counts);
+}
+
+// Each chunk writes straight to its own part of the arrays : no merging afterwards
+static void parseObjChunks(void * data, unsigned int first, unsigned int last){
+	ObjLoad * load = (ObjLoad*)data;
+	for ( unsigned int i=first; i<last; i++ ){
+		ObjChunk & chunk = load->chunks[i];
+		chunk.ok = parseObj(chunk.begin, chunk.end, chunk.base,
+			load->positions + chunk.base.positions,
+			load->uvs       + chunk.base.uvs,
+			load->normals   + chunk.base.normals,
+			load->corners   + chunk.base.triangles * 9);
+	}
+}
+
+static void expandObjChunk(void * data, unsigned int first, unsigned int last){
+	ObjLoad * load = (ObjLoad*)data;
+	load->expanded[first / OBJ_EXPAND_CHUNK] = expandTriangles(load->corners, first, last, load->counts,
+		load->positions, load->uvs, load->normals,
+		load->out_vertices, load->out_uvs, load->out_normals);
+}
+
+// Without a job system, a single job does all the work on this thread
+static void runObjJobs(JobSystem * jobs, unsigned int count, unsigned int chunkSize, JobFunction function, void * data){
+	if ( jobs != NULL )
+		parallelFor(jobs, count, chunkSize, function, data);
+	else if ( count > 0 )
+		function(data, 0, count);
+}
 
 bool loadOBJ(
 	const char * path, 
 	std::vector<glm::vec3> & out_vertices, 
 	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
+	std::vector<glm::vec3> & out_normals,
+	JobSystem * jobs
 ){
 	printf("Loading OBJ file %s...\n", path);
 
-	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices; 
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
-
-
-	FILE * file = fopen(path, "r");
-	if( file == NULL ){
+	MappedFile file;
+	if ( !openMappedFile(file, path) ){
 		printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
-		getchar();
 		return false;
 	}
+	const char * begin = (const char *)file.data;
+	const char * end = begin + file.size;
 
-	while( 1 ){
-
-		char lineHeader[128];
-		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
+	// Cut the file at line starts. The serial loader keeps it in one piece.
+	ObjLoad load;
+	for ( const char * p = begin; p < end; ){
+		ObjChunk chunk;
+		chunk.begin = p;
+		chunk.end = jobs != NULL && end - p > OBJ_PARSE_CHUNK ? nextLine(p + OBJ_PARSE_CHUNK - 1, end) : end;
+		chunk.ok = false;
+		load.chunks.push_back(chunk);
+		p = chunk.end;
+	}
+	unsigned int chunkCount = (unsigned int)load.chunks.size();
 
-		// else : parse lineHeader
-		
-		if ( strcmp( lineHeader, "v" ) == 0 ){
-			glm::vec3 vertex;
-			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z );
-			temp_vertices.push_back(vertex);
-		}else if ( strcmp( lineHeader, "vt" ) == 0 ){
-			glm::vec2 uv;
-			fscanf(file, "%f %f\n", &uv.x, &uv.y );
-			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
-			temp_uvs.push_back(uv);
-		}else if ( strcmp( lineHeader, "vn" ) == 0 ){
-			glm::vec3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z );
-			temp_normals.push_back(normal);
-		}else if ( strcmp( lineHeader, "f" ) == 0 ){
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2] );
-			if (matches != 9){
-				printf("File can't be read by our simple parser :-( Try exporting with other options\n");
-				fclose(file);
-				return false;
-			}
-			vertexIndices.push_back(vertexIndex[0]);
-			vertexIndices.push_back(vertexIndex[1]);
-			vertexIndices.push_back(vertexIndex[2]);
-			uvIndices    .push_back(uvIndex[0]);
-			uvIndices    .push_back(uvIndex[1]);
-			uvIndices    .push_back(uvIndex[2]);
-			normalIndices.push_back(normalIndex[0]);
-			normalIndices.push_back(normalIndex[1]);
-			normalIndices.push_back(normalIndex[2]);
-		}else{
-			// Probably a comment, eat up the rest of the line
-			char stupidBuffer[1000];
-			fgets(stupidBuffer, 1000, file);
-		}
+	// First pass : how much of everything, in each chunk
+	runObjJobs(jobs, chunkCount, 1, countObjChunks, &load);
 
+	// A chunk's elements come after those of all the chunks before it. This is also what makes
+	// relative (negative) indices resolve like in a single pass over the whole file.
+	ObjCounts total = { 0, 0, 0, 0 };
+	for ( unsigned int i=0; i<chunkCount; i++ ){
+		ObjChunk & chunk = load.chunks[i];
+		chunk.base = total;
+		total.positions += chunk.counts.positions;
+		total.uvs       += chunk.counts.uvs;
+		total.normals   += chunk.counts.normals;
+		total.triangles += chunk.counts.triangles;
 	}
+	load.counts = total;
 
-	// For each vertex of each triangle
-	for( unsigned int i=0; i<vertexIndices.size(); i++ ){
-
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
-		
-		// Get the attributes thanks to the index
-		glm::vec3 vertex = temp_vertices[ vertexIndex-1 ];
-		glm::vec2 uv = temp_uvs[ uvIndex-1 ];
-		glm::vec3 normal = temp_normals[ normalIndex-1 ];
-		
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs     .push_back(uv);
-		out_normals .push_back(normal);
-	
+	// Second pass : straight into arrays of the right size
+	std::vector<glm::vec3> temp_vertices(total.positions);
+	std::vector<glm::vec2> temp_uvs(total.uvs);
+	std::vector<glm::vec3> temp_normals(total.normals);
+	std::vector<int> corners(total.triangles * 9);
+	load.positions = temp_vertices.empty() ? NULL : &temp_vertices[0];
+	load.uvs       = temp_uvs.empty()      ? NULL : &temp_uvs[0];
+	load.normals   = temp_normals.empty()  ? NULL : &temp_normals[0];
+	load.corners   = corners.empty()       ? NULL : &corners[0];
+	runObjJobs(jobs, chunkCount, 1, parseObjChunks, &load);
+	closeMappedFile(file);
+	for ( unsigned int i=0; i<chunkCount; i++ )
+		if ( !load.chunks[i].ok )
+			return false;
+
+	// For each vertex of each triangle, its attributes
+	size_t first = out_vertices.size();
+	out_vertices.resize(first + total.triangles * 3);
+	out_uvs     .resize(first + total.triangles * 3);
+	out_normals .resize(first + total.triangles * 3);
+	if ( total.triangles == 0 )
+		return true;
+	if ( total.triangles > UINT_MAX ){
+		printf("%s has too many triangles\n", path);
+		return false;
+	}
+	load.out_vertices = &out_vertices[first];
+	load.out_uvs      = &out_uvs[first];
+	load.out_normals  = &out_normals[first];
+	unsigned int triangleCount = (unsigned int)total.triangles;
+	if ( jobs != NULL ){
+		load.expanded.assign((triangleCount + OBJ_EXPAND_CHUNK - 1) / OBJ_EXPAND_CHUNK, 0);
+		parallelFor(jobs, triangleCount, OBJ_EXPAND_CHUNK, expandObjChunk, &load);
+	}else{
+		// One job covering everything : its flag is expanded[0]
+		load.expanded.assign(1, 0);
+		expandObjChunk(&load, 0, triangleCount);
 	}
-	fclose(file);
+	for ( size_t i=0; i<load.expanded.size(); i++ )
+		if ( !load.expanded[i] )
+			return false;
 	return true;
 }
 
@@ -1,11 +1,17 @@
 #ifndef OBJLOADER_H
 #define OBJLOADER_H
 
+struct JobSystem;
+
+// Appends one vertex, UV and normal per triangle corner to the outputs.
+// With a job system (see jobsystem.hpp), the file is parsed on all its workers; the result is
+// exactly the same as without.
 bool loadOBJ(
 	const char * path, 
 	std::vector<glm::vec3> & out_vertices, 
 	std::vector<glm::vec2> & out_uvs, 
-	std::vector<glm::vec3> & out_normals
+	std::vector<glm::vec3> & out_normals,
+	JobSystem * jobs = NULL
 );
 
 
@@ -0,0 +1,173 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string.h>
+
+#include "rocketsystem.hpp"
+#include "jobsystem.hpp"
+#include "rocketfleet.hpp"
+
+// Each job updates this many rockets. A multiple of the SIMD width, and large enough
+// for the job overhead to disappear.
+#define ROCKET_FLEET_CHUNK (4096 * ROCKET_SYSTEM_WIDTH)
+
+struct RocketFleet {
+	RocketSystem system;
+	JobSystem * jobs;
+	std::thread thread;
+
+	// Shared with the main thread, protected by mutex
+	std::mutex mutex;
+	std::condition_variable wake;       // Something to simulate, or quit
+	std::condition_variable published;  // A snapshot was published, or released
+	unsigned long long targetTick;
+	unsigned long long tick;            // Next tick to simulate
+	bool launchRequested;
+	float launchGauge;
+	unsigned long long launchTick;
+	bool quit;
+
+	// Only touched by the simulation thread
+	float activeLaunchGauge;
+
+	RocketSnapshot snapshots[2];
+	int front;                          // The one the renderer may read
+	bool reading;                       // The renderer holds the front snapshot
+};
+
+static void updateRocketChunk(void * data, unsigned int first, unsigned int last){
+	RocketSystem * system = (RocketSystem*)data;
+	updateRocketSystem(*system, first, last);
+}
+
+static void launchRocketChunk(void * data, unsigned int first, unsigned int last){
+	RocketFleet * fleet = (RocketFleet*)data;
+	for (unsigned int i = first; i < last; i++)
+		launchRocket(fleet->system, i, fleet->activeLaunchGauge * (0.75f + 0.5f * ((i * 37) % 100) / 100.0f));
+}
+
+static void copySnapshotChunk(void * data, unsigned int first, unsigned int last){
+	RocketFleet * fleet = (RocketFleet*)data;
+	RocketSnapshot & back = fleet->snapshots[1 - fleet->front];
+	unsigned int count = last - first;
+	memcpy(&back.height[first],   &fleet->system.height[first],   count * sizeof(float));
+	memcpy(&back.rotation[first], &fleet->system.rotation[first], count * sizeof(float));
+	memcpy(&back.chute[first],    &fleet->system.chute[first],    count * sizeof(int));
+}
+
+static void simulationLoop(RocketFleet * fleet){
+	std::unique_lock<std::mutex> lock(fleet->mutex);
+	while (true) {
+		fleet->wake.wait(lock, [fleet]{ return fleet->quit || fleet->tick < fleet->targetTick; });
+		if (fleet->quit)
+			return;
+
+		unsigned long long targetTick = fleet->targetTick;
+		bool launch = fleet->launchRequested;
+		unsigned long long launchTick = fleet->launchTick;
+		fleet->activeLaunchGauge = fleet->launchGauge;
+		fleet->launchRequested = false;
+		unsigned long long tick = fleet->tick;
+		lock.unlock();
+
+		// The same ticks, in the same order, whatever the number of workers : the result is deterministic
+		for (; tick < targetTick; tick++) {
+			if (launch && tick >= launchTick) {
+				parallelFor(fleet->jobs, fleet->system.count, ROCKET_FLEET_CHUNK, launchRocketChunk, fleet);
+				launch = false;
+			}
+			parallelFor(fleet->jobs, fleet->system.count, ROCKET_FLEET_CHUNK, updateRocketChunk, &fleet->system);
+		}
+
+		// Fill the back snapshot, once the renderer is done with it
+		lock.lock();
+		int back = 1 - fleet->front;
+		fleet->published.wait(lock, [fleet]{ return !fleet->reading || fleet->quit; });
+		lock.unlock();
+
+		parallelFor(fleet->jobs, fleet->system.count, ROCKET_FLEET_CHUNK, copySnapshotChunk, fleet);
+		fleet->snapshots[back].tick = tick;
+
+		lock.lock();
+		fleet->front = back;
+		fleet->tick = tick;
+		if (launch && !fleet->launchRequested) {
+			// Not reached yet, or asked for a tick we had already simulated : keep it for later
+			fleet->launchRequested = true;
+			fleet->launchTick = launchTick > tick ? launchTick : tick;
+		}
+		fleet->published.notify_all();
+	}
+}
+
+RocketFleet * createRocketFleet(unsigned int rocketCount, unsigned int workerCount){
+	RocketFleet * fleet = new RocketFleet;
+	initRocketSystem(fleet->system, rocketCount);
+	fleet->jobs = createJobSystem(workerCount);
+	fleet->targetTick = 0;
+	fleet->tick = 0;
+	fleet->launchRequested = false;
+	fleet->launchGauge = 0.0f;
+	fleet->launchTick = 0;
+	fleet->quit = false;
+	for (int i = 0; i < 2; i++) {
+		fleet->snapshots[i].tick = 0;
+		fleet->snapshots[i].height  .assign(rocketCount, 0.0f);
+		fleet->snapshots[i].rotation.assign(rocketCount, 0.0f);
+		fleet->snapshots[i].chute   .assign(rocketCount, 0);
+	}
+	fleet->front = 0;
+	fleet->reading = false;
+	fleet->thread = std::thread(simulationLoop, fleet);
+	return fleet;
+}
+
+void destroyRocketFleet(RocketFleet * fleet){
+	{
+		std::lock_guard<std::mutex> lock(fleet->mutex);
+		fleet->quit = true;
+	}
+	fleet->wake.notify_all();
+	fleet->published.notify_all();
+	fleet->thread.join();
+	destroyJobSystem(fleet->jobs);
+	cleanupRocketSystem(fleet->system);
+	delete fleet;
+}
+
+void requestFleetLaunch(RocketFleet * fleet, float gauge, unsigned long long tick){
+	std::lock_guard<std::mutex> lock(fleet->mutex);
+	fleet->launchRequested = true;
+	fleet->launchGauge = gauge;
+	fleet->launchTick = tick;
+}
+
+void advanceRocketFleet(RocketFleet * fleet, unsigned long long tick){
+	{
+		std::lock_guard<std::mutex> lock(fleet->mutex);
+		if (tick <= fleet->targetTick)
+			return;
+		fleet->targetTick = tick;
+	}
+	fleet->wake.notify_one();
+}
+
+const RocketSnapshot * acquireRocketSnapshot(RocketFleet * fleet){
+	std::lock_guard<std::mutex> lock(fleet->mutex);
+	fleet->reading = true;
+	return &fleet->snapshots[fleet->front];
+}
+
+void releaseRocketSnapshot(RocketFleet * fleet){
+	{
+		std::lock_guard<std::mutex> lock(fleet->mutex);
+		fleet->reading = false;
+	}
+	fleet->published.notify_all();
+}
+
+void waitForRocketFleet(RocketFleet * fleet){
+	std::unique_lock<std::mutex> lock(fleet->mutex);
+	fleet->published.wait(lock, [fleet]{ return fleet->tick >= fleet->targetTick; });
+}
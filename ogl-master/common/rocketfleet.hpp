@@ -0,0 +1,34 @@
+#ifndef ROCKETFLEET_HPP
+#define ROCKETFLEET_HPP
+
+// What the renderer needs from the fleet, copied once per simulated batch of ticks.
+struct RocketSnapshot {
+	unsigned long long tick;    // Simulation tick this snapshot was taken at
+	std::vector<float> height;
+	std::vector<float> rotation;
+	std::vector<int>   chute;
+};
+
+// A RocketSystem simulated on its own thread, with the update of each tick split in jobs over all
+// the cores (see jobsystem.hpp). The render thread never touches the simulation state : it only
+// reads the latest of two snapshots, while the simulation writes the other one.
+struct RocketFleet;
+
+// workerCount = 0 : all the cores
+RocketFleet * createRocketFleet(unsigned int rocketCount, unsigned int workerCount = 0);
+void destroyRocketFleet(RocketFleet * fleet);
+
+// Launches every rocket of the fleet at the given tick, with powers spread around gauge
+void requestFleetLaunch(RocketFleet * fleet, float gauge, unsigned long long tick);
+
+// Lets the simulation thread run up to this tick. Does not wait for it.
+void advanceRocketFleet(RocketFleet * fleet, unsigned long long tick);
+
+// The latest complete snapshot. It stays valid until releaseRocketSnapshot.
+const RocketSnapshot * acquireRocketSnapshot(RocketFleet * fleet);
+void releaseRocketSnapshot(RocketFleet * fleet);
+
+// Blocks until every tick asked by advanceRocketFleet is simulated and published. For tests and benchmarks.
+void waitForRocketFleet(RocketFleet * fleet);
+
+#endif
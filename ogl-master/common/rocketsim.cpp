@@ -0,0 +1,93 @@
+#include "rocketsim.hpp"
+
+static const float GRAVITY = 9.8f;
+
+void resetRocket(RocketState & state){
+	state.height = 0.0f;
+	state.gauge = 0.0f;
+	state.ySpeed = 0.0f;
+	state.rotation = 0.0f;
+	state.chute = false;
+	state.launch = false;
+	state.landing = false;
+	state.direction = false;
+	state.press = false;
+}
+
+void stepRocket(RocketState & state, bool spaceHeld){
+
+	// Charge while SPACE is held on the launch pad
+	if (spaceHeld) {
+		if (state.launch == false && state.landing == false) {
+			if (state.gauge < 3) {
+				state.gauge += 0.01f;
+			}
+			state.press = true;
+		}
+	}
+	// Launch when it is released, and put the rocket back on the pad once it has landed
+	if (!spaceHeld && state.press == true) {
+		if (!state.launch) {
+			state.launch = true;
+			state.ySpeed = state.gauge;
+		}
+		if (state.landing) {
+			resetRocket(state);
+		}
+	}
+
+	if (state.launch == true && state.landing == false) {
+		if (state.chute == false) {
+			state.ySpeed -= 0.01f;
+		}
+		if (state.ySpeed < 0) {
+			state.direction = true;
+			state.rotation = 10.0f;
+		}
+		if (state.ySpeed < -2.0) {
+			state.chute = true;
+			state.ySpeed /= 5;
+		}
+		state.height += state.ySpeed / GRAVITY;
+
+		if (state.height < -0.5f) {
+			state.landing = true;
+		}
+	}
+}
+
+unsigned int simulateRocketFlight(RocketState & state, float gauge, unsigned int maxTicks){
+	resetRocket(state);
+	state.gauge = gauge;
+	state.press = true;
+
+	unsigned int ticks = 0;
+	while (ticks < maxTicks && !state.landing) {
+		stepRocket(state, false);
+		ticks++;
+	}
+	return ticks;
+}
+
+void initFixedStepClock(FixedStepClock & clock, int maxSubsteps){
+	clock.accumulator = 0.0;
+	clock.tick = 0;
+	clock.maxSubsteps = maxSubsteps;
+}
+
+int advanceFixedStepClock(FixedStepClock & clock, double frameTime){
+	clock.accumulator += frameTime;
+
+	int substeps = (int)(clock.accumulator / ROCKET_TICK);
+	if (substeps > clock.maxSubsteps) {
+		substeps = clock.maxSubsteps;
+		clock.accumulator = substeps * ROCKET_TICK;
+	}
+	clock.accumulator -= substeps * ROCKET_TICK;
+	clock.tick += substeps;
+	return substeps;
+}
+
+float getFixedStepAlpha(const FixedStepClock & clock){
+	return (float)(clock.accumulator / ROCKET_TICK);
+}
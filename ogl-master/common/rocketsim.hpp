@@ -0,0 +1,47 @@
+#ifndef ROCKETSIM_HPP
+#define ROCKETSIM_HPP
+
+// The simulation runs at a fixed rate, whatever the frame rate is.
+// The per-tick constants below were tuned, one frame at a time, at 60 fps.
+#define ROCKET_TICKS_PER_SECOND 60
+#define ROCKET_TICK (1.0 / ROCKET_TICKS_PER_SECOND)
+
+struct RocketState {
+	float height;
+	float gauge;     // Launch power, charged while SPACE is held
+	float ySpeed;
+	float rotation;
+	bool chute;      // Parachute is open
+	bool launch;     // Launched
+	bool landing;    // Landed
+	bool direction;  // Falling : the rocket is turned
+	bool press;      // SPACE was pressed since the last launch
+};
+
+void resetRocket(RocketState & state);
+
+// Advances the rocket by exactly one tick. spaceHeld is the state of the launch key during that tick.
+void stepRocket(RocketState & state, bool spaceHeld);
+
+// Headless batch mode : flies a launch of the given power, as fast as the CPU allows,
+// until the rocket lands or maxTicks is reached. Returns the number of ticks simulated.
+unsigned int simulateRocketFlight(RocketState & state, float gauge, unsigned int maxTicks);
+
+
+// Accumulates real time and tells how many fixed ticks to run this frame.
+struct FixedStepClock {
+	double accumulator;        // Real time not simulated yet, in seconds
+	unsigned long long tick;   // Number of ticks simulated since the start
+	int maxSubsteps;           // Spiral-of-death guard : after a long hitch, drop the extra time
+};
+
+void initFixedStepClock(FixedStepClock & clock, int maxSubsteps = 8);
+
+// Adds frameTime seconds, returns the number of ticks to simulate now.
+int advanceFixedStepClock(FixedStepClock & clock, double frameTime);
+
+// How far we are between the last simulated tick and the next one, in [0,1) :
+// render with mix(previous, current, alpha).
+float getFixedStepAlpha(const FixedStepClock & clock);
+
+#endif
@@ -0,0 +1,212 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "rocketsystem.hpp"
+
+#if ROCKET_SYSTEM_WIDTH == 8
+#include <immintrin.h>
+#elif ROCKET_SYSTEM_WIDTH == 4
+#include <emmintrin.h>
+#endif
+
+static const float GRAVITY = 9.8f;
+
+// The arrays are aligned on 32 bytes, for aligned SIMD loads and stores
+static void * allocateAligned(size_t size){
+	void * block = malloc(size + 32 + sizeof(void*));
+	if (block == NULL)
+		return NULL;
+	uintptr_t aligned = ((uintptr_t)block + sizeof(void*) + 31) & ~(uintptr_t)31;
+	((void**)aligned)[-1] = block; // Remember the real block, for freeAligned
+	memset((void*)aligned, 0, size);
+	return (void*)aligned;
+}
+
+static void freeAligned(void * pointer){
+	if (pointer != NULL)
+		free(((void**)pointer)[-1]);
+}
+
+void initRocketSystem(RocketSystem & system, unsigned int count){
+	system.count = count;
+	system.capacity = (count + ROCKET_SYSTEM_WIDTH - 1) / ROCKET_SYSTEM_WIDTH * ROCKET_SYSTEM_WIDTH;
+
+	// Everything starts at 0 : on the pad, not launched
+	system.height   = (float*)allocateAligned(system.capacity * sizeof(float));
+	system.ySpeed   = (float*)allocateAligned(system.capacity * sizeof(float));
+	system.rotation = (float*)allocateAligned(system.capacity * sizeof(float));
+	system.launch   = (int*)  allocateAligned(system.capacity * sizeof(int));
+	system.chute    = (int*)  allocateAligned(system.capacity * sizeof(int));
+	system.landing  = (int*)  allocateAligned(system.capacity * sizeof(int));
+}
+
+void cleanupRocketSystem(RocketSystem & system){
+	freeAligned(system.height);
+	freeAligned(system.ySpeed);
+	freeAligned(system.rotation);
+	freeAligned(system.launch);
+	freeAligned(system.chute);
+	freeAligned(system.landing);
+	memset(&system, 0, sizeof(system));
+}
+
+void launchRocket(RocketSystem & system, unsigned int rocket, float gauge){
+	system.height[rocket]   = 0.0f;
+	system.ySpeed[rocket]   = gauge;
+	system.rotation[rocket] = 0.0f;
+	system.launch[rocket]   = -1;
+	system.chute[rocket]    = 0;
+	system.landing[rocket]  = 0;
+}
+
+void updateRocketSystemScalar(RocketSystem & system, unsigned int first, unsigned int last){
+	for (unsigned int i = first; i < last; i++) {
+		if (!system.launch[i] || system.landing[i])
+			continue;
+
+		float ySpeed = system.ySpeed[i];
+		if (!system.chute[i]) {
+			ySpeed -= 0.01f;
+		}
+		if (ySpeed < 0) {
+			system.rotation[i] = 10.0f;
+		}
+		if (ySpeed < -2.0f) {
+			system.chute[i] = -1;
+			ySpeed /= 5;
+		}
+		system.ySpeed[i] = ySpeed;
+		system.height[i] += ySpeed / GRAVITY;
+
+		if (system.height[i] < -0.5f) {
+			system.landing[i] = -1;
+		}
+	}
+}
+
+#if ROCKET_SYSTEM_WIDTH == 8
+
+// AVX : 8 rockets per iteration. Branches become masks : every lane computes everything,
+// and each result is only kept where its condition is true.
+static void updateRocketSystemSIMD(RocketSystem & system, unsigned int first, unsigned int last){
+	const __m256 zero      = _mm256_setzero_ps();
+	const __m256 drag      = _mm256_set1_ps(0.01f);
+	const __m256 turned    = _mm256_set1_ps(10.0f);
+	const __m256 chuteLimit = _mm256_set1_ps(-2.0f);
+	const __m256 five      = _mm256_set1_ps(5.0f);
+	const __m256 gravity   = _mm256_set1_ps(GRAVITY);
+	const __m256 ground    = _mm256_set1_ps(-0.5f);
+
+	for (unsigned int i = first; i < last; i += 8) {
+		__m256 launch  = _mm256_load_ps((const float*)&system.launch[i]);
+		__m256 chute   = _mm256_load_ps((const float*)&system.chute[i]);
+		__m256 landing = _mm256_load_ps((const float*)&system.landing[i]);
+		__m256 active  = _mm256_andnot_ps(landing, launch);
+		if (_mm256_movemask_ps(active) == 0)
+			continue; // Nobody is flying in this group
+
+		__m256 ySpeed   = _mm256_load_ps(&system.ySpeed[i]);
+		__m256 height   = _mm256_load_ps(&system.height[i]);
+		__m256 rotation = _mm256_load_ps(&system.rotation[i]);
+
+		// Gravity, unless the chute is open
+		ySpeed = _mm256_blendv_ps(ySpeed, _mm256_sub_ps(ySpeed, drag), _mm256_andnot_ps(chute, active));
+
+		// Falling : turn the rocket
+		__m256 falling = _mm256_and_ps(active, _mm256_cmp_ps(ySpeed, zero, _CMP_LT_OQ));
+		rotation = _mm256_blendv_ps(rotation, turned, falling);
+
+		// Too fast : open the chute
+		__m256 deploy = _mm256_and_ps(active, _mm256_cmp_ps(ySpeed, chuteLimit, _CMP_LT_OQ));
+		chute  = _mm256_or_ps(chute, deploy);
+		ySpeed = _mm256_blendv_ps(ySpeed, _mm256_div_ps(ySpeed, five), deploy);
+
+		height = _mm256_blendv_ps(height, _mm256_add_ps(height, _mm256_div_ps(ySpeed, gravity)), active);
+
+		// Below the ground : landed
+		landing = _mm256_or_ps(landing, _mm256_and_ps(active, _mm256_cmp_ps(height, ground, _CMP_LT_OQ)));
+
+		_mm256_store_ps(&system.ySpeed[i], ySpeed);
+		_mm256_store_ps(&system.height[i], height);
+		_mm256_store_ps(&system.rotation[i], rotation);
+		_mm256_store_ps((float*)&system.chute[i], chute);
+		_mm256_store_ps((float*)&system.landing[i], landing);
+	}
+}
+
+#elif ROCKET_SYSTEM_WIDTH == 4
+
+// SSE2 has no blend instruction : select(a, b, mask) = (mask & b) | (~mask & a)
+static inline __m128 select(__m128 a, __m128 b, __m128 mask){
+	return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+}
+
+// SSE2 : 4 rockets per iteration. Branches become masks : every lane computes everything,
+// and each result is only kept where its condition is true.
+static void updateRocketSystemSIMD(RocketSystem & system, unsigned int first, unsigned int last){
+	const __m128 zero       = _mm_setzero_ps();
+	const __m128 drag       = _mm_set1_ps(0.01f);
+	const __m128 turned     = _mm_set1_ps(10.0f);
+	const __m128 chuteLimit = _mm_set1_ps(-2.0f);
+	const __m128 five       = _mm_set1_ps(5.0f);
+	const __m128 gravity    = _mm_set1_ps(GRAVITY);
+	const __m128 ground     = _mm_set1_ps(-0.5f);
+
+	for (unsigned int i = first; i < last; i += 4) {
+		__m128 launch  = _mm_load_ps((const float*)&system.launch[i]);
+		__m128 chute   = _mm_load_ps((const float*)&system.chute[i]);
+		__m128 landing = _mm_load_ps((const float*)&system.landing[i]);
+		__m128 active  = _mm_andnot_ps(landing, launch);
+		if (_mm_movemask_ps(active) == 0)
+			continue; // Nobody is flying in this group
+
+		__m128 ySpeed   = _mm_load_ps(&system.ySpeed[i]);
+		__m128 height   = _mm_load_ps(&system.height[i]);
+		__m128 rotation = _mm_load_ps(&system.rotation[i]);
+
+		// Gravity, unless the chute is open
+		ySpeed = select(ySpeed, _mm_sub_ps(ySpeed, drag), _mm_andnot_ps(chute, active));
+
+		// Falling : turn the rocket
+		__m128 falling = _mm_and_ps(active, _mm_cmplt_ps(ySpeed, zero));
+		rotation = select(rotation, turned, falling);
+
+		// Too fast : open the chute
+		__m128 deploy = _mm_and_ps(active, _mm_cmplt_ps(ySpeed, chuteLimit));
+		chute  = _mm_or_ps(chute, deploy);
+		ySpeed = select(ySpeed, _mm_div_ps(ySpeed, five), deploy);
+
+		height = select(height, _mm_add_ps(height, _mm_div_ps(ySpeed, gravity)), active);
+
+		// Below the ground : landed
+		landing = _mm_or_ps(landing, _mm_and_ps(active, _mm_cmplt_ps(height, ground)));
+
+		_mm_store_ps(&system.ySpeed[i], ySpeed);
+		_mm_store_ps(&system.height[i], height);
+		_mm_store_ps(&system.rotation[i], rotation);
+		_mm_store_ps((float*)&system.chute[i], chute);
+		_mm_store_ps((float*)&system.landing[i], landing);
+	}
+}
+
+#else
+
+static void updateRocketSystemSIMD(RocketSystem & system, unsigned int first, unsigned int last){
+	updateRocketSystemScalar(system, first, last);
+}
+
+#endif
+
+void updateRocketSystem(RocketSystem & system, unsigned int first, unsigned int last){
+	// The padding rockets are never launched : running the SIMD loop up to capacity is safe
+	if (last == system.count)
+		last = system.capacity;
+	unsigned int simdLast = first + (last - first) / ROCKET_SYSTEM_WIDTH * ROCKET_SYSTEM_WIDTH;
+	updateRocketSystemSIMD(system, first, simdLast);
+	updateRocketSystemScalar(system, simdLast, last);
+}
+
+void updateRocketSystem(RocketSystem & system){
+	updateRocketSystem(system, 0, system.count);
+}
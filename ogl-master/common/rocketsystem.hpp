@@ -0,0 +1,43 @@
+#ifndef ROCKETSYSTEM_HPP
+#define ROCKETSYSTEM_HPP
+
+// Many rockets, stored as a structure of arrays so that one SIMD instruction
+// updates 4 (SSE2) or 8 (AVX) rockets at once. Same flight rules as stepRocket() in rocketsim.cpp.
+//
+// The flags are 32-bit masks : 0 = false, -1 (all bits set) = true, ready to be used as SIMD masks.
+struct RocketSystem {
+	unsigned int count;     // Number of rockets
+	unsigned int capacity;  // count rounded up to ROCKET_SYSTEM_WIDTH. The padding rockets never launch.
+
+	float * height;
+	float * ySpeed;
+	float * rotation;
+	int   * launch;         // Launched
+	int   * chute;          // Parachute is open
+	int   * landing;        // Landed
+};
+
+#if defined(__AVX__)
+	#define ROCKET_SYSTEM_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define ROCKET_SYSTEM_WIDTH 4
+#else
+	#define ROCKET_SYSTEM_WIDTH 1
+#endif
+
+void initRocketSystem(RocketSystem & system, unsigned int count);
+void cleanupRocketSystem(RocketSystem & system);
+
+// Puts a rocket back on its pad and launches it with the given power (the "gauge" of rocketsim)
+void launchRocket(RocketSystem & system, unsigned int rocket, float gauge);
+
+// One tick for the rockets in [first, last). first should be a multiple of ROCKET_SYSTEM_WIDTH.
+void updateRocketSystem(RocketSystem & system, unsigned int first, unsigned int last);
+
+// One tick for all the rockets
+void updateRocketSystem(RocketSystem & system);
+
+// Plain C++ version of the kernel, one rocket at a time. For reference and benchmarks.
+void updateRocketSystemScalar(RocketSystem & system, unsigned int first, unsigned int last);
+
+#endif
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "texture.hpp"
+#include "sdffont.hpp"
+
+#define SDF_INFINITY 1e20f
+
+// Space between two glyphs, and the width of the ones without ink (the space character)
+#define GLYPH_SPACING 0.08f
+#define BLANK_ADVANCE 0.4f
+
+void initMonospaceFont(SDFFont & font){
+	font.cellSize = 0;
+	font.spread = 0.0f;
+	for ( int c=0; c<256; c++ ){
+		font.glyphs[c].left = 0.0f;
+		font.glyphs[c].right = 1.0f;
+		font.glyphs[c].advance = 1.0f;
+	}
+}
+
+// Squared distance transform of a row (Felzenszwalb and Huttenlocher) : f[i] becomes
+// min over j of (i - j)^2 + f[j]. f is 0 on the pixels to measure the distance to,
+// SDF_INFINITY elsewhere.
+static void distanceTransform1D(float * f, unsigned int n, unsigned int stride, std::vector<float> & d, std::vector<int> & v, std::vector<float> & z){
+	d.resize(n);
+	v.resize(n);
+	z.resize(n + 1);
+	int k = 0;
+	v[0] = 0;
+	z[0] = -SDF_INFINITY;
+	z[1] = SDF_INFINITY;
+	for ( int q=1; q<(int)n; q++ ){
+		float s;
+		for (;;) {
+			int p = v[k];
+			s = ((f[q * stride] + (float)q * q) - (f[p * stride] + (float)p * p)) / (2.0f * (q - p));
+			if ( s > z[k] || k == 0 )
+				break;
+			k--;
+		}
+		if ( s <= z[k] ){
+			// k == 0 : the parabola of q hides all the previous ones
+			v[0] = q;
+			z[1] = SDF_INFINITY;
+			continue;
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = SDF_INFINITY;
+	}
+	k = 0;
+	for ( int q=0; q<(int)n; q++ ){
+		while ( z[k + 1] < (float)q )
+			k++;
+		float delta = (float)(q - v[k]);
+		d[q] = delta * delta + f[v[k] * stride];
+	}
+	for ( unsigned int q=0; q<n; q++ )
+		f[q * stride] = d[q];
+}
+
+// Distance from every pixel to the nearest one of the set (0 in it)
+static void distanceTransform(const std::vector<unsigned char> & set, unsigned char value, unsigned int width, unsigned int height, std::vector<float> & distance){
+	distance.resize((size_t)width * height);
+	for ( size_t i=0; i<distance.size(); i++ )
+		distance[i] = set[i] == value ? 0.0f : SDF_INFINITY;
+	std::vector<float> d, z;
+	std::vector<int> v;
+	for ( unsigned int x=0; x<width; x++ )
+		distanceTransform1D(&distance[x], height, width, d, v, z);
+	for ( unsigned int y=0; y<height; y++ )
+		distanceTransform1D(&distance[(size_t)y * width], width, 1, d, v, z);
+	for ( size_t i=0; i<distance.size(); i++ )
+		distance[i] = sqrtf(distance[i]);
+}
+
+bool buildSDFFont(const unsigned char * rgba, unsigned int width, unsigned int height,
+	unsigned int cellSize, float spread, TextureImage & atlas, SDFFont & font){
+
+	memset(&atlas, 0, sizeof(atlas));
+	if ( width % 16 != 0 || height % 16 != 0 || width < 16 || height < 16 || cellSize == 0 || spread <= 0.0f ){
+		printf("A font is a 16x16 grid of cells : its size must be a multiple of 16\n");
+		return false;
+	}
+	unsigned int sourceWidth = width / 16, sourceHeight = height / 16;
+
+	// Alpha if the font has any, otherwise the brightness
+	bool useAlpha = false;
+	for ( size_t i=0; i<(size_t)width * height && !useAlpha; i++ )
+		useAlpha = rgba[4*i+3] != 255;
+
+	unsigned int atlasSize = 16 * cellSize;
+	unsigned char * data = (unsigned char*)malloc((size_t)atlasSize * atlasSize);
+	if ( !data ){
+		printf("Out of memory for a %ux%u atlas\n", atlasSize, atlasSize);
+		return false;
+	}
+
+	// Atlas texels per source pixel, to turn distances of the source into distances of the atlas
+	float scale = (float)cellSize / (float)sourceWidth;
+	std::vector<unsigned char> inside((size_t)sourceWidth * sourceHeight);
+	std::vector<float> toInside, toOutside, field(inside.size());
+	font.cellSize = cellSize;
+	font.spread = spread;
+	for ( int c=0; c<256; c++ ){
+		unsigned int cellX = (c % 16) * sourceWidth, cellY = (c / 16) * sourceHeight;
+		unsigned int inkLeft = sourceWidth, inkRight = 0;
+		for ( unsigned int y=0; y<sourceHeight; y++ ){
+			for ( unsigned int x=0; x<sourceWidth; x++ ){
+				const unsigned char * texel = rgba + ((size_t)(cellY + y) * width + cellX + x) * 4;
+				unsigned int ink = useAlpha ? texel[3] : (texel[0] * 77 + texel[1] * 150 + texel[2] * 29) >> 8;
+				inside[(size_t)y * sourceWidth + x] = ink >= 128;
+				if ( ink >= 128 ){
+					if ( x < inkLeft ) inkLeft = x;
+					if ( x + 1 > inkRight ) inkRight = x + 1;
+				}
+			}
+		}
+
+		SDFGlyph & glyph = font.glyphs[c];
+		if ( inkRight > inkLeft ){
+			glyph.left = (float)inkLeft / sourceWidth;
+			glyph.right = (float)inkRight / sourceWidth;
+			glyph.advance = glyph.right - glyph.left + GLYPH_SPACING;
+		}else{
+			glyph.left = glyph.right = 0.0f;
+			glyph.advance = BLANK_ADVANCE;
+		}
+
+		// Signed distance to the edge, in source pixels : the edge is half way between an inside
+		// pixel and an outside one
+		distanceTransform(inside, 1, sourceWidth, sourceHeight, toInside);
+		distanceTransform(inside, 0, sourceWidth, sourceHeight, toOutside);
+		for ( size_t i=0; i<field.size(); i++ )
+			field[i] = inside[i] ? toOutside[i] - 0.5f : 0.5f - toInside[i];
+
+		// Each atlas texel : the field at its center, bilinearly filtered, in atlas texels
+		unsigned char * cell = data + (size_t)(c / 16) * cellSize * atlasSize + (c % 16) * cellSize;
+		for ( unsigned int y=0; y<cellSize; y++ ){
+			float sy = glm::clamp(((float)y + 0.5f) * sourceHeight / cellSize - 0.5f, 0.0f, (float)sourceHeight - 1.0f);
+			unsigned int y0 = (unsigned int)sy, y1 = y0 + 1 < sourceHeight ? y0 + 1 : y0;
+			float fy = sy - y0;
+			for ( unsigned int x=0; x<cellSize; x++ ){
+				float sx = glm::clamp(((float)x + 0.5f) * sourceWidth / cellSize - 0.5f, 0.0f, (float)sourceWidth - 1.0f);
+				unsigned int x0 = (unsigned int)sx, x1 = x0 + 1 < sourceWidth ? x0 + 1 : x0;
+				float fx = sx - x0;
+				float top = field[(size_t)y0 * sourceWidth + x0] * (1.0f - fx) + field[(size_t)y0 * sourceWidth + x1] * fx;
+				float bottom = field[(size_t)y1 * sourceWidth + x0] * (1.0f - fx) + field[(size_t)y1 * sourceWidth + x1] * fx;
+				float distance = (top * (1.0f - fy) + bottom * fy) * scale;
+				float value = glm::clamp(0.5f + 0.5f * distance / spread, 0.0f, 1.0f);
+				cell[(size_t)y * atlasSize + x] = (unsigned char)(value * 255.0f + 0.5f);
+			}
+		}
+	}
+
+	atlas.target = GL_TEXTURE_2D;
+	atlas.internalFormat = GL_R8;
+	atlas.format = GL_RED;
+	atlas.type = GL_UNSIGNED_BYTE;
+	atlas.compressed = false;
+	atlas.generateMipmaps = false;
+	atlas.unpackAlignment = 1;
+	atlas.levelCount = 1;
+	atlas.levels[0].width = atlasSize;
+	atlas.levels[0].height = atlasSize;
+	atlas.levels[0].offset = 0;
+	atlas.levels[0].size = (size_t)atlasSize * atlasSize;
+	atlas.layers = 1;
+	atlas.faces = 1;
+	atlas.sliceSize = atlas.levels[0].size;
+	atlas.data = data;
+	atlas.dataSize = atlas.levels[0].size;
+	atlas.file = NULL;
+	return true;
+}
+
+bool writeSDFFont(const char * path, const SDFFont & font){
+	FILE * file = fopen(path, "w");
+	if ( !file ){
+		printf("%s could not be created\n", path);
+		return false;
+	}
+	fprintf(file, "sdffont %d %u %.9g\n", SDFFONT_VERSION, font.cellSize, font.spread);
+	for ( int c=0; c<256; c++ )
+		fprintf(file, "%d %.9g %.9g %.9g\n", c, font.glyphs[c].left, font.glyphs[c].right, font.glyphs[c].advance);
+	return fclose(file) == 0;
+}
+
+bool readSDFFont(const char * path, SDFFont & font){
+	FILE * file = fopen(path, "r");
+	if ( !file ){
+		printf("%s could not be opened. Are you in the right directory ?\n", path);
+		return false;
+	}
+	int version = 0;
+	bool ok = fscanf(file, "sdffont %d %u %f", &version, &font.cellSize, &font.spread) == 3 && version == SDFFONT_VERSION;
+	for ( int c=0; c<256 && ok; c++ ){
+		int code;
+		SDFGlyph glyph;
+		ok = fscanf(file, "%d %f %f %f", &code, &glyph.left, &glyph.right, &glyph.advance) == 4 && code >= 0 && code < 256;
+		if ( ok )
+			font.glyphs[code] = glyph;
+	}
+	fclose(file);
+	if ( !ok )
+		printf("%s : not a font description of version %d\n", path, SDFFONT_VERSION);
+	return ok;
+}
@@ -0,0 +1,42 @@
+#ifndef SDFFONT_HPP
+#define SDFFONT_HPP
+
+// Signed distance field fonts : each texel of the atlas holds the distance to the edge of the
+// glyph, 0.5 on the edge, more inside, less outside. The edge stays sharp at any scale once
+// the shader thresholds the linearly filtered distance (see initText2DSDF in text2D.hpp), so
+// one small atlas replaces a font texture per size.
+//
+// The atlas is made offline from a big bitmap font (misc07_tools/fontsdf) : the same 16x16
+// grid as the DDS fonts of text2D, character c in cell (c%16, c/16) from the top left.
+// It is an R8 texture, written as a DDS file, with its glyph metrics in a text file.
+
+#define SDFFONT_VERSION 1
+
+// In fractions of the width of a cell : drawn at size pixels, a glyph covers size x size
+// pixels, starting left * size pixels before the pen, and the pen moves by advance * size
+struct SDFGlyph {
+	float left, right;    // The ink. Both 0 for a glyph without any
+	float advance;
+};
+
+struct SDFFont {
+	unsigned int cellSize;    // Texels of a cell of the atlas. 0 : a bitmap font, every glyph is a whole cell
+	float spread;             // Distance, in atlas texels, from the edge to 0 or 1
+	SDFGlyph glyphs[256];
+};
+
+// Every glyph a whole cell, advance 1 : how text2D has always drawn the DDS fonts
+void initMonospaceFont(SDFFont & font);
+
+// rgba : width x height RGBA8 texels, top row first, width and height multiples of 16. The ink
+// is where alpha is over half, or the brightness if alpha is 255 everywhere.
+// cellSize : the cells of the atlas, which is 16 * cellSize texels wide and high.
+// Cells of the source much bigger than cellSize (8x or more) give the best fields.
+bool buildSDFFont(const unsigned char * rgba, unsigned int width, unsigned int height,
+	unsigned int cellSize, float spread, TextureImage & atlas, SDFFont & font);
+
+// "sdffont version cellSize spread", then one line per character : "code left right advance"
+bool writeSDFFont(const char * path, const SDFFont & font);
+bool readSDFFont(const char * path, SDFFont & font);
+
+#endif
@@ -1,10 +1,7 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
-#include <iostream>
-#include <fstream>
 #include <algorithm>
-#include <sstream>
 using namespace std;
 
 #include <stdlib.h>
@@ -14,35 +11,163 @@ using namespace std;
 
 #include "shader.hpp"
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+static std::string ShaderCacheDirectory = ".";
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+void setShaderCacheDirectory(const char * directory){
+	ShaderCacheDirectory = directory ? directory : "";
+}
+
+static bool readShaderFile(const char * path, std::string & code){
+	FILE * file = fopen(path, "rb");
+	if ( !file ){
+		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", path);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	code.resize(size > 0 ? size : 0);
+	bool ok = size >= 0 && (size == 0 || fread(&code[0], 1, size, file) == (size_t)size);
+	fclose(file);
+	if ( !ok )
+		printf("%s could not be read\n", path);
+	return ok;
+}
+
+// FNV-1a, 64 bits
+static unsigned long long hashBytes(unsigned long long hash, const void * data, size_t size){
+	const unsigned char * bytes = (const unsigned char*)data;
+	for ( size_t i=0; i<size; i++ )
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	return hash;
+}
 
-	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if(VertexShaderStream.is_open()){
-		std::stringstream sstr;
-		sstr << VertexShaderStream.rdbuf();
-		VertexShaderCode = sstr.str();
-		VertexShaderStream.close();
-	}else{
-		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
-		getchar();
+static unsigned long long hashString(unsigned long long hash, const char * string){
+	// With the terminating 0, so that "ab" + "c" and "a" + "bc" differ
+	return hashBytes(hash, string ? string : "", string ? strlen(string) + 1 : 1);
+}
+
+#define PROGRAM_CACHE_VERSION 1
+
+// A cached program : this header, then the binary of glGetProgramBinary
+struct ProgramCacheHeader {
+	char magic[4];                // "OGLP"
+	unsigned int version;         // PROGRAM_CACHE_VERSION
+	unsigned long long key;       // Sources and driver
+	unsigned int binaryFormat;
+	unsigned int binarySize;
+};
+
+static bool programBinariesSupported(){
+	if ( !GLEW_ARB_get_program_binary )
+		return false;
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+// 0 if there is no entry, if it was made from other sources or by another driver, or if the driver
+// rejects the binary anyway
+static GLuint loadCachedProgram(const std::string & path, unsigned long long key){
+	FILE * file = fopen(path.c_str(), "rb");
+	if ( !file )
+		return 0;
+	ProgramCacheHeader header;
+	std::vector<char> binary;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, "OGLP", 4) == 0 && header.version == PROGRAM_CACHE_VERSION
+		&& header.key == key && header.binarySize > 0;
+	if ( ok ){
+		binary.resize(header.binarySize);
+		ok = fread(&binary[0], 1, binary.size(), file) == binary.size();
+	}
+	fclose(file);
+	if ( !ok )
+		return 0;
+
+	GLuint ProgramID = glCreateProgram();
+	glProgramBinary(ProgramID, header.binaryFormat, &binary[0], header.binarySize);
+	GLint Result = GL_FALSE;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	if ( Result != GL_TRUE ){
+		glDeleteProgram(ProgramID);
 		return 0;
 	}
+	return ProgramID;
+}
 
-	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::stringstream sstr;
-		sstr << FragmentShaderStream.rdbuf();
-		FragmentShaderCode = sstr.str();
-		FragmentShaderStream.close();
+// Written to a temporary file first : an interrupted write never leaves a truncated entry
+static void saveCachedProgram(const std::string & path, unsigned long long key, GLuint ProgramID){
+	GLint BinarySize = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &BinarySize);
+	if ( BinarySize <= 0 )
+		return;
+	std::vector<char> binary(BinarySize);
+	GLenum BinaryFormat = 0;
+	glGetProgramBinary(ProgramID, BinarySize, NULL, &BinaryFormat, &binary[0]);
+
+	ProgramCacheHeader header;
+	memcpy(header.magic, "OGLP", 4);
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	header.binaryFormat = BinaryFormat;
+	header.binarySize = (unsigned int)BinarySize;
+
+	std::string temporary = path + ".tmp";
+	FILE * file = fopen(temporary.c_str(), "wb");
+	if ( !file ){
+		printf("%s could not be created, the program is not cached\n", temporary.c_str());
+		return;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(&binary[0], 1, binary.size(), file) == binary.size();
+	ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+	remove(path.c_str()); // rename doesn't replace on Windows
+#endif
+	if ( !ok || rename(temporary.c_str(), path.c_str()) != 0 ){
+		printf("%s could not be written, the program is not cached\n", path.c_str());
+		remove(temporary.c_str());
 	}
+}
+
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+
+	// Read the shader code from the files
+	std::string VertexShaderCode, FragmentShaderCode;
+	if ( !readShaderFile(vertex_file_path, VertexShaderCode) || !readShaderFile(fragment_file_path, FragmentShaderCode) )
+		return 0;
+
+	return LoadShaderSources(VertexShaderCode.c_str(), FragmentShaderCode.c_str(), vertex_file_path, fragment_file_path);
+}
+
+GLuint LoadShaderSources(const char * VertexShaderCode, const char * FragmentShaderCode,
+	const char * vertex_file_path, const char * fragment_file_path){
+
+	// Look for the linked program in the cache : one entry per pair of files, valid for these
+	// sources and this driver only
+	bool UseCache = !ShaderCacheDirectory.empty() && programBinariesSupported();
+	std::string CachePath;
+	unsigned long long CacheKey = 14695981039346656037ull;
+	if ( UseCache ){
+		CacheKey = hashString(CacheKey, VertexShaderCode);
+		CacheKey = hashString(CacheKey, FragmentShaderCode);
+		CacheKey = hashString(CacheKey, (const char*)glGetString(GL_VENDOR));
+		CacheKey = hashString(CacheKey, (const char*)glGetString(GL_RENDERER));
+		CacheKey = hashString(CacheKey, (const char*)glGetString(GL_VERSION));
+		unsigned long long PathHash = hashString(hashString(14695981039346656037ull, vertex_file_path), fragment_file_path);
+		char name[64];
+		sprintf(name, "/%016llx.glprogram", PathHash);
+		CachePath = ShaderCacheDirectory + name;
+		GLuint CachedProgramID = loadCachedProgram(CachePath, CacheKey);
+		if ( CachedProgramID ){
+			printf("Loading cached program : %s, %s\n", vertex_file_path, fragment_file_path);
+			return CachedProgramID;
+		}
+	}
+
+	// Create the shaders
+	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
 
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
@@ -50,7 +175,7 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 
 	// Compile Vertex Shader
 	printf("Compiling shader : %s\n", vertex_file_path);
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
+	char const * VertexSourcePointer = VertexShaderCode;
 	glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
 	glCompileShader(VertexShaderID);
 
@@ -67,7 +192,7 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 
 	// Compile Fragment Shader
 	printf("Compiling shader : %s\n", fragment_file_path);
-	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
+	char const * FragmentSourcePointer = FragmentShaderCode;
 	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
 	glCompileShader(FragmentShaderID);
 
@@ -87,10 +212,13 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	if ( UseCache )
+		glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(ProgramID);
 
 	// Check the program
 	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	GLint Linked = Result;
 	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 	if ( InfoLogLength > 0 ){
 		std::vector<char> ProgramErrorMessage(InfoLogLength+1);
@@ -105,6 +233,10 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	// Only programs that work go to the cache
+	if ( UseCache && Linked == GL_TRUE )
+		saveCachedProgram(CachePath, CacheKey, ProgramID);
+
 	return ProgramID;
 }
 
@@ -1,6 +1,20 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+// Compiles and links the two shaders. When the driver can (GL_ARB_get_program_binary), the linked
+// program is also saved in the shader cache, and later calls load it back with glProgramBinary
+// instead of compiling. The cache entry is keyed by a hash of both sources and of the driver
+// (vendor, renderer, version) : editing a shader or updating the driver compiles again.
 GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path);
 
+// The same, with the sources already in memory (see shaderregistry.hpp). The names are for the
+// log and the cache entry.
+GLuint LoadShaderSources(const char * VertexShaderCode, const char * FragmentShaderCode,
+	const char * vertex_file_path, const char * fragment_file_path);
+
+// Where the cached programs go, one file per pair of shaders : "." by default (the working
+// directory of the tutorial). NULL : always compile, never read or write the cache.
+// The directory must exist.
+void setShaderCacheDirectory(const char * directory);
+
 #endif
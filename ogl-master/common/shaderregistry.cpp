@@ -0,0 +1,516 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "shader.hpp"
+#include "shaderregistry.hpp"
+#include "benchtimer.hpp"
+
+// Editors often write a file in several steps : wait until it is quiet for that long
+#define RELOAD_DELAY 0.1
+// Without inotify, how often the modification times are checked
+#define POLL_INTERVAL 0.25
+#define MAX_INCLUDE_DEPTH 16
+
+typedef void (APIENTRY * PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+struct RegisteredProgram {
+	std::string vertexPath, fragmentPath;
+	GLuint program;
+	std::vector<std::string> files;   // Watched : both shaders and everything they include
+	bool changed;                     // Compile again, once the current compile is done
+	double changeTime;
+	bool compiling;
+
+	// With parallel compile : the program the driver is working on
+	GLuint pendingProgram;
+	GLuint pendingShaders[2];
+	std::vector<std::string> pendingFiles;
+	unsigned int pendingVertexFileCount;
+};
+
+struct CompileRequest {
+	unsigned int handle;
+	std::string vertexPath, fragmentPath;
+};
+
+struct CompileResult {
+	unsigned int handle;
+	bool ok;
+	GLuint program;                   // Linked by the worker. 0 with parallel compile
+	std::string vertexCode, fragmentCode;
+	std::vector<std::string> files;
+	unsigned int vertexFileCount;     // files starts with those of the vertex shader
+};
+
+struct ShaderRegistry {
+	std::vector<RegisteredProgram> programs;   // The handles are the indices
+	bool parallel;                             // The driver compiles in the background
+	GLFWwindow * workerWindow;                 // The shared context, without parallel compile
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<CompileRequest> requests;
+	std::deque<CompileResult> results;
+	bool quit;
+
+	// The watcher
+	std::vector<std::string> directories;
+#ifdef __linux__
+	int inotify;
+	std::map<int, std::string> watches;        // Watch descriptor -> directory
+#endif
+	std::map<std::string, time_t> modificationTimes;
+	double lastPoll;
+};
+
+// "" for a file of the working directory
+static std::string directoryOf(const std::string & path){
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+static std::string joinPath(const std::string & directory, const std::string & name){
+	return directory.empty() ? name : directory + "/" + name;
+}
+
+static bool readFile(const std::string & path, std::string & text){
+	FILE * file = fopen(path.c_str(), "rb");
+	if ( !file ){
+		printf("Impossible to open %s\n", path.c_str());
+		return false;
+	}
+	char buffer[4096];
+	size_t count;
+	text.clear();
+	while ( (count = fread(buffer, 1, sizeof(buffer), file)) > 0 )
+		text.append(buffer, count);
+	fclose(file);
+	return true;
+}
+
+// Expands the #include "file" lines, relative to the including file. files gets every file read,
+// in the order of their source string numbers.
+static bool preprocessShader(const std::string & path, std::string & code, std::vector<std::string> & files, unsigned int depth){
+	if ( depth > MAX_INCLUDE_DEPTH ){
+		printf("%s : #include nested too deep\n", path.c_str());
+		return false;
+	}
+	unsigned int source = (unsigned int)files.size();
+	files.push_back(path);
+	std::string text;
+	if ( !readFile(path, text) )
+		return false;
+
+	unsigned int line = 1;
+	size_t start = 0;
+	while ( start < text.size() ){
+		size_t end = text.find('\n', start);
+		if ( end == std::string::npos )
+			end = text.size();
+		size_t p = text.find_first_not_of(" \t", start);
+		const char * directive = "#include";
+		if ( p < end && text.compare(p, strlen(directive), directive) == 0 ){
+			size_t open = text.find('"', p);
+			size_t close = open < end ? text.find('"', open + 1) : std::string::npos;
+			if ( close >= end ){
+				printf("%s(%u) : #include \"file\" expected\n", path.c_str(), line);
+				return false;
+			}
+			std::string included = joinPath(directoryOf(path), text.substr(open + 1, close - open - 1));
+			char lineDirective[64];
+			sprintf(lineDirective, "#line 1 %u\n", (unsigned int)files.size());
+			code += lineDirective;
+			if ( !preprocessShader(included, code, files, depth + 1) )
+				return false;
+			if ( !code.empty() && code[code.size() - 1] != '\n' )
+				code += '\n';
+			sprintf(lineDirective, "#line %u %u\n", line + 1, source);
+			code += lineDirective;
+		}else{
+			code.append(text, start, end - start);
+			if ( end < text.size() )
+				code += '\n';
+		}
+		start = end + 1;
+		line++;
+	}
+	return true;
+}
+
+// Each shader numbers its files from 0 : the vertex shader ones come first in files
+static void printSourceNumbers(const std::vector<std::string> & files, unsigned int vertexFileCount){
+	for ( size_t i=0; i<files.size(); i++ )
+		printf("  %s %u : %s\n", i < vertexFileCount ? "vertex" : "fragment",
+			(unsigned int)(i < vertexFileCount ? i : i - vertexFileCount), files[i].c_str());
+}
+
+static void workerLoop(ShaderRegistry * registry){
+	if ( registry->workerWindow )
+		glfwMakeContextCurrent(registry->workerWindow);
+	for (;;) {
+		CompileRequest request;
+		{
+			std::unique_lock<std::mutex> lock(registry->mutex);
+			registry->wake.wait(lock, [registry]{ return registry->quit || !registry->requests.empty(); });
+			if ( registry->quit )
+				break;
+			request = registry->requests.front();
+			registry->requests.pop_front();
+		}
+
+		CompileResult result;
+		result.handle = request.handle;
+		result.program = 0;
+		std::vector<std::string> fragmentFiles;
+		result.ok = preprocessShader(request.vertexPath, result.vertexCode, result.files, 0);
+		result.vertexFileCount = (unsigned int)result.files.size();
+		result.ok = preprocessShader(request.fragmentPath, result.fragmentCode, fragmentFiles, 0) && result.ok;
+		result.files.insert(result.files.end(), fragmentFiles.begin(), fragmentFiles.end());
+
+		if ( result.ok && registry->workerWindow ){
+			// Compiled and linked here : the render thread only gets a finished program
+			result.program = LoadShaderSources(result.vertexCode.c_str(), result.fragmentCode.c_str(),
+				request.vertexPath.c_str(), request.fragmentPath.c_str());
+			GLint linked = GL_FALSE;
+			if ( result.program )
+				glGetProgramiv(result.program, GL_LINK_STATUS, &linked);
+			if ( linked != GL_TRUE ){
+				glDeleteProgram(result.program);
+				result.program = 0;
+				result.ok = false;
+			}
+			glFinish();
+		}
+
+		std::lock_guard<std::mutex> lock(registry->mutex);
+		registry->results.push_back(result);
+	}
+	if ( registry->workerWindow )
+		glfwMakeContextCurrent(NULL);
+}
+
+static void watchDirectory(ShaderRegistry * registry, const std::string & directory){
+	for ( size_t i=0; i<registry->directories.size(); i++ )
+		if ( registry->directories[i] == directory )
+			return;
+	registry->directories.push_back(directory);
+#ifdef __linux__
+	if ( registry->inotify >= 0 ){
+		// The directory, not the files : editors often save by writing a new file and renaming it
+		int watch = inotify_add_watch(registry->inotify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if ( watch >= 0 )
+			registry->watches[watch] = directory;
+		else
+			printf("%s can't be watched, its shaders won't reload\n", directory.empty() ? "." : directory.c_str());
+	}
+#endif
+}
+
+static time_t getModificationTime(const std::string & path){
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+}
+
+static void watchFiles(ShaderRegistry * registry, const std::vector<std::string> & files){
+	for ( size_t i=0; i<files.size(); i++ ){
+		watchDirectory(registry, directoryOf(files[i]));
+		if ( registry->modificationTimes.find(files[i]) == registry->modificationTimes.end() )
+			registry->modificationTimes[files[i]] = getModificationTime(files[i]);
+	}
+}
+
+static void fileChanged(ShaderRegistry * registry, const std::string & path, double time){
+	for ( size_t p=0; p<registry->programs.size(); p++ ){
+		RegisteredProgram & program = registry->programs[p];
+		for ( size_t i=0; i<program.files.size(); i++ ){
+			if ( program.files[i] == path ){
+				program.changed = true;
+				program.changeTime = time;
+				break;
+			}
+		}
+	}
+}
+
+static void pollWatcher(ShaderRegistry * registry, double time){
+#ifdef __linux__
+	if ( registry->inotify >= 0 ){
+		char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+		ssize_t length;
+		while ( (length = read(registry->inotify, buffer, sizeof(buffer))) > 0 ){
+			for ( char * p = buffer; p < buffer + length; ){
+				const struct inotify_event * event = (const struct inotify_event*)p;
+				std::map<int, std::string>::const_iterator watch = registry->watches.find(event->wd);
+				if ( event->len > 0 && watch != registry->watches.end() )
+					fileChanged(registry, joinPath(watch->second, event->name), time);
+				p += sizeof(struct inotify_event) + event->len;
+			}
+		}
+		return;
+	}
+#endif
+	if ( time - registry->lastPoll < POLL_INTERVAL )
+		return;
+	registry->lastPoll = time;
+	for ( std::map<std::string, time_t>::iterator i = registry->modificationTimes.begin(); i != registry->modificationTimes.end(); ++i ){
+		time_t modified = getModificationTime(i->first);
+		if ( modified != i->second ){
+			i->second = modified;
+			fileChanged(registry, i->first, time);
+		}
+	}
+}
+
+ShaderRegistry * createShaderRegistry(GLFWwindow * window){
+	ShaderRegistry * registry = new ShaderRegistry;
+	registry->quit = false;
+	registry->workerWindow = NULL;
+	registry->lastPoll = 0.0;
+
+	// Same enum and behaviour for the KHR and ARB extensions
+	registry->parallel = GLEW_ARB_parallel_shader_compile || glfwExtensionSupported("GL_KHR_parallel_shader_compile");
+	if ( registry->parallel ){
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+		if ( !maxThreads )
+			maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glMaxShaderCompilerThreadsARB;
+		if ( maxThreads )
+			maxThreads(0xFFFFFFFF); // As many as the driver wants
+	}else{
+		// A hidden window, only for its context. The other hints (version, profile) are still
+		// those of the main window.
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+		registry->workerWindow = glfwCreateWindow(1, 1, "Shader compiler", NULL, window);
+		glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
+		glfwMakeContextCurrent(window);
+		if ( !registry->workerWindow )
+			printf("No shared context for the shader compiler : shaders won't reload\n");
+	}
+
+#ifdef __linux__
+	registry->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if ( registry->inotify < 0 )
+		printf("inotify is not available, the shader files are polled\n");
+#endif
+
+	if ( registry->parallel || registry->workerWindow )
+		registry->thread = std::thread(workerLoop, registry);
+	return registry;
+}
+
+void destroyShaderRegistry(ShaderRegistry * registry){
+	{
+		std::lock_guard<std::mutex> lock(registry->mutex);
+		registry->quit = true;
+	}
+	registry->wake.notify_all();
+	if ( registry->thread.joinable() )
+		registry->thread.join();
+	for ( size_t i=0; i<registry->results.size(); i++ )
+		glDeleteProgram(registry->results[i].program);
+	for ( size_t p=0; p<registry->programs.size(); p++ ){
+		RegisteredProgram & program = registry->programs[p];
+		glDeleteProgram(program.program);
+		if ( program.pendingProgram ){
+			glDeleteProgram(program.pendingProgram);
+			glDeleteShader(program.pendingShaders[0]);
+			glDeleteShader(program.pendingShaders[1]);
+		}
+	}
+	if ( registry->workerWindow )
+		glfwDestroyWindow(registry->workerWindow);
+#ifdef __linux__
+	if ( registry->inotify >= 0 )
+		close(registry->inotify);
+#endif
+	delete registry;
+}
+
+unsigned int registerShaderProgram(ShaderRegistry * registry, const char * vertex_file_path, const char * fragment_file_path){
+	RegisteredProgram program;
+	program.vertexPath = vertex_file_path;
+	program.fragmentPath = fragment_file_path;
+	program.program = 0;
+	program.changed = false;
+	program.changeTime = 0.0;
+	program.compiling = false;
+	program.pendingProgram = 0;
+	program.pendingShaders[0] = program.pendingShaders[1] = 0;
+	program.pendingVertexFileCount = 0;
+
+	std::string vertexCode, fragmentCode;
+	std::vector<std::string> fragmentFiles;
+	bool ok = preprocessShader(program.vertexPath, vertexCode, program.files, 0);
+	ok = preprocessShader(program.fragmentPath, fragmentCode, fragmentFiles, 0) && ok;
+	program.files.insert(program.files.end(), fragmentFiles.begin(), fragmentFiles.end());
+	if ( ok ){
+		program.program = LoadShaderSources(vertexCode.c_str(), fragmentCode.c_str(), vertex_file_path, fragment_file_path);
+		GLint linked = GL_FALSE;
+		if ( program.program )
+			glGetProgramiv(program.program, GL_LINK_STATUS, &linked);
+		if ( linked != GL_TRUE ){
+			glDeleteProgram(program.program);
+			program.program = 0;
+		}
+	}
+	// Even if a file is missing : creating it loads the program
+	watchFiles(registry, program.files);
+	registry->programs.push_back(program);
+	return (unsigned int)registry->programs.size() - 1;
+}
+
+GLuint getShaderProgram(const ShaderRegistry * registry, unsigned int handle){
+	return registry->programs[handle].program;
+}
+
+// Prints the log of a shader or program, if there is one
+static void printInfoLog(GLuint object, bool program){
+	GLint length = 0;
+	if ( program )
+		glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+	else
+		glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+	if ( length <= 1 )
+		return;
+	std::vector<char> log(length + 1);
+	if ( program )
+		glGetProgramInfoLog(object, length, NULL, &log[0]);
+	else
+		glGetShaderInfoLog(object, length, NULL, &log[0]);
+	printf("%s\n", &log[0]);
+}
+
+// Parallel compile : starts the compile and the link, without asking for any result
+static void startParallelCompile(RegisteredProgram & program, const CompileResult & result){
+	printf("Compiling in the background : %s, %s\n", program.vertexPath.c_str(), program.fragmentPath.c_str());
+	const char * sources[2] = { result.vertexCode.c_str(), result.fragmentCode.c_str() };
+	program.pendingShaders[0] = glCreateShader(GL_VERTEX_SHADER);
+	program.pendingShaders[1] = glCreateShader(GL_FRAGMENT_SHADER);
+	program.pendingProgram = glCreateProgram();
+	for ( int i=0; i<2; i++ ){
+		glShaderSource(program.pendingShaders[i], 1, &sources[i], NULL);
+		glCompileShader(program.pendingShaders[i]);
+		glAttachShader(program.pendingProgram, program.pendingShaders[i]);
+	}
+	glLinkProgram(program.pendingProgram);
+	program.pendingFiles = result.files;
+	program.pendingVertexFileCount = result.vertexFileCount;
+}
+
+// Parallel compile : the new program once the driver is done with it, 0 if it failed.
+// false while it is still compiling.
+static bool finishParallelCompile(RegisteredProgram & program, GLuint & linkedProgram){
+	GLint done = GL_FALSE;
+	glGetProgramiv(program.pendingProgram, GL_COMPLETION_STATUS_ARB, &done);
+	if ( done != GL_TRUE )
+		return false;
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program.pendingProgram, GL_LINK_STATUS, &linked);
+	if ( linked != GL_TRUE ){
+		printInfoLog(program.pendingShaders[0], false);
+		printInfoLog(program.pendingShaders[1], false);
+		printInfoLog(program.pendingProgram, true);
+	}
+	for ( int i=0; i<2; i++ ){
+		glDetachShader(program.pendingProgram, program.pendingShaders[i]);
+		glDeleteShader(program.pendingShaders[i]);
+		program.pendingShaders[i] = 0;
+	}
+	linkedProgram = program.pendingProgram;
+	if ( linked != GL_TRUE ){
+		glDeleteProgram(linkedProgram);
+		linkedProgram = 0;
+	}
+	program.pendingProgram = 0;
+	return true;
+}
+
+static bool swapProgram(ShaderRegistry * registry, RegisteredProgram & program, GLuint linkedProgram,
+	const std::vector<std::string> & files, unsigned int vertexFileCount){
+	program.compiling = false;
+	if ( !linkedProgram ){
+		printf("%s, %s : not reloaded, the previous program stays. Source string numbers :\n", program.vertexPath.c_str(), program.fragmentPath.c_str());
+		printSourceNumbers(files, vertexFileCount);
+		return false;
+	}
+	// Still in use by the frames already submitted : OpenGL deletes it once they are done
+	glDeleteProgram(program.program);
+	program.program = linkedProgram;
+	program.files = files;
+	watchFiles(registry, files);
+	printf("Reloaded %s, %s\n", program.vertexPath.c_str(), program.fragmentPath.c_str());
+	return true;
+}
+
+unsigned int updateShaderRegistry(ShaderRegistry * registry){
+	if ( !registry->parallel && !registry->workerWindow )
+		return 0;
+	double time = now();
+	pollWatcher(registry, time);
+
+	// The programs whose files changed, and are quiet now
+	bool requested = false;
+	for ( size_t p=0; p<registry->programs.size(); p++ ){
+		RegisteredProgram & program = registry->programs[p];
+		if ( program.changed && !program.compiling && time - program.changeTime >= RELOAD_DELAY ){
+			CompileRequest request = { (unsigned int)p, program.vertexPath, program.fragmentPath };
+			std::lock_guard<std::mutex> lock(registry->mutex);
+			registry->requests.push_back(request);
+			program.changed = false;
+			program.compiling = true;
+			requested = true;
+		}
+	}
+	if ( requested )
+		registry->wake.notify_one();
+
+	std::deque<CompileResult> results;
+	{
+		std::lock_guard<std::mutex> lock(registry->mutex);
+		results.swap(registry->results);
+	}
+
+	unsigned int swapped = 0;
+	for ( size_t r=0; r<results.size(); r++ ){
+		const CompileResult & result = results[r];
+		RegisteredProgram & program = registry->programs[result.handle];
+		if ( registry->parallel && result.ok )
+			startParallelCompile(program, result);
+		else if ( swapProgram(registry, program, result.program, result.files, result.vertexFileCount) )
+			swapped++;
+	}
+
+	if ( registry->parallel ){
+		for ( size_t p=0; p<registry->programs.size(); p++ ){
+			RegisteredProgram & program = registry->programs[p];
+			GLuint linkedProgram;
+			if ( program.pendingProgram && finishParallelCompile(program, linkedProgram) ){
+				std::vector<std::string> files;
+				files.swap(program.pendingFiles);
+				if ( swapProgram(registry, program, linkedProgram, files, program.pendingVertexFileCount) )
+					swapped++;
+			}
+		}
+	}
+	return swapped;
+}
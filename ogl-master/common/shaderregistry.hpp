@@ -0,0 +1,38 @@
+#ifndef SHADERREGISTRY_HPP
+#define SHADERREGISTRY_HPP
+
+// Shader programs that reload themselves when their files change, without a restart and without
+// ever stopping the frames for a compile :
+//
+// 1. The directories of the shaders are watched (inotify on Linux, modification times elsewhere).
+// 2. When a file changes, a worker thread reads it again and expands its #include "file" lines.
+// 3. The compile happens away from the frames : with GL_KHR_parallel_shader_compile (or the ARB
+//    one) the driver compiles on its own threads, and updateShaderRegistry only asks whether it
+//    is done; otherwise the worker compiles and links in a hidden window whose context shares
+//    its objects with the main one.
+// 4. updateShaderRegistry swaps the new program in, between two frames. If it doesn't compile,
+//    the log is printed and the previous program stays.
+//
+// Included files get their own source string number in the compile logs : "0(12)" is line 12 of
+// the shader itself, "1(3)" line 3 of the first included file, as printed with the log.
+struct ShaderRegistry;
+
+// window : the window of the main context, current on the calling thread (the render thread).
+// Call it after glewInit.
+ShaderRegistry * createShaderRegistry(GLFWwindow * window);
+
+// Deletes the programs, and the hidden window. On the render thread.
+void destroyShaderRegistry(ShaderRegistry * registry);
+
+// Compiles the program now, like LoadShaders (and through its cache), then watches its files.
+// The program is 0 while it doesn't compile. Returns a handle for getShaderProgram.
+unsigned int registerShaderProgram(ShaderRegistry * registry, const char * vertex_file_path, const char * fragment_file_path);
+
+// The current program : it only changes during updateShaderRegistry
+GLuint getShaderProgram(const ShaderRegistry * registry, unsigned int handle);
+
+// Once per frame, before drawing. Never waits for a compile. Returns the number of programs
+// swapped : their uniform locations must be looked up again.
+unsigned int updateShaderRegistry(ShaderRegistry * registry);
+
+#endif
@@ -0,0 +1,354 @@
+#include <vector>
+#include <map>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h> // for memcmp
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "shapes.hpp"
+
+static const float TWO_PI = 2.0f * 3.14159265f;
+
+static int clampSides(int sides){
+	return sides < SHAPE_MIN_SIDES ? SHAPE_MIN_SIDES : sides;
+}
+
+static ShapeParams emptyShape(ShapeType type){
+	// Every field is set, unused ones to 0 : the cache compares all the bytes
+	ShapeParams params;
+	params.type = type;
+	params.axis = 0; params.sides = 0; params.rings = 0; params.capped = 0;
+	params.center = glm::vec3(0.0f);
+	params.radius = 0.0f; params.topRadius = 0.0f; params.height = 0.0f;
+	params.size = glm::vec3(0.0f);
+	return params;
+}
+
+ShapeParams circleShape(glm::vec3 center, float radius, int sides, int axis){
+	ShapeParams params = emptyShape(SHAPE_CIRCLE);
+	params.center = center; params.radius = radius; params.sides = clampSides(sides); params.axis = axis;
+	return params;
+}
+
+ShapeParams discShape(glm::vec3 center, float radius, int sides, int axis){
+	ShapeParams params = circleShape(center, radius, sides, axis);
+	params.type = SHAPE_DISC;
+	return params;
+}
+
+ShapeParams frustumShape(glm::vec3 baseCenter, float radius, float topRadius, float height, int sides, bool capped, int axis){
+	ShapeParams params = emptyShape(SHAPE_FRUSTUM);
+	params.center = baseCenter; params.radius = radius; params.topRadius = topRadius;
+	params.height = height; params.sides = clampSides(sides); params.capped = capped ? 1 : 0; params.axis = axis;
+	return params;
+}
+
+ShapeParams cylinderShape(glm::vec3 baseCenter, float radius, float height, int sides, bool capped, int axis){
+	ShapeParams params = frustumShape(baseCenter, radius, radius, height, sides, capped, axis);
+	params.type = SHAPE_CYLINDER;
+	return params;
+}
+
+ShapeParams coneShape(glm::vec3 baseCenter, float radius, float height, int sides, bool capped, int axis){
+	ShapeParams params = frustumShape(baseCenter, radius, 0.0f, height, sides, capped, axis);
+	params.type = SHAPE_CONE;
+	return params;
+}
+
+ShapeParams sphereShape(glm::vec3 center, float radius, int sides, int rings){
+	ShapeParams params = emptyShape(SHAPE_SPHERE);
+	params.center = center; params.radius = radius; params.sides = clampSides(sides);
+	params.rings = rings < SHAPE_MIN_RINGS ? SHAPE_MIN_RINGS : rings; params.axis = 1;
+	return params;
+}
+
+ShapeParams boxShape(glm::vec3 center, glm::vec3 size){
+	ShapeParams params = emptyShape(SHAPE_BOX);
+	params.center = center; params.size = size;
+	return params;
+}
+
+GLenum getShapeMode(const ShapeParams & params){
+	return params.type == SHAPE_CIRCLE ? GL_LINES : GL_TRIANGLES;
+}
+
+bool isShapeValid(const ShapeParams & params){
+	if ( params.type == SHAPE_BOX )
+		return true;
+	if ( params.type < SHAPE_CIRCLE || params.type > SHAPE_BOX )
+		return false;
+	if ( params.axis < 0 || params.axis > 2 || params.sides < SHAPE_MIN_SIDES )
+		return false;
+	return params.type != SHAPE_SPHERE || params.rings >= SHAPE_MIN_RINGS;
+}
+
+void getShapeSize(const ShapeParams & params, unsigned int & vertexCount, unsigned int & indexCount){
+	if ( !isShapeValid(params) ){
+		vertexCount = 0;
+		indexCount = 0;
+		return;
+	}
+	unsigned int s = (unsigned int)params.sides;
+	unsigned int r = (unsigned int)params.rings;
+	unsigned int caps = params.capped ? 1 : 0;
+	switch ( params.type ){
+	case SHAPE_CIRCLE   : vertexCount = s;     indexCount = 2*s; break;
+	case SHAPE_DISC     : vertexCount = s+1;   indexCount = 3*s; break;
+	case SHAPE_CONE     : vertexCount = 1+s+caps;      indexCount = 3*s + caps*3*s; break;
+	case SHAPE_CYLINDER :
+	case SHAPE_FRUSTUM  : vertexCount = 2*s + 2*caps;  indexCount = 6*s + caps*6*s; break;
+	// Both poles, and rings-1 circles in between
+	case SHAPE_SPHERE   : vertexCount = 2 + (r-1)*s;   indexCount = 6*s*(r-1); break;
+	case SHAPE_BOX      : vertexCount = 8;     indexCount = 36; break;
+	default             : vertexCount = 0;     indexCount = 0; break;
+	}
+}
+
+// Builds a frame where u x v = axis, so that the rim turns counter-clockwise seen from +axis
+static void getAxisFrame(int axis, glm::vec3 & u, glm::vec3 & v, glm::vec3 & w){
+	switch ( axis ){
+	case 0  : u = glm::vec3(0,1,0); v = glm::vec3(0,0,1); w = glm::vec3(1,0,0); break;
+	case 1  : u = glm::vec3(0,0,1); v = glm::vec3(1,0,0); w = glm::vec3(0,1,0); break;
+	default : u = glm::vec3(1,0,0); v = glm::vec3(0,1,0); w = glm::vec3(0,0,1); break;
+	}
+}
+
+// sides points on a circle, counter-clockwise around w
+static void writeRim(glm::vec3 * out, glm::vec3 center, float radius, int sides, glm::vec3 u, glm::vec3 v){
+	for ( int i=0; i<sides; i++ ){
+		float angle = i * TWO_PI / sides;
+		out[i] = center + radius * (cosf(angle) * u + sinf(angle) * v);
+	}
+}
+
+// Fan from a center vertex to a rim. flip = the triangles face -w instead of +w.
+static unsigned int * writeFan(unsigned int * out, unsigned int center, unsigned int firstRim, int sides, bool flip){
+	for ( int i=0; i<sides; i++ ){
+		unsigned int a = firstRim + i;
+		unsigned int b = firstRim + (i+1) % sides;
+		*out++ = center;
+		*out++ = flip ? b : a;
+		*out++ = flip ? a : b;
+	}
+	return out;
+}
+
+void generateShape(const ShapeParams & params, glm::vec3 * vertices, unsigned int * indices){
+	if ( !isShapeValid(params) )
+		return; // getShapeSize said 0 and 0
+	glm::vec3 u, v, w;
+	getAxisFrame(params.axis, u, v, w);
+	const int s = params.sides;
+	// A negative height turns the shape inside out : swap the winding back
+	const bool inverted = params.height < 0.0f;
+
+	switch ( params.type ){
+	case SHAPE_CIRCLE :
+		writeRim(vertices, params.center, params.radius, s, u, v);
+		for ( int i=0; i<s; i++ ){
+			*indices++ = i;
+			*indices++ = (i+1) % s;
+		}
+		break;
+
+	case SHAPE_DISC :
+		vertices[0] = params.center;
+		writeRim(vertices + 1, params.center, params.radius, s, u, v);
+		writeFan(indices, 0, 1, s, false);
+		break;
+
+	case SHAPE_CONE :
+		vertices[0] = params.center + params.height * w; // Apex
+		writeRim(vertices + 1, params.center, params.radius, s, u, v);
+		indices = writeFan(indices, 0, 1, s, inverted);
+		if ( params.capped ){
+			vertices[1+s] = params.center;
+			writeFan(indices, 1+s, 1, s, !inverted);
+		}
+		break;
+
+	case SHAPE_CYLINDER :
+	case SHAPE_FRUSTUM : {
+		glm::vec3 top = params.center + params.height * w;
+		writeRim(vertices    , params.center, params.radius   , s, u, v);
+		writeRim(vertices + s, top          , params.topRadius, s, u, v);
+		for ( int i=0; i<s; i++ ){
+			unsigned int b0 = i, b1 = (i+1) % s;
+			unsigned int t0 = s + b0, t1 = s + b1;
+			unsigned int quad[6] = { b0, b1, t1, b0, t1, t0 };
+			for ( int k=0; k<6; k+=3 ){
+				*indices++ = quad[k];
+				*indices++ = inverted ? quad[k+2] : quad[k+1];
+				*indices++ = inverted ? quad[k+1] : quad[k+2];
+			}
+		}
+		if ( params.capped ){
+			vertices[2*s  ] = params.center;
+			vertices[2*s+1] = top;
+			indices = writeFan(indices, 2*s  , 0, s, !inverted);
+			indices = writeFan(indices, 2*s+1, s, s,  inverted);
+		}
+		break;
+	}
+
+	case SHAPE_SPHERE : {
+		const int r = params.rings;
+		const unsigned int south = 0, north = 1 + (r-1)*s;
+		vertices[south] = params.center - params.radius * w;
+		vertices[north] = params.center + params.radius * w;
+		for ( int ring=1; ring<r; ring++ ){
+			float latitude = ring * (TWO_PI/2) / r - TWO_PI/4; // -90 to +90 degrees
+			writeRim(vertices + 1 + (ring-1)*s, params.center + params.radius * sinf(latitude) * w,
+			         params.radius * cosf(latitude), s, u, v);
+		}
+		indices = writeFan(indices, south, 1, s, true);
+		for ( int ring=1; ring<r-1; ring++ ){
+			unsigned int first = 1 + (ring-1)*s;
+			for ( int i=0; i<s; i++ ){
+				unsigned int b0 = first + i, b1 = first + (i+1) % s;
+				unsigned int t0 = b0 + s, t1 = b1 + s;
+				*indices++ = b0; *indices++ = b1; *indices++ = t1;
+				*indices++ = b0; *indices++ = t1; *indices++ = t0;
+			}
+		}
+		writeFan(indices, north, 1 + (r-2)*s, s, false);
+		break;
+	}
+
+	case SHAPE_BOX : {
+		glm::vec3 half = params.size * 0.5f;
+		// Corner i has x = bit 0, y = bit 1, z = bit 2
+		for ( int i=0; i<8; i++ )
+			vertices[i] = params.center + glm::vec3( i&1 ? half.x : -half.x, i&2 ? half.y : -half.y, i&4 ? half.z : -half.z );
+		static const unsigned int box_indices[36] = {
+			0,4,6, 0,6,2, // -X
+			1,3,7, 1,7,5, // +X
+			0,1,5, 0,5,4, // -Y
+			2,6,7, 2,7,3, // +Y
+			0,2,3, 0,3,1, // -Z
+			4,5,7, 4,7,6  // +Z
+		};
+		memcpy(indices, box_indices, sizeof(box_indices));
+		break;
+	}
+	}
+}
+
+
+void generateSphereSoup(const ShapeParams & params, std::vector<glm::vec3> & vertices, std::vector<glm::vec2> & uvs, std::vector<glm::vec3> & normals){
+	unsigned int vertexCount, indexCount;
+	getShapeSize(params, vertexCount, indexCount);
+	if ( params.type != SHAPE_SPHERE || indexCount == 0 )
+		return;
+	std::vector<glm::vec3> positions(vertexCount);
+	std::vector<unsigned int> indices(indexCount);
+	generateShape(params, &positions[0], &indices[0]);
+	glm::vec3 u, v, w;
+	getAxisFrame(params.axis, u, v, w);
+
+	for ( unsigned int i=0; i<indexCount; i+=3 ){
+		glm::vec3 n[3];
+		glm::vec2 uv[3];
+		bool pole[3];
+		for ( int k=0; k<3; k++ ){
+			n[k] = glm::normalize(positions[indices[i+k]] - params.center);
+			float height = glm::clamp(glm::dot(n[k], w), -1.0f, 1.0f);
+			uv[k] = glm::vec2(atan2f(glm::dot(n[k], v), glm::dot(n[k], u)) / TWO_PI + 0.5f, acosf(height) / (TWO_PI/2));
+			pole[k] = fabsf(height) > 0.9999f;
+		}
+		// Every corner as close as possible to the first one on the rim, and the pole, which has
+		// no longitude, in the middle of the other two
+		int first = pole[0] ? 1 : 0;
+		float poleU = 0.0f;
+		for ( int k=0; k<3; k++ ){
+			if ( pole[k] )
+				continue;
+			if ( uv[k].x - uv[first].x > 0.5f ) uv[k].x -= 1.0f;
+			if ( uv[k].x - uv[first].x < -0.5f ) uv[k].x += 1.0f;
+			poleU += uv[k].x * 0.5f;
+		}
+		float minU = 1.0f;
+		for ( int k=0; k<3; k++ ){
+			if ( pole[k] )
+				uv[k].x = poleU;
+			minU = glm::min(minU, uv[k].x);
+		}
+		// Moved as a whole triangle : on the seam, past 1 rather than below 0
+		for ( int k=0; k<3; k++ )
+			uv[k].x += minU < 0.0f ? 1.0f : 0.0f;
+		for ( int k=0; k<3; k++ ){
+			vertices.push_back(positions[indices[i+k]]);
+			uvs.push_back(uv[k]);
+			normals.push_back(n[k]);
+		}
+	}
+}
+
+void initShapeArena(ShapeArena & arena, size_t blockSize){
+	arena.blocks.clear();
+	arena.blockSize = blockSize;
+	arena.used = blockSize; // Forces a new block on the first allocation
+}
+
+void * allocateFromArena(ShapeArena & arena, size_t size){
+	size = (size + 15) & ~(size_t)15; // Keep everything 16-byte aligned
+	if ( arena.blocks.empty() || arena.used + size > arena.blockSize ){
+		// Oversized requests get a block of their own
+		size_t newBlock = size > arena.blockSize ? size : arena.blockSize;
+		arena.blocks.push_back( (char*)malloc(newBlock) );
+		arena.used = 0;
+		if ( newBlock > arena.blockSize ){
+			arena.used = arena.blockSize; // Don't put anything after it
+			return arena.blocks.back();
+		}
+	}
+	void * memory = arena.blocks.back() + arena.used;
+	arena.used += size;
+	return memory;
+}
+
+void cleanupShapeArena(ShapeArena & arena){
+	for ( size_t i=0; i<arena.blocks.size(); i++ )
+		free(arena.blocks[i]);
+	initShapeArena(arena, arena.blockSize);
+}
+
+
+bool ShapeParamsLess::operator()(const ShapeParams & a, const ShapeParams & b) const{
+	// Only 4-byte fields : no padding, and emptyShape sets everything else to 0
+	return memcmp(&a, &b, sizeof(ShapeParams)) < 0;
+}
+
+void initShapeCache(ShapeCache & cache){
+	initShapeArena(cache.arena);
+	cache.meshes.clear();
+	cache.hits = 0;
+	cache.misses = 0;
+}
+
+const ShapeMesh & getShape(ShapeCache & cache, const ShapeParams & params){
+	std::map<ShapeParams, ShapeMesh, ShapeParamsLess>::iterator it = cache.meshes.find(params);
+	if ( it != cache.meshes.end() ){
+		cache.hits++;
+		return it->second;
+	}
+	cache.misses++;
+
+	ShapeMesh mesh;
+	getShapeSize(params, mesh.vertexCount, mesh.indexCount);
+	glm::vec3    * vertices = (glm::vec3*)   allocateFromArena(cache.arena, mesh.vertexCount * sizeof(glm::vec3));
+	unsigned int * indices  = (unsigned int*)allocateFromArena(cache.arena, mesh.indexCount  * sizeof(unsigned int));
+	generateShape(params, vertices, indices);
+	mesh.mode     = getShapeMode(params);
+	mesh.vertices = vertices;
+	mesh.indices  = indices;
+	return cache.meshes[params] = mesh;
+}
+
+void cleanupShapeCache(ShapeCache & cache){
+	cleanupShapeArena(cache.arena);
+	cache.meshes.clear();
+}
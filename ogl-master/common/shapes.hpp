@@ -0,0 +1,106 @@
+#ifndef SHAPES_HPP
+#define SHAPES_HPP
+
+// Procedural shapes, generated as indexed positions.
+//
+// Round shapes are built around an axis (0 = X, 1 = Y, 2 = Z) : a disc faces along it,
+// a cone or a cylinder grows along it. Triangles are counter-clockwise seen from outside.
+
+enum ShapeType {
+	SHAPE_CIRCLE,    // Outline only : GL_LINES
+	SHAPE_DISC,      // Filled circle
+	SHAPE_CONE,
+	SHAPE_CYLINDER,
+	SHAPE_FRUSTUM,   // Cone with the tip cut off : radius at the base, topRadius at the top
+	SHAPE_SPHERE,
+	SHAPE_BOX
+};
+
+// Everything that defines a shape. Two equal ShapeParams give the same mesh,
+// so this is also the key of the ShapeCache. Use the helpers below to fill it.
+struct ShapeParams {
+	ShapeType type;
+	int axis;
+	int sides;           // Segments around the axis
+	int rings;           // Sphere only : segments from pole to pole
+	int capped;          // Cone, cylinder, frustum : close the ends
+	glm::vec3 center;    // Center of the base for cones, cylinders and frustums; center otherwise
+	float radius;
+	float topRadius;
+	float height;        // Along the axis. Can be negative : the shape grows the other way
+	glm::vec3 size;      // Box only : full extents
+};
+
+// The least that closes a round shape : a triangle around the axis, and a sphere of two
+// rings, pole to equator to pole. The helpers below raise smaller values to these.
+#define SHAPE_MIN_SIDES 3
+#define SHAPE_MIN_RINGS 2
+
+ShapeParams circleShape  (glm::vec3 center, float radius, int sides, int axis = 2);
+ShapeParams discShape    (glm::vec3 center, float radius, int sides, int axis = 2);
+ShapeParams coneShape    (glm::vec3 baseCenter, float radius, float height, int sides, bool capped = false, int axis = 1);
+ShapeParams cylinderShape(glm::vec3 baseCenter, float radius, float height, int sides, bool capped = true, int axis = 1);
+ShapeParams frustumShape (glm::vec3 baseCenter, float radius, float topRadius, float height, int sides, bool capped = true, int axis = 1);
+ShapeParams sphereShape  (glm::vec3 center, float radius, int sides, int rings);
+ShapeParams boxShape     (glm::vec3 center, glm::vec3 size);
+
+// false for ShapeParams filled by hand with too few sides or rings, or an axis other than
+// 0, 1 or 2 : such a shape has no vertices and no indices
+bool isShapeValid(const ShapeParams & params);
+
+// GL_LINES for SHAPE_CIRCLE, GL_TRIANGLES for everything else
+GLenum getShapeMode(const ShapeParams & params);
+
+// How much memory generateShape will write. 0 and 0 if !isShapeValid.
+void getShapeSize(const ShapeParams & params, unsigned int & vertexCount, unsigned int & indexCount);
+
+// Writes the shape straight into vertices and indices, which must be large enough (see getShapeSize).
+// Indices start at 0. Vertex layout of a cone : apex first, then the rim, then the cap center if capped.
+void generateShape(const ShapeParams & params, glm::vec3 * vertices, unsigned int * indices);
+
+// A SHAPE_SPHERE as a triangle soup, the way loadOBJ returns a model : 3 vertices per triangle,
+// normals pointing out of the center, and UVs from longitude (u) and latitude (v, 0 at the top).
+// Triangles across the seam get u past 1 rather than wrapping around. Appended to the vectors;
+// nothing for another type of shape.
+void generateSphereSoup(const ShapeParams & params, std::vector<glm::vec3> & vertices, std::vector<glm::vec2> & uvs, std::vector<glm::vec3> & normals);
+
+
+// Memory for many meshes, allocated in large blocks and freed all at once.
+// Pointers stay valid until cleanupShapeArena.
+struct ShapeArena {
+	std::vector<char*> blocks;
+	size_t blockSize;
+	size_t used;      // In the last block
+};
+
+void initShapeArena(ShapeArena & arena, size_t blockSize = 1 << 20);
+void * allocateFromArena(ShapeArena & arena, size_t size);
+void cleanupShapeArena(ShapeArena & arena);
+
+
+// A generated mesh, living in a ShapeArena
+struct ShapeMesh {
+	GLenum mode;
+	const glm::vec3 * vertices;
+	unsigned int vertexCount;
+	const unsigned int * indices;
+	unsigned int indexCount;
+};
+
+struct ShapeParamsLess {
+	bool operator()(const ShapeParams & a, const ShapeParams & b) const;
+};
+
+// Generates each distinct shape once : asking again with the same parameters returns the same mesh.
+struct ShapeCache {
+	ShapeArena arena;
+	std::map<ShapeParams, ShapeMesh, ShapeParamsLess> meshes;
+	unsigned int hits;
+	unsigned int misses;
+};
+
+void initShapeCache(ShapeCache & cache);
+const ShapeMesh & getShape(ShapeCache & cache, const ShapeParams & params);
+void cleanupShapeCache(ShapeCache & cache);
+
+#endif
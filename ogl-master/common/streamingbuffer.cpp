@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stddef.h>
+
+#include <GL/glew.h>
+
+#include "streamingbuffer.hpp"
+
+void createStreamingBuffer(StreamingBuffer & ring, GLenum target, size_t segmentSize){
+	ring.target = target;
+	ring.segmentSize = segmentSize;
+	ring.persistent = NULL;
+	for ( int i=0; i<STREAMING_BUFFER_SEGMENTS; i++ )
+		ring.fences[i] = 0;
+	ring.segment = 0;
+
+	glGenBuffers(1, &ring.buffer);
+	glBindBuffer(target, ring.buffer);
+	GLsizeiptr ringSize = (GLsizeiptr)(STREAMING_BUFFER_SEGMENTS * segmentSize);
+	if ( GLEW_ARB_buffer_storage ){
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, ringSize, NULL, flags);
+		ring.persistent = (unsigned char*)glMapBufferRange(target, 0, ringSize, flags);
+	}else{
+		glBufferData(target, ringSize, NULL, GL_STREAM_DRAW);
+	}
+	glBindBuffer(target, 0);
+}
+
+void destroyStreamingBuffer(StreamingBuffer & ring){
+	for ( int i=0; i<STREAMING_BUFFER_SEGMENTS; i++ ){
+		if ( ring.fences[i] )
+			glDeleteSync(ring.fences[i]);
+		ring.fences[i] = 0;
+	}
+	glDeleteBuffers(1, &ring.buffer); // Unmaps it too
+	ring.buffer = 0;
+	ring.persistent = NULL;
+}
+
+bool waitStreamingSegment(StreamingBuffer & ring){
+	GLsync & fence = ring.fences[ring.segment];
+	if ( !fence )
+		return true;
+	// Once, not in a loop : a GPU that never gets there must not hang the program with it
+	if ( glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, STREAMING_BUFFER_TIMEOUT) == GL_TIMEOUT_EXPIRED ){
+		printf("Streaming buffer : the GPU is still reading segment %u, skipping it\n", ring.segment);
+		return false;
+	}
+	glDeleteSync(fence);
+	fence = 0;
+	return true;
+}
+
+void nextStreamingSegment(StreamingBuffer & ring){
+	GLsync & fence = ring.fences[ring.segment];
+	if ( fence )
+		glDeleteSync(fence); // Not waited for : the new fence comes after it anyway
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	ring.segment = (ring.segment + 1) % STREAMING_BUFFER_SEGMENTS;
+}
+
+size_t getStreamingSegmentOffset(const StreamingBuffer & ring){
+	return ring.segment * ring.segmentSize;
+}
+
+unsigned char * mapStreamingRange(StreamingBuffer & ring, size_t offset, size_t size){
+	glBindBuffer(ring.target, ring.buffer);
+	if ( ring.persistent )
+		return ring.persistent + getStreamingSegmentOffset(ring) + offset;
+	return (unsigned char*)glMapBufferRange(ring.target, getStreamingSegmentOffset(ring) + offset, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void unmapStreamingRange(StreamingBuffer & ring){
+	if ( !ring.persistent )
+		glUnmapBuffer(ring.target);
+}
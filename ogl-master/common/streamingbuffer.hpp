@@ -0,0 +1,50 @@
+#ifndef STREAMINGBUFFER_HPP
+#define STREAMINGBUFFER_HPP
+
+// A buffer object the CPU writes every frame while the GPU still reads what was written before :
+// a ring of STREAMING_BUFFER_SEGMENTS segments, used in turn, each protected by a fence. The CPU
+// only writes a segment once the GPU is done with what it read from it the last time round.
+//
+// With GL_ARB_buffer_storage the buffer stays mapped forever (persistent mapping). Otherwise
+// each write maps its range with GL_MAP_UNSYNCHRONIZED_BIT, which is just as fast since the
+// fence already says the GPU is done with it, and unmaps it right after.
+//
+// Used by text2D.cpp (vertices) and texturestreamer.cpp (pixels).
+
+#define STREAMING_BUFFER_SEGMENTS 3
+
+// How long waitStreamingSegment waits for the GPU, in nanoseconds. Normally the fence is long
+// signaled; past that, the GPU is hung or far behind, and the caller does without the segment.
+#define STREAMING_BUFFER_TIMEOUT 1000000000ull
+
+struct StreamingBuffer {
+	GLuint buffer;
+	GLenum target;                 // GL_ARRAY_BUFFER, GL_PIXEL_UNPACK_BUFFER...
+	size_t segmentSize;            // In bytes
+	unsigned char * persistent;    // The whole ring, NULL if each range is mapped when written
+	GLsync fences[STREAMING_BUFFER_SEGMENTS];
+	unsigned int segment;          // The current one
+};
+
+// Leaves target unbound
+void createStreamingBuffer(StreamingBuffer & ring, GLenum target, size_t segmentSize);
+// Unmaps and deletes the buffer, and the fences
+void destroyStreamingBuffer(StreamingBuffer & ring);
+
+// Waits until the GPU is done with the current segment, at most STREAMING_BUFFER_TIMEOUT.
+// false if it isn't yet : don't write it, and try again later.
+bool waitStreamingSegment(StreamingBuffer & ring);
+// The GPU reads the current segment until here : fences it, and moves to the next one
+void nextStreamingSegment(StreamingBuffer & ring);
+
+// In bytes, from the start of the buffer : what to give to glDrawArrays, glTexImage2D...
+size_t getStreamingSegmentOffset(const StreamingBuffer & ring);
+
+// Where to write [offset, offset + size) of the current segment (offset from the start of the
+// segment). Binds the buffer to its target. NULL if it couldn't be mapped.
+// Write it once, in order : the mapping may be write-combined memory.
+unsigned char * mapStreamingRange(StreamingBuffer & ring, size_t offset, size_t size);
+// Before OpenGL uses the range. The buffer must still be bound to its target.
+void unmapStreamingRange(StreamingBuffer & ring);
+
+#endif
@@ -1,8 +1,22 @@
 #include <vector>
+#include <math.h>
 #include <glm/glm.hpp>
 
 #include "tangentspace.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGENTSPACE_SSE
+#include <emmintrin.h>
+#endif
+
+// Any unit vector perpendicular to n : the tangent of a vertex whose UVs don't give one
+static glm::vec3 perpendicularTo(const glm::vec3 & n){
+	glm::vec3 axis = fabsf(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::vec3 t = axis - n * glm::dot(n, axis);
+	float length = glm::length(t);
+	return length > 0.0f ? t / length : glm::vec3(1.0f, 0.0f, 0.0f);
+}
+
 void computeTangentBasis(
 	// inputs
 	std::vector<glm::vec3> & vertices,
@@ -33,7 +47,10 @@ void computeTangentBasis(
 		glm::vec2 deltaUV1 = uv1-uv0;
 		glm::vec2 deltaUV2 = uv2-uv0;
 
-		float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
+		// Degenerate UVs (all on a line, or all the same) : no direction at all.
+		// The tangent stays 0 here and gets an arbitrary one below.
+		float determinant = deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x;
+		float r = determinant != 0.0f ? 1.0f / determinant : 0.0f;
 		glm::vec3 tangent = (deltaPos1 * deltaUV2.y   - deltaPos2 * deltaUV1.y)*r;
 		glm::vec3 bitangent = (deltaPos2 * deltaUV1.x   - deltaPos1 * deltaUV2.x)*r;
 
@@ -58,7 +75,9 @@ void computeTangentBasis(
 		glm::vec3 & b = bitangents[i];
 		
 		// Gram-Schmidt orthogonalize
-		t = glm::normalize(t - n * glm::dot(n, t));
+		glm::vec3 orthogonal = t - n * glm::dot(n, t);
+		float length = glm::length(orthogonal);
+		t = length > 0.0f ? orthogonal / length : perpendicularTo(n);
 		
 		// Calculate handedness
 		if (glm::dot(glm::cross(n, t), b) < 0.0f){
@@ -71,3 +90,178 @@ void computeTangentBasis(
 }
 
 
+// Per vertex sums, one array per component so that the last pass can do 4 vertices at a time
+struct TangentSums {
+	std::vector<float> tx, ty, tz;
+	std::vector<float> bx, by, bz;
+};
+
+static inline float cornerAngle(const glm::vec3 & corner, const glm::vec3 & a, const glm::vec3 & b){
+	glm::vec3 e1 = a - corner, e2 = b - corner;
+	float lengths = glm::length(e1) * glm::length(e2);
+	if ( !(lengths > 0.0f) )
+		return 0.0f;
+	float c = glm::dot(e1, e2) / lengths;
+	return acosf(c < -1.0f ? -1.0f : c > 1.0f ? 1.0f : c);
+}
+
+template <typename Index>
+static void accumulateTangents(
+	const std::vector<Index> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	TangentWeighting weighting,
+	TangentSums & sums
+){
+	for ( size_t i=0; i+2<indices.size(); i+=3 ){
+		Index i0 = indices[i], i1 = indices[i+1], i2 = indices[i+2];
+		const glm::vec3 & v0 = vertices[i0], & v1 = vertices[i1], & v2 = vertices[i2];
+		glm::vec3 deltaPos1 = v1 - v0;
+		glm::vec3 deltaPos2 = v2 - v0;
+		glm::vec2 deltaUV1 = uvs[i1] - uvs[i0];
+		glm::vec2 deltaUV2 = uvs[i2] - uvs[i0];
+
+		// Same formula as above, but only the directions are kept : instead of dividing by the
+		// determinant (0 for degenerate UVs), use its sign, and normalize.
+		float determinant = deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x;
+		if ( determinant == 0.0f )
+			continue; // This face says nothing about the tangents
+		float sign = determinant > 0.0f ? 1.0f : -1.0f;
+		glm::vec3 tangent   = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y) * sign;
+		glm::vec3 bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x) * sign;
+		float tangentLength = glm::length(tangent), bitangentLength = glm::length(bitangent);
+		if ( !(tangentLength > 0.0f) || !(bitangentLength > 0.0f) )
+			continue;
+		tangent /= tangentLength;
+		bitangent /= bitangentLength;
+
+		float weights[3];
+		if ( weighting == TANGENT_WEIGHT_AREA ){
+			weights[0] = weights[1] = weights[2] = 0.5f * glm::length(glm::cross(deltaPos1, deltaPos2));
+		}else{
+			// By angle : a vertex gets as much of a face as the face covers around it
+			weights[0] = cornerAngle(v0, v1, v2);
+			weights[1] = cornerAngle(v1, v2, v0);
+			weights[2] = cornerAngle(v2, v0, v1);
+		}
+
+		const Index corners[3] = { i0, i1, i2 };
+		for ( int c=0; c<3; c++ ){
+			Index v = corners[c];
+			sums.tx[v] += tangent.x * weights[c];
+			sums.ty[v] += tangent.y * weights[c];
+			sums.tz[v] += tangent.z * weights[c];
+			sums.bx[v] += bitangent.x * weights[c];
+			sums.by[v] += bitangent.y * weights[c];
+			sums.bz[v] += bitangent.z * weights[c];
+		}
+	}
+}
+
+// Gram-Schmidt and handedness of vertex v, with the same operations as the SSE version.
+// Returns false if nothing is left of the tangent.
+static inline bool finishTangent(const TangentSums & sums, const glm::vec3 & n, size_t v, glm::vec4 & out){
+	float tx = sums.tx[v], ty = sums.ty[v], tz = sums.tz[v];
+	float d = n.x * tx + n.y * ty + n.z * tz;
+	tx = tx - n.x * d;
+	ty = ty - n.y * d;
+	tz = tz - n.z * d;
+	float length = sqrtf(tx * tx + ty * ty + tz * tz);
+	// cross(n, t) . b
+	float handedness = (n.y * tz - n.z * ty) * sums.bx[v] + (n.z * tx - n.x * tz) * sums.by[v] + (n.x * ty - n.y * tx) * sums.bz[v];
+	out = glm::vec4(tx / length, ty / length, tz / length, handedness < 0.0f ? -1.0f : 1.0f);
+	return length > 0.0f;
+}
+
+template <typename Index>
+static void computeTangentsT(
+	const std::vector<Index> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	std::vector<glm::vec4> & tangents,
+	TangentWeighting weighting
+){
+	size_t count = vertices.size();
+	TangentSums sums;
+	sums.tx.assign(count, 0.0f); sums.ty.assign(count, 0.0f); sums.tz.assign(count, 0.0f);
+	sums.bx.assign(count, 0.0f); sums.by.assign(count, 0.0f); sums.bz.assign(count, 0.0f);
+	accumulateTangents(indices, vertices, uvs, weighting, sums);
+
+	tangents.resize(count);
+	std::vector<size_t> degenerate; // Vertices without a usable tangent
+	size_t v = 0;
+
+#ifdef TANGENTSPACE_SSE
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f);
+	for ( ; v + 4 <= count; v += 4 ){
+		// The 4 normals, as 3 vectors of x, y and z
+		__m128 nx = _mm_setr_ps(normals[v].x, normals[v+1].x, normals[v+2].x, normals[v+3].x);
+		__m128 ny = _mm_setr_ps(normals[v].y, normals[v+1].y, normals[v+2].y, normals[v+3].y);
+		__m128 nz = _mm_setr_ps(normals[v].z, normals[v+1].z, normals[v+2].z, normals[v+3].z);
+		__m128 tx = _mm_loadu_ps(&sums.tx[v]), ty = _mm_loadu_ps(&sums.ty[v]), tz = _mm_loadu_ps(&sums.tz[v]);
+		__m128 bx = _mm_loadu_ps(&sums.bx[v]), by = _mm_loadu_ps(&sums.by[v]), bz = _mm_loadu_ps(&sums.bz[v]);
+
+		// Gram-Schmidt : t - n * dot(n, t), then normalize
+		__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+		tx = _mm_sub_ps(tx, _mm_mul_ps(nx, d));
+		ty = _mm_sub_ps(ty, _mm_mul_ps(ny, d));
+		tz = _mm_sub_ps(tz, _mm_mul_ps(nz, d));
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz)));
+
+		// Handedness : sign of cross(n, t) . b
+		__m128 cx = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+		__m128 cy = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+		__m128 cz = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+		__m128 handedness = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, bx), _mm_mul_ps(cy, by)), _mm_mul_ps(cz, bz));
+		__m128 negative = _mm_cmplt_ps(handedness, zero);
+		__m128 w = _mm_or_ps(_mm_and_ps(negative, minusOne), _mm_andnot_ps(negative, one));
+
+		// Transposed to x,y,z,w per vertex : straight into the output
+		__m128 x = _mm_div_ps(tx, length), y = _mm_div_ps(ty, length), z = _mm_div_ps(tz, length);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&tangents[v  ].x, x);
+		_mm_storeu_ps(&tangents[v+1].x, y);
+		_mm_storeu_ps(&tangents[v+2].x, z);
+		_mm_storeu_ps(&tangents[v+3].x, w);
+
+		int zeroLength = _mm_movemask_ps(_mm_cmple_ps(length, zero)) | _mm_movemask_ps(_mm_cmpunord_ps(length, length));
+		for ( int k=0; k<4; k++ )
+			if ( (zeroLength >> k) & 1 )
+				degenerate.push_back(v + k);
+	}
+#endif
+
+	// What's left, one by one
+	for ( ; v<count; v++ )
+		if ( !finishTangent(sums, normals[v], v, tangents[v]) )
+			degenerate.push_back(v);
+
+	// No face gave a direction, or it was along the normal : any tangent will do
+	for ( size_t k=0; k<degenerate.size(); k++ ){
+		size_t d = degenerate[k];
+		tangents[d] = glm::vec4(perpendicularTo(normals[d]), 1.0f);
+	}
+}
+
+void computeTangents(
+	const std::vector<unsigned short> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	std::vector<glm::vec4> & tangents,
+	TangentWeighting weighting
+){
+	computeTangentsT(indices, vertices, uvs, normals, tangents, weighting);
+}
+
+void computeTangents(
+	const std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	std::vector<glm::vec4> & tangents,
+	TangentWeighting weighting
+){
+	computeTangentsT(indices, vertices, uvs, normals, tangents, weighting);
+}
@@ -1,6 +1,7 @@
 #ifndef TANGENTSPACE_HPP
 #define TANGENTSPACE_HPP
 
+// On a triangle soup : one tangent and one bitangent per vertex, to be averaged by indexVBO_TBN.
 void computeTangentBasis(
 	// inputs
 	std::vector<glm::vec3> & vertices,
@@ -11,5 +12,33 @@ void computeTangentBasis(
 	std::vector<glm::vec3> & bitangents
 );
 
+// How much each face counts in the tangent of its vertices
+enum TangentWeighting {
+	TANGENT_WEIGHT_ANGLE,   // By the angle of the face at the vertex : doesn't depend on how the surface is triangulated
+	TANGENT_WEIGHT_AREA     // By the area of the face : cheaper
+};
+
+// On an indexed mesh (after indexVBO) : the tangents of the faces are summed into the shared
+// vertices, made orthogonal to the normals, and normalized. One glm::vec4 per vertex :
+// xyz is the tangent, w is +1 or -1, and bitangent = w * cross(normal, tangent) in the shader.
+// Faces with degenerate UVs are skipped; vertices without any tangent get one perpendicular
+// to the normal.
+void computeTangents(
+	const std::vector<unsigned short> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	std::vector<glm::vec4> & tangents,
+	TangentWeighting weighting = TANGENT_WEIGHT_ANGLE
+);
+
+void computeTangents(
+	const std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	std::vector<glm::vec4> & tangents,
+	TangentWeighting weighting = TANGENT_WEIGHT_ANGLE
+);
 
 #endif
\ No newline at end of file
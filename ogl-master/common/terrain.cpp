@@ -0,0 +1,557 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h> // for offsetof
+#include <math.h>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "vertexformat.hpp"
+#include "meshregistry.hpp"
+#include "frustum.hpp"
+#include "terrain.hpp"
+
+static const unsigned long long NO_CHUNK = ~0ULL;
+
+
+// ----- Heightfield -----
+
+static void resizeHeightfield(Heightfield & heightfield, int levels, float spacing){
+	heightfield.size = (TERRAIN_CHUNK_CELLS << levels) + 1;
+	heightfield.spacing = spacing;
+	heightfield.heights.assign(heightfield.size * heightfield.size, 0.0f);
+}
+
+// World position of sample i (same formula along X and Z)
+static float sampleToWorld(const Heightfield & heightfield, float i){
+	return (i - (heightfield.size - 1) * 0.5f) * heightfield.spacing;
+}
+
+// Pseudo-random value in [-1,1] for each integer lattice point
+static float latticeValue(int x, int z, unsigned int seed){
+	unsigned int h = (unsigned int)x * 374761393u + (unsigned int)z * 668265263u + seed * 2246822519u;
+	h = (h ^ (h >> 13)) * 1274126177u;
+	h ^= h >> 16;
+	return (h & 0xFFFFFF) / float(0x7FFFFF) - 1.0f;
+}
+
+// Smoothly interpolated value noise
+static float valueNoise(float x, float z, unsigned int seed){
+	int ix = (int)floorf(x), iz = (int)floorf(z);
+	float fx = x - ix, fz = z - iz;
+	fx = fx * fx * (3.0f - 2.0f * fx);
+	fz = fz * fz * (3.0f - 2.0f * fz);
+	float a = latticeValue(ix  , iz  , seed), b = latticeValue(ix+1, iz  , seed);
+	float c = latticeValue(ix  , iz+1, seed), d = latticeValue(ix+1, iz+1, seed);
+	return (a + (b-a)*fx) + ((c + (d-c)*fx) - (a + (b-a)*fx)) * fz;
+}
+
+void generateHeightfield(Heightfield & heightfield, int levels, float spacing, float amplitude, unsigned int seed, float flatRadius){
+	resizeHeightfield(heightfield, levels, spacing);
+
+	// Fractional Brownian motion : 6 octaves of noise, each twice as detailed and half as high
+	const float baseWavelength = 256.0f; // world units
+	for ( unsigned int j=0; j<heightfield.size; j++ ){
+		for ( unsigned int i=0; i<heightfield.size; i++ ){
+			float x = sampleToWorld(heightfield, (float)i);
+			float z = sampleToWorld(heightfield, (float)j);
+
+			float height = 0.0f, frequency = 1.0f / baseWavelength, weight = 1.0f;
+			for ( int octave=0; octave<6; octave++ ){
+				height += weight * valueNoise(x * frequency, z * frequency, seed + octave);
+				frequency *= 2.0f;
+				weight *= 0.5f;
+			}
+			height = (height * 0.5f + 0.5f) * amplitude; // Mostly above 0
+
+			// Flat ground around the launch pad, rising smoothly into the hills
+			if ( flatRadius > 0.0f ){
+				float t = (sqrtf(x*x + z*z) - flatRadius) / flatRadius;
+				t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+				height *= t * t * (3.0f - 2.0f * t);
+			}
+			heightfield.heights[j * heightfield.size + i] = height;
+		}
+	}
+}
+
+bool loadHeightfieldBMP(Heightfield & heightfield, const char * imagepath, int levels, float spacing, float heightScale){
+
+	printf("Reading height image %s\n", imagepath);
+
+	FILE * file = fopen(imagepath, "rb");
+	if ( !file ){
+		printf("%s could not be opened.\n", imagepath);
+		return false;
+	}
+
+	unsigned char header[54];
+	if ( fread(header, 1, 54, file) != 54 || header[0] != 'B' || header[1] != 'M' ){
+		printf("Not a correct BMP file\n");
+		fclose(file);
+		return false;
+	}
+	unsigned int dataPos = *(int*)&(header[0x0A]);
+	int width            = *(int*)&(header[0x12]);
+	int height           = *(int*)&(header[0x16]);
+	int bpp              = *(short*)&(header[0x1C]);
+	if ( *(int*)&(header[0x1E]) != 0 || (bpp != 8 && bpp != 24 && bpp != 32) || width <= 0 || height == 0 ){
+		printf("Unsupported BMP file : only uncompressed 8, 24 or 32 bits\n");
+		fclose(file);
+		return false;
+	}
+	bool topDown = height < 0; // Usually the last row comes first
+	if ( topDown ) height = -height;
+	if ( dataPos == 0 ) dataPos = 54;
+
+	int bytesPerPixel = bpp / 8;
+	int rowSize = (width * bytesPerPixel + 3) & ~3; // Rows are padded to 4 bytes
+	std::vector<unsigned char> data(rowSize * height);
+	fseek(file, dataPos, SEEK_SET);
+	size_t read = fread(&data[0], 1, data.size(), file);
+	fclose(file);
+	if ( read != data.size() ){
+		printf("Truncated BMP file\n");
+		return false;
+	}
+
+	// One gray level per pixel, the top row of the image first (toward -Z)
+	std::vector<float> gray(width * height);
+	for ( int y=0; y<height; y++ ){
+		const unsigned char * row = &data[(topDown ? y : height-1-y) * rowSize];
+		for ( int x=0; x<width; x++ ){
+			const unsigned char * pixel = row + x * bytesPerPixel;
+			// 8 bits : the palette index is used as the gray level, as height maps are saved
+			int sum = bytesPerPixel == 1 ? pixel[0] : (pixel[0] + pixel[1] + pixel[2]) / 3;
+			gray[y * width + x] = sum / 255.0f;
+		}
+	}
+
+	// Bilinear resampling to the terrain size
+	resizeHeightfield(heightfield, levels, spacing);
+	for ( unsigned int j=0; j<heightfield.size; j++ ){
+		float v = j * (height - 1) / float(heightfield.size - 1);
+		int y0 = (int)v; int y1 = y0 + 1 < height ? y0 + 1 : y0; float fy = v - y0;
+		for ( unsigned int i=0; i<heightfield.size; i++ ){
+			float u = i * (width - 1) / float(heightfield.size - 1);
+			int x0 = (int)u; int x1 = x0 + 1 < width ? x0 + 1 : x0; float fx = u - x0;
+			float top    = gray[y0*width + x0] + (gray[y0*width + x1] - gray[y0*width + x0]) * fx;
+			float bottom = gray[y1*width + x0] + (gray[y1*width + x1] - gray[y1*width + x0]) * fx;
+			heightfield.heights[j * heightfield.size + i] = (top + (bottom - top) * fy) * heightScale;
+		}
+	}
+	return true;
+}
+
+static float getSample(const Heightfield & heightfield, int i, int j){
+	int last = (int)heightfield.size - 1;
+	i = i < 0 ? 0 : (i > last ? last : i);
+	j = j < 0 ? 0 : (j > last ? last : j);
+	return heightfield.heights[j * heightfield.size + i];
+}
+
+float getTerrainHeight(const Heightfield & heightfield, float x, float z){
+	float u = x / heightfield.spacing + (heightfield.size - 1) * 0.5f;
+	float v = z / heightfield.spacing + (heightfield.size - 1) * 0.5f;
+	int i = (int)floorf(u), j = (int)floorf(v);
+	float fx = u - i, fz = v - j;
+	float top    = getSample(heightfield, i, j  ) + (getSample(heightfield, i+1, j  ) - getSample(heightfield, i, j  )) * fx;
+	float bottom = getSample(heightfield, i, j+1) + (getSample(heightfield, i+1, j+1) - getSample(heightfield, i, j+1)) * fx;
+	return top + (bottom - top) * fz;
+}
+
+
+// ----- Chunk triangles -----
+
+// Vertex (x,z) of the 33x33 chunk grid
+static unsigned short gridIndex(int x, int z){
+	return (unsigned short)(x + z * TERRAIN_CHUNK_VERTICES);
+}
+
+// A side of the chunk seen as if it was the -Z side : a is along the side, c goes inward.
+// Each side is a quarter turn of the previous one, so the triangles keep their winding.
+static unsigned short sideIndex(int side, int a, int c){
+	const int n = TERRAIN_CHUNK_CELLS;
+	switch ( side ){
+	case 0  : return gridIndex(a, c);         // -Z
+	case 1  : return gridIndex(n - c, a);     // +X
+	case 2  : return gridIndex(n - a, n - c); // +Z
+	default : return gridIndex(c, n - a);     // -X
+	}
+}
+
+static void pushTriangle(std::vector<unsigned short> & indices, unsigned short a, unsigned short b, unsigned short c){
+	indices.push_back(a);
+	indices.push_back(b);
+	indices.push_back(c);
+}
+
+// The triangles of a chunk. The border ring is made of 4 trapezoids, one per side; a side in
+// stitchMask only uses its even vertices, which are the vertices of the coarser neighbor.
+static void buildChunkIndices(int stitchMask, std::vector<unsigned short> & indices){
+	const int n = TERRAIN_CHUNK_CELLS;
+
+	// Inside : 2 triangles per cell, counter-clockwise seen from above
+	for ( int z=1; z<n-1; z++ ){
+		for ( int x=1; x<n-1; x++ ){
+			pushTriangle(indices, gridIndex(x, z), gridIndex(x, z+1), gridIndex(x+1, z+1));
+			pushTriangle(indices, gridIndex(x, z), gridIndex(x+1, z+1), gridIndex(x+1, z));
+		}
+	}
+
+	for ( int side=0; side<4; side++ ){
+		#define OUTER(a) sideIndex(side, (a), 0)
+		#define INNER(a) sideIndex(side, (a), 1)
+		if ( stitchMask & (1 << side) ){
+			// One triangle per coarse edge, fanning to the inner row...
+			for ( int a=0; a<n; a+=2 )
+				pushTriangle(indices, OUTER(a), INNER(a+1), OUTER(a+2));
+			// ...and the gaps between them
+			for ( int a=0; a<n-2; a+=2 ){
+				pushTriangle(indices, INNER(a+1), INNER(a+2), OUTER(a+2));
+				pushTriangle(indices, INNER(a+2), INNER(a+3), OUTER(a+2));
+			}
+		}else{
+			pushTriangle(indices, OUTER(0), INNER(1), OUTER(1));
+			for ( int a=1; a<n-1; a++ ){
+				pushTriangle(indices, OUTER(a), INNER(a), INNER(a+1));
+				pushTriangle(indices, OUTER(a), INNER(a+1), OUTER(a+1));
+			}
+			pushTriangle(indices, OUTER(n-1), INNER(n-1), OUTER(n));
+		}
+		#undef OUTER
+		#undef INNER
+	}
+}
+
+
+// ----- Quadtree -----
+
+static int chunkCount(int depth){
+	return 1 << depth; // Per side
+}
+
+static int chunkCells(const Terrain & terrain, int depth){
+	return TERRAIN_CHUNK_CELLS << (terrain.levels - depth);
+}
+
+void getTerrainChunkBounds(const Terrain & terrain, const TerrainChunk & chunk, glm::vec3 & boxMin, glm::vec3 & boxMax){
+	const Heightfield & heightfield = terrain.heightfield;
+	int cells = chunkCells(terrain, chunk.depth);
+	int index = chunk.x + chunk.z * chunkCount(chunk.depth);
+	boxMin = glm::vec3(sampleToWorld(heightfield, (float)chunk.x * cells), terrain.minHeight[chunk.depth][index], sampleToWorld(heightfield, (float)chunk.z * cells));
+	boxMax = glm::vec3(sampleToWorld(heightfield, (float)(chunk.x+1) * cells), terrain.maxHeight[chunk.depth][index], sampleToWorld(heightfield, (float)(chunk.z+1) * cells));
+}
+
+// Depth of the selected chunk that covers chunk (x,z) of the given depth, or depth if it is split further
+static int leafDepthAt(const Terrain & terrain, int depth, int x, int z){
+	for ( int d=0; d<depth; d++ ){
+		int shift = depth - d;
+		if ( !terrain.split[d][(x >> shift) + (z >> shift) * chunkCount(d)] )
+			return d;
+	}
+	return depth;
+}
+
+static void collectChunks(const Terrain & terrain, int depth, int x, int z, std::vector<TerrainChunk> & chunks){
+	if ( terrain.split[depth][x + z * chunkCount(depth)] ){
+		for ( int child=0; child<4; child++ )
+			collectChunks(terrain, depth+1, 2*x + (child & 1), 2*z + (child >> 1), chunks);
+		return;
+	}
+	TerrainChunk chunk;
+	chunk.depth = depth;
+	chunk.x = x;
+	chunk.z = z;
+	chunk.stitchMask = 0;
+	chunks.push_back(chunk);
+}
+
+static const int SIDE_DX[4] = { 0, 1, 0, -1 };
+static const int SIDE_DZ[4] = { -1, 0, 1, 0 };
+
+void initTerrain(Terrain & terrain, unsigned int maxChunks, float lodDistance){
+	const Heightfield & heightfield = terrain.heightfield;
+	terrain.levels = 0;
+	while ( (unsigned int)(TERRAIN_CHUNK_CELLS << terrain.levels) + 1 < heightfield.size )
+		terrain.levels++;
+	terrain.lodDistance = lodDistance;
+	terrain.maxChunks = maxChunks > 0 ? maxChunks : 1;
+	terrain.frame = 0;
+	terrain.chunkUploads = 0;
+	terrain.drawnTriangles = 0;
+
+	// Bounding boxes : exact for the finest chunks, then merged up to the root
+	terrain.split.resize(terrain.levels + 1);
+	terrain.minHeight.resize(terrain.levels + 1);
+	terrain.maxHeight.resize(terrain.levels + 1);
+	for ( int d=terrain.levels; d>=0; d-- ){
+		int count = chunkCount(d);
+		terrain.split[d].assign(count * count, 0);
+		terrain.minHeight[d].resize(count * count);
+		terrain.maxHeight[d].resize(count * count);
+		for ( int z=0; z<count; z++ ){
+			for ( int x=0; x<count; x++ ){
+				float low = 1e30f, high = -1e30f;
+				if ( d == terrain.levels ){
+					for ( int j=0; j<TERRAIN_CHUNK_VERTICES; j++ )
+						for ( int i=0; i<TERRAIN_CHUNK_VERTICES; i++ ){
+							float h = getSample(heightfield, x*TERRAIN_CHUNK_CELLS + i, z*TERRAIN_CHUNK_CELLS + j);
+							low = h < low ? h : low;
+							high = h > high ? h : high;
+						}
+				}else{
+					for ( int child=0; child<4; child++ ){
+						int index = (2*x + (child & 1)) + (2*z + (child >> 1)) * 2 * count;
+						low  = glm::min(low , terrain.minHeight[d+1][index]);
+						high = glm::max(high, terrain.maxHeight[d+1][index]);
+					}
+				}
+				terrain.minHeight[d][x + z*count] = low;
+				terrain.maxHeight[d][x + z*count] = high;
+			}
+		}
+	}
+
+	// The 16 index lists, one after the other in the same buffer
+	std::vector<unsigned short> indices;
+	for ( int mask=0; mask<16; mask++ ){
+		terrain.variantFirstIndex[mask] = (GLuint)indices.size();
+		buildChunkIndices(mask, indices);
+		terrain.variantIndexCount[mask] = (GLsizei)(indices.size() - terrain.variantFirstIndex[mask]);
+	}
+
+	TerrainSlot empty = { NO_CHUNK, 0 };
+	terrain.slots.assign(terrain.maxChunks, empty);
+	terrain.slotOfChunk.clear();
+
+	glGenVertexArrays(1, &terrain.vertexArrayID);
+	glBindVertexArray(terrain.vertexArrayID);
+
+	glGenBuffers(1, &terrain.vertexBufferID);
+	glBindBuffer(GL_ARRAY_BUFFER, terrain.vertexBufferID);
+	glBufferData(GL_ARRAY_BUFFER, terrain.maxChunks * TERRAIN_CHUNK_VERTICES * TERRAIN_CHUNK_VERTICES * sizeof(MeshVertex), NULL, GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &terrain.elementBufferID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrain.elementBufferID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0], GL_STATIC_DRAW);
+
+	// Same layout as the mesh registry : location 0 = position, location 1 = color
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, position));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (void*)offsetof(MeshVertex, color));
+
+	glBindVertexArray(0);
+}
+
+// Splits the chunks near the camera, as long as there are at most budget leaves
+static void splitByDistance(Terrain & terrain, glm::vec3 camera, unsigned int budget){
+	for ( int d=0; d<=terrain.levels; d++ )
+		std::fill(terrain.split[d].begin(), terrain.split[d].end(), 0);
+
+	// Breadth first, so that running out of chunks keeps the near detail everywhere at the same level
+	std::vector<TerrainChunk> current(1), next;
+	current[0].depth = 0; current[0].x = 0; current[0].z = 0; current[0].stitchMask = 0;
+	unsigned int leaves = 1;
+	for ( int d=0; d<terrain.levels; d++ ){
+		next.clear();
+		float size = chunkCells(terrain, d) * terrain.heightfield.spacing;
+		for ( size_t c=0; c<current.size(); c++ ){
+			glm::vec3 boxMin, boxMax;
+			getTerrainChunkBounds(terrain, current[c], boxMin, boxMax);
+			float distance = glm::length(camera - glm::clamp(camera, boxMin, boxMax));
+			if ( distance < terrain.lodDistance * size && leaves + 3 <= budget ){
+				terrain.split[d][current[c].x + current[c].z * chunkCount(d)] = 1;
+				leaves += 3;
+				for ( int child=0; child<4; child++ ){
+					TerrainChunk chunk = current[c];
+					chunk.depth = d + 1;
+					chunk.x = 2*current[c].x + (child & 1);
+					chunk.z = 2*current[c].z + (child >> 1);
+					next.push_back(chunk);
+				}
+			}
+		}
+		current.swap(next);
+	}
+}
+
+// Restricts to one level of difference between neighbors, splitting the coarse side until it
+// holds. Fills terrain.selected.
+static void balanceSplits(Terrain & terrain){
+	bool changed = true;
+	while ( changed ){
+		changed = false;
+		terrain.selected.clear();
+		collectChunks(terrain, 0, 0, 0, terrain.selected);
+		for ( size_t c=0; c<terrain.selected.size(); c++ ){
+			const TerrainChunk & chunk = terrain.selected[c];
+			int count = chunkCount(chunk.depth);
+			for ( int side=0; side<4; side++ ){
+				int x = chunk.x + SIDE_DX[side], z = chunk.z + SIDE_DZ[side];
+				if ( x < 0 || z < 0 || x >= count || z >= count )
+					continue;
+				int neighborDepth = leafDepthAt(terrain, chunk.depth, x, z);
+				if ( neighborDepth < chunk.depth - 1 ){
+					int shift = chunk.depth - neighborDepth;
+					terrain.split[neighborDepth][(x >> shift) + (z >> shift) * chunkCount(neighborDepth)] = 1;
+					changed = true;
+				}
+			}
+		}
+	}
+}
+
+void selectTerrainChunks(Terrain & terrain, glm::vec3 camera){
+	terrain.frame++;
+
+	// Balancing adds leaves the distance pass didn't count : if that goes over the pool, select
+	// again with that much less for the distance pass. The budget only goes down, and with
+	// budget 1 the whole terrain is one chunk, so this ends.
+	unsigned int budget = terrain.maxChunks;
+	for (;;) {
+		splitByDistance(terrain, camera, budget);
+		balanceSplits(terrain);
+		unsigned int selected = (unsigned int)terrain.selected.size();
+		if ( selected <= terrain.maxChunks || budget <= 1 )
+			break;
+		unsigned int excess = selected - terrain.maxChunks;
+		budget = budget > excess + 1 ? budget - excess : 1;
+	}
+
+	// Sides along a coarser neighbor get stitched
+	for ( size_t c=0; c<terrain.selected.size(); c++ ){
+		TerrainChunk & chunk = terrain.selected[c];
+		int count = chunkCount(chunk.depth);
+		for ( int side=0; side<4; side++ ){
+			int x = chunk.x + SIDE_DX[side], z = chunk.z + SIDE_DZ[side];
+			if ( x >= 0 && z >= 0 && x < count && z < count && leafDepthAt(terrain, chunk.depth, x, z) < chunk.depth )
+				chunk.stitchMask |= 1 << side;
+		}
+	}
+}
+
+// Colors the terrain by height, with the light baked in from the slope
+static glm::vec3 terrainColor(const Terrain & terrain, int i, int j, int stride){
+	const Heightfield & heightfield = terrain.heightfield;
+	float h = getSample(heightfield, i, j);
+	float low = terrain.minHeight[0][0], high = terrain.maxHeight[0][0];
+	float t = high > low ? (h - low) / (high - low) : 0.0f;
+
+	glm::vec3 grass(0.18f, 0.62f, 0.15f), rock(0.45f, 0.38f, 0.30f), snow(0.95f, 0.95f, 0.97f);
+	glm::vec3 color = t < 0.5f ? glm::mix(grass, rock, glm::smoothstep(0.3f, 0.5f, t))
+	                           : glm::mix(rock, snow, glm::smoothstep(0.75f, 0.85f, t));
+
+	float step = 2.0f * stride * heightfield.spacing;
+	glm::vec3 normal = glm::normalize(glm::vec3(
+		getSample(heightfield, i - stride, j) - getSample(heightfield, i + stride, j),
+		step,
+		getSample(heightfield, i, j - stride) - getSample(heightfield, i, j + stride)));
+	float light = glm::max(glm::dot(normal, glm::normalize(glm::vec3(0.4f, 1.0f, 0.3f))), 0.0f);
+	return color * (0.55f + 0.45f * light);
+}
+
+static void uploadChunk(const Terrain & terrain, const TerrainChunk & chunk, unsigned int slot){
+	const Heightfield & heightfield = terrain.heightfield;
+	int cells = chunkCells(terrain, chunk.depth);
+	int stride = cells / TERRAIN_CHUNK_CELLS;
+	int firstI = chunk.x * cells, firstJ = chunk.z * cells;
+
+	std::vector<MeshVertex> vertices(TERRAIN_CHUNK_VERTICES * TERRAIN_CHUNK_VERTICES);
+	for ( int z=0; z<TERRAIN_CHUNK_VERTICES; z++ ){
+		for ( int x=0; x<TERRAIN_CHUNK_VERTICES; x++ ){
+			int i = firstI + x * stride, j = firstJ + z * stride;
+			MeshVertex & vertex = vertices[gridIndex(x, z)];
+			vertex.position = glm::vec3(sampleToWorld(heightfield, (float)i), getSample(heightfield, i, j), sampleToWorld(heightfield, (float)j));
+			vertex.color = terrainColor(terrain, i, j, stride);
+		}
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, terrain.vertexBufferID);
+	glBufferSubData(GL_ARRAY_BUFFER, slot * vertices.size() * sizeof(MeshVertex), vertices.size() * sizeof(MeshVertex), &vertices[0]);
+}
+
+static unsigned long long chunkKey(const TerrainChunk & chunk){
+	return ((unsigned long long)chunk.depth << 48) | ((unsigned long long)chunk.x << 24) | (unsigned long long)chunk.z;
+}
+
+// Slot holding the chunk's vertices, filling the least recently used one if needed. Never -1 :
+// selectTerrainChunks keeps terrain.selected within maxChunks, the size of the pool.
+static int acquireChunkSlot(Terrain & terrain, const TerrainChunk & chunk){
+	unsigned long long key = chunkKey(chunk);
+	std::map<unsigned long long, unsigned int>::iterator it = terrain.slotOfChunk.find(key);
+	if ( it != terrain.slotOfChunk.end() ){
+		terrain.slots[it->second].lastUsedFrame = terrain.frame;
+		return (int)it->second;
+	}
+
+	int best = -1;
+	for ( unsigned int s=0; s<terrain.slots.size(); s++ ){
+		if ( terrain.slots[s].lastUsedFrame == terrain.frame && terrain.slots[s].key != NO_CHUNK )
+			continue; // Drawn this frame
+		if ( best < 0 || terrain.slots[s].lastUsedFrame < terrain.slots[best].lastUsedFrame )
+			best = (int)s;
+	}
+	if ( best < 0 )
+		return -1;
+
+	if ( terrain.slots[best].key != NO_CHUNK )
+		terrain.slotOfChunk.erase(terrain.slots[best].key);
+	terrain.slots[best].key = key;
+	terrain.slots[best].lastUsedFrame = terrain.frame;
+	terrain.slotOfChunk[key] = (unsigned int)best;
+	uploadChunk(terrain, chunk, (unsigned int)best);
+	terrain.chunkUploads++;
+	return best;
+}
+
+void drawTerrain(Terrain & terrain, const Frustum * frustum){
+	terrain.chunkUploads = 0;
+	terrain.drawnTriangles = 0;
+
+	unsigned int count = (unsigned int)terrain.selected.size();
+	terrain.chunkVisible.assign(count, 1);
+	terrain.chunkStats.visible = count;
+	if ( frustum != NULL && count > 0 ){
+		clearBoundingBoxes(terrain.chunkBoxes);
+		for ( unsigned int c=0; c<count; c++ ){
+			glm::vec3 boxMin, boxMax;
+			getTerrainChunkBounds(terrain, terrain.selected[c], boxMin, boxMax);
+			addBoundingBox(terrain.chunkBoxes, boxMin, boxMax);
+		}
+		terrain.chunkStats.visible = cullBoundingBoxes(*frustum, terrain.chunkBoxes, &terrain.chunkVisible[0]);
+	}
+	terrain.chunkStats.culled = count - terrain.chunkStats.visible;
+
+	glBindVertexArray(terrain.vertexArrayID);
+	for ( size_t c=0; c<count; c++ ){
+		if ( !terrain.chunkVisible[c] )
+			continue;
+		const TerrainChunk & chunk = terrain.selected[c];
+		int slot = acquireChunkSlot(terrain, chunk);
+
+		glDrawElementsBaseVertex(
+			GL_TRIANGLES,
+			terrain.variantIndexCount[chunk.stitchMask],
+			GL_UNSIGNED_SHORT, // 33*33 vertices per chunk : 16 bits are enough
+			(void*)(terrain.variantFirstIndex[chunk.stitchMask] * sizeof(unsigned short)),
+			slot * TERRAIN_CHUNK_VERTICES * TERRAIN_CHUNK_VERTICES
+		);
+		terrain.drawnTriangles += terrain.variantIndexCount[chunk.stitchMask] / 3;
+	}
+}
+
+void cleanupTerrain(Terrain & terrain){
+	glDeleteBuffers(1, &terrain.vertexBufferID);
+	glDeleteBuffers(1, &terrain.elementBufferID);
+	glDeleteVertexArrays(1, &terrain.vertexArrayID);
+	terrain.slots.clear();
+	terrain.slotOfChunk.clear();
+	terrain.selected.clear();
+}
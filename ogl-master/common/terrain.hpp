@@ -0,0 +1,93 @@
+#ifndef TERRAIN_HPP
+#define TERRAIN_HPP
+
+// Include meshregistry.hpp and frustum.hpp first : terrain vertices are MeshVertex (position + color).
+
+// Every chunk of the terrain is a grid of 32x32 cells, whatever its size :
+// a chunk twice as large samples the heightfield every other point.
+#define TERRAIN_CHUNK_CELLS    32
+#define TERRAIN_CHUNK_VERTICES (TERRAIN_CHUNK_CELLS + 1)
+
+// A square grid of heights, size x size samples, spacing units apart, centered on (0,0) in XZ.
+// size is always 32 * 2^levels + 1, so that the quadtree divides it exactly.
+struct Heightfield {
+	unsigned int size;
+	float spacing;
+	std::vector<float> heights; // size*size, row by row along X
+};
+
+// Fractal noise hills, flattened to height 0 within flatRadius of the origin (the launch pad)
+void generateHeightfield(Heightfield & heightfield, int levels, float spacing, float amplitude, unsigned int seed, float flatRadius);
+
+// Reads a grayscale (8 bits) or color (24/32 bits, averaged) .BMP as heights from 0 to heightScale.
+// The image is resampled to the terrain size, it doesn't need to match it.
+bool loadHeightfieldBMP(Heightfield & heightfield, const char * imagepath, int levels, float spacing, float heightScale);
+
+// Bilinear height at a world position. Outside the heightfield, the border height.
+float getTerrainHeight(const Heightfield & heightfield, float x, float z);
+
+
+// One chunk to draw this frame
+struct TerrainChunk {
+	int depth;          // 0 = the whole terrain
+	int x, z;           // Position among the 2^depth x 2^depth chunks of that depth
+	int stitchMask;     // Sides touching a coarser chunk : 1 = -Z, 2 = +X, 4 = +Z, 8 = -X
+};
+
+// A chunk vertex buffer, in the pool
+struct TerrainSlot {
+	unsigned long long key;      // Which chunk is in there, ~0 if none
+	unsigned int lastUsedFrame;
+};
+
+// The heightfield, split in a quadtree of chunks. Chunks near the camera are split down to full
+// resolution; further chunks are larger and coarser. Neighbors differ by one level at most,
+// and the edge of the finer one skips every other vertex, so that there are no cracks.
+// Only maxChunks chunk vertex buffers exist at any time : the least recently used one is recycled.
+struct Terrain {
+	Heightfield heightfield;
+	int levels;                   // Depth of the finest chunks
+	float lodDistance;            // Split a chunk when the camera is closer than lodDistance * its size
+
+	std::vector< std::vector<unsigned char> > split;     // Per depth, per chunk
+	std::vector< std::vector<float> > minHeight, maxHeight; // Per depth, per chunk : bounding boxes
+
+	std::vector<TerrainChunk> selected;
+
+	unsigned int maxChunks;
+	std::vector<TerrainSlot> slots;
+	std::map<unsigned long long, unsigned int> slotOfChunk;
+	unsigned int frame;
+
+	GLuint vertexArrayID;
+	GLuint vertexBufferID;        // maxChunks * 33*33 vertices
+	GLuint elementBufferID;       // The 16 stitching variants of the chunk triangles
+	GLuint variantFirstIndex[16];
+	GLsizei variantIndexCount[16];
+
+	// Frustum culling of the selected chunks
+	BoundingBoxes chunkBoxes;
+	std::vector<unsigned char> chunkVisible;
+
+	// Statistics of the last frame
+	unsigned int chunkUploads;
+	unsigned int drawnTriangles;
+	CullStats chunkStats;
+};
+
+// Call once the heightfield is filled
+void initTerrain(Terrain & terrain, unsigned int maxChunks = 256, float lodDistance = 1.5f);
+
+// Chooses the chunks to draw from the camera position. Never more than maxChunks, counting the
+// splits that keep neighbors within one level : with a small pool, the detail goes down instead.
+void selectTerrainChunks(Terrain & terrain, glm::vec3 camera);
+
+// Draws the selected chunks. The program and its MVP must be set; the model matrix is the identity.
+// With a frustum, the chunks outside of it are neither uploaded nor drawn.
+void drawTerrain(Terrain & terrain, const Frustum * frustum = NULL);
+
+void getTerrainChunkBounds(const Terrain & terrain, const TerrainChunk & chunk, glm::vec3 & boxMin, glm::vec3 & boxMax);
+
+void cleanupTerrain(Terrain & terrain);
+
+#endif
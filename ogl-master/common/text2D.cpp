@@ -1,4 +1,3 @@
-#include <vector>
 #include <cstring>
 
 #include <GL/glew.h>
@@ -9,23 +8,51 @@ using namespace glm;
 
 #include "shader.hpp"
 #include "texture.hpp"
+#include "sdffont.hpp"
+#include "streamingbuffer.hpp"
 
 #include "text2D.hpp"
 
+// Each segment of the ring holds up to TEXT2D_SEGMENT_GLYPHS glyphs : the draws fill it one after
+// the other, then the next segment is used. A batch of more glyphs is flushed early.
+#define TEXT2D_SEGMENT_GLYPHS 4096
+#define TEXT2D_SEGMENT_VERTICES (TEXT2D_SEGMENT_GLYPHS * 6)
+
+// Interleaved : attribute 0 is the position, attribute 1 the UV
+struct TextVertex {
+	glm::vec2 position;
+	glm::vec2 uv;
+};
+
 unsigned int Text2DTextureID;
-unsigned int Text2DVertexBufferID;
-unsigned int Text2DUVBufferID;
+StreamingBuffer Text2DBuffer;
 unsigned int Text2DShaderID;
 unsigned int Text2DUniformID;
+SDFFont Text2DFont;                     // Monospace for a bitmap font
+
+// The glyphs of the batch, copied into the buffer when it is drawn : the buffer is only mapped
+// for that copy
+TextVertex Text2DVertices[TEXT2D_SEGMENT_VERTICES];
+unsigned int Text2DVertexCount;
+unsigned int Text2DSegmentUsed;         // Vertices already drawn from the current segment
+bool Text2DBatching;                    // Between beginText2D and flushText2D
+
+static void initText2DBuffer(){
+
+	// Initialize VBO : the ring of segments
+	createStreamingBuffer(Text2DBuffer, GL_ARRAY_BUFFER, TEXT2D_SEGMENT_VERTICES * sizeof(TextVertex));
+	Text2DVertexCount = 0;
+	Text2DSegmentUsed = 0;
+	Text2DBatching = false;
+}
 
 void initText2D(const char * texturePath){
 
 	// Initialize texture
 	Text2DTextureID = loadDDS(texturePath);
+	initMonospaceFont(Text2DFont);
 
-	// Initialize VBO
-	glGenBuffers(1, &Text2DVertexBufferID);
-	glGenBuffers(1, &Text2DUVBufferID);
+	initText2DBuffer();
 
 	// Initialize Shader
 	Text2DShaderID = LoadShaders( "TextVertexShader.vertexshader", "TextVertexShader.fragmentshader" );
@@ -35,48 +62,57 @@ void initText2D(const char * texturePath){
 
 }
 
-void printText2D(const char * text, int x, int y, int size){
+void initText2DSDF(const char * atlasPath, const char * metricsPath){
 
-	unsigned int length = strlen(text);
+	// Initialize texture : the distances are filtered linearly, and never sampled from the next cell's
+	// mipmaps
+	Text2DTextureID = loadDDS(atlasPath);
+	glBindTexture(GL_TEXTURE_2D, Text2DTextureID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-	// Fill buffers
-	std::vector<glm::vec2> vertices;
-	std::vector<glm::vec2> UVs;
-	for ( unsigned int i=0 ; i<length ; i++ ){
-		
-		glm::vec2 vertex_up_left    = glm::vec2( x+i*size     , y+size );
-		glm::vec2 vertex_up_right   = glm::vec2( x+i*size+size, y+size );
-		glm::vec2 vertex_down_right = glm::vec2( x+i*size+size, y      );
-		glm::vec2 vertex_down_left  = glm::vec2( x+i*size     , y      );
+	// Without the metrics, still drawn, but as a monospace font
+	if ( !readSDFFont(metricsPath, Text2DFont) )
+		initMonospaceFont(Text2DFont);
 
-		vertices.push_back(vertex_up_left   );
-		vertices.push_back(vertex_down_left );
-		vertices.push_back(vertex_up_right  );
+	initText2DBuffer();
 
-		vertices.push_back(vertex_down_right);
-		vertices.push_back(vertex_up_right);
-		vertices.push_back(vertex_down_left);
+	// Initialize Shader
+	Text2DShaderID = LoadShaders( "TextSDFShader.vertexshader", "TextSDFShader.fragmentshader" );
 
-		char character = text[i];
-		float uv_x = (character%16)/16.0f;
-		float uv_y = (character/16)/16.0f;
+	// Initialize uniforms' IDs
+	Text2DUniformID = glGetUniformLocation( Text2DShaderID, "myTextureSampler" );
 
-		glm::vec2 uv_up_left    = glm::vec2( uv_x           , uv_y );
-		glm::vec2 uv_up_right   = glm::vec2( uv_x+1.0f/16.0f, uv_y );
-		glm::vec2 uv_down_right = glm::vec2( uv_x+1.0f/16.0f, (uv_y + 1.0f/16.0f) );
-		glm::vec2 uv_down_left  = glm::vec2( uv_x           , (uv_y + 1.0f/16.0f) );
-		UVs.push_back(uv_up_left   );
-		UVs.push_back(uv_down_left );
-		UVs.push_back(uv_up_right  );
+}
+
+// Draws the glyphs printed so far, from the free end of the current segment
+static void drawText2DBatch(){
+
+	if ( Text2DVertexCount == 0 )
+		return;
 
-		UVs.push_back(uv_down_right);
-		UVs.push_back(uv_up_right);
-		UVs.push_back(uv_down_left);
+	// Doesn't fit after what the GPU may still be reading : on to the next segment
+	if ( Text2DSegmentUsed + Text2DVertexCount > TEXT2D_SEGMENT_VERTICES ){
+		nextStreamingSegment(Text2DBuffer);
+		Text2DSegmentUsed = 0;
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DVertexBufferID);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), &vertices[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DUVBufferID);
-	glBufferData(GL_ARRAY_BUFFER, UVs.size() * sizeof(glm::vec2), &UVs[0], GL_STATIC_DRAW);
+	// The segment was last used 3 segments ago. If the GPU is still on it, the text is lost.
+	if ( !waitStreamingSegment(Text2DBuffer) ){
+		Text2DVertexCount = 0;
+		return;
+	}
+
+	// Mapped only for the copy
+	unsigned char * mapped = mapStreamingRange(Text2DBuffer, Text2DSegmentUsed * sizeof(TextVertex), Text2DVertexCount * sizeof(TextVertex));
+	if ( mapped == NULL ){
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		Text2DVertexCount = 0;
+		return;
+	}
+	memcpy(mapped, Text2DVertices, Text2DVertexCount * sizeof(TextVertex));
+	unmapStreamingRange(Text2DBuffer);
 
 	// Bind shader
 	glUseProgram(Text2DShaderID);
@@ -87,34 +123,89 @@ void printText2D(const char * text, int x, int y, int size){
 	// Set our "myTextureSampler" sampler to use Texture Unit 0
 	glUniform1i(Text2DUniformID, 0);
 
-	// 1rst attribute buffer : vertices
+	// 1rst attribute : vertices, 2nd attribute : UVs, interleaved in the same buffer (still bound)
 	glEnableVertexAttribArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DVertexBufferID);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
-
-	// 2nd attribute buffer : UVs
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)0 );
 	glEnableVertexAttribArray(1);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DUVBufferID);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)sizeof(glm::vec2) );
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	// Draw call
-	glDrawArrays(GL_TRIANGLES, 0, vertices.size() );
+	// One draw call for all the strings of the batch
+	GLint first = (GLint)(getStreamingSegmentOffset(Text2DBuffer) / sizeof(TextVertex) + Text2DSegmentUsed);
+	glDrawArrays(GL_TRIANGLES, first, Text2DVertexCount );
 
 	glDisable(GL_BLEND);
 
 	glDisableVertexAttribArray(0);
 	glDisableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	Text2DSegmentUsed += Text2DVertexCount;
+	Text2DVertexCount = 0;
+}
+
+void beginText2D(){
+	Text2DBatching = true;
+}
+
+void printText2D(const char * text, int x, int y, int size){
+
+	unsigned int length = strlen(text);
+
+	// Proportional fonts : the quad of a glyph starts before the pen by the margin of its cell
+	float pen = (float)x;
+
+	// Fill the batch
+	for ( unsigned int i=0 ; i<length ; i++ ){
+
+		if ( Text2DVertexCount + 6 > TEXT2D_SEGMENT_VERTICES )
+			drawText2DBatch();
+
+		unsigned char character = text[i];
+		const SDFGlyph & glyph = Text2DFont.glyphs[character];
+		float left = pen - glyph.left * size;
+		pen += glyph.advance * size;
+
+		glm::vec2 vertex_up_left    = glm::vec2( left     , y+size );
+		glm::vec2 vertex_up_right   = glm::vec2( left+size, y+size );
+		glm::vec2 vertex_down_right = glm::vec2( left+size, y      );
+		glm::vec2 vertex_down_left  = glm::vec2( left     , y      );
+
+		float uv_x = (character%16)/16.0f;
+		float uv_y = (character/16)/16.0f;
+
+		glm::vec2 uv_up_left    = glm::vec2( uv_x           , uv_y );
+		glm::vec2 uv_up_right   = glm::vec2( uv_x+1.0f/16.0f, uv_y );
+		glm::vec2 uv_down_right = glm::vec2( uv_x+1.0f/16.0f, (uv_y + 1.0f/16.0f) );
+		glm::vec2 uv_down_left  = glm::vec2( uv_x           , (uv_y + 1.0f/16.0f) );
+
+		TextVertex * vertex = Text2DVertices + Text2DVertexCount;
+		vertex[0].position = vertex_up_left;    vertex[0].uv = uv_up_left;
+		vertex[1].position = vertex_down_left;  vertex[1].uv = uv_down_left;
+		vertex[2].position = vertex_up_right;   vertex[2].uv = uv_up_right;
+
+		vertex[3].position = vertex_down_right; vertex[3].uv = uv_down_right;
+		vertex[4].position = vertex_up_right;   vertex[4].uv = uv_up_right;
+		vertex[5].position = vertex_down_left;  vertex[5].uv = uv_down_left;
+		Text2DVertexCount += 6;
+	}
+
+	if ( !Text2DBatching )
+		drawText2DBatch();
+}
 
+void flushText2D(){
+	drawText2DBatch();
+	Text2DBatching = false;
 }
 
 void cleanupText2D(){
 
 	// Delete buffers
-	glDeleteBuffers(1, &Text2DVertexBufferID);
-	glDeleteBuffers(1, &Text2DUVBufferID);
+	destroyStreamingBuffer(Text2DBuffer);
+	Text2DVertexCount = 0;
 
 	// Delete texture
 	glDeleteTextures(1, &Text2DTextureID);
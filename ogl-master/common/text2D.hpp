@@ -1,8 +1,26 @@
 #ifndef TEXT2D_HPP
 #define TEXT2D_HPP
 
+// 2D text in a 16x16 font texture. printText2D draws its string right away. To draw many
+// strings in one draw call, print them between beginText2D and flushText2D : the quads of the
+// glyphs are only collected, and drawn by the flush.
+//
+// The vertices go through a StreamingBuffer (streamingbuffer.hpp) : each draw appends to the
+// current segment, so that the GPU can still read the previous draws while the CPU writes.
+//
+// Either font, not both : initText2D for a bitmap font, drawn a whole cell per character, or
+// initText2DSDF for a signed distance field atlas and its metrics (see sdffont.hpp, made by
+// misc07_tools/fontsdf). The SDF one stays sharp from small to huge sizes, and is proportional.
+// Their shaders are TextVertexShader.* and TextSDFShader.*, in the working directory.
+
 void initText2D(const char * texturePath);
+void initText2DSDF(const char * atlasPath, const char * metricsPath);
+// Drawing leaves the program and GL_TEXTURE_2D of texture unit 0 changed, GL_ARRAY_BUFFER
+// unbound, attributes 0 and 1 disabled, and blending off
 void printText2D(const char * text, int x, int y, int size);
+// The next prints are drawn together by flushText2D (or earlier, if they don't fit in a segment)
+void beginText2D();
+void flushText2D();
 void cleanupText2D();
 
-#endif
\ No newline at end of file
+#endif
@@ -6,25 +6,26 @@
 
 #include <GLFW/glfw3.h>
 
+#include "mappedfile.hpp"
+#include "texture.hpp"
 
-GLuint loadBMP_custom(const char * imagepath){
+
+bool readBMP(const char * imagepath, TextureImage & image){
 
 	printf("Reading image %s\n", imagepath);
+	memset(&image, 0, sizeof(image));
 
 	// Data read from the header of the BMP file
 	unsigned char header[54];
 	unsigned int dataPos;
 	unsigned int imageSize;
 	unsigned int width, height;
-	// Actual RGB data
-	unsigned char * data;
 
 	// Open the file
 	FILE * file = fopen(imagepath,"rb");
 	if (!file){
 		printf("%s could not be opened. Are you in the right directory ? Don't forget to read the FAQ !\n", imagepath);
-		getchar();
-		return 0;
+		return false;
 	}
 
 	// Read the header, i.e. the 54 first bytes
@@ -33,17 +34,17 @@ GLuint loadBMP_custom(const char * imagepath){
 	if ( fread(header, 1, 54, file)!=54 ){ 
 		printf("Not a correct BMP file\n");
 		fclose(file);
-		return 0;
+		return false;
 	}
 	// A BMP files always begins with "BM"
 	if ( header[0]!='B' || header[1]!='M' ){
 		printf("Not a correct BMP file\n");
 		fclose(file);
-		return 0;
+		return false;
 	}
 	// Make sure this is a 24bpp file
-	if ( *(int*)&(header[0x1E])!=0  )         {printf("Not a correct BMP file\n");    fclose(file); return 0;}
-	if ( *(int*)&(header[0x1C])!=24 )         {printf("Not a correct BMP file\n");    fclose(file); return 0;}
+	if ( *(int*)&(header[0x1E])!=0  )         {printf("Not a correct BMP file\n");    fclose(file); return false;}
+	if ( *(int*)&(header[0x1C])!=24 )         {printf("Not a correct BMP file\n");    fclose(file); return false;}
 
 	// Read the information about the image
 	dataPos    = *(int*)&(header[0x0A]);
@@ -52,47 +53,231 @@ GLuint loadBMP_custom(const char * imagepath){
 	height     = *(int*)&(header[0x16]);
 
 	// Some BMP files are misformatted, guess missing information
-	if (imageSize==0)    imageSize=width*height*3; // 3 : one byte for each Red, Green and Blue component
 	if (dataPos==0)      dataPos=54; // The BMP header is done that way
+	// Each row is padded to 4 bytes, hence unpackAlignment = 4 below
+	unsigned int rowSize = (width*3 + 3) & ~3u; // 3 : one byte for each Red, Green and Blue component
+	if (imageSize < rowSize*height) imageSize = rowSize*height;
 
-	// Create a buffer
-	data = new unsigned char [imageSize];
-
-	// Read the actual data from the file into the buffer
-	fread(data,1,imageSize,file);
+	// Create a buffer, and read the actual data from the file into it
+	unsigned char * data = (unsigned char*)malloc(imageSize);
+	if ( width == 0 || height == 0 || !data || fseek(file, dataPos, SEEK_SET) != 0 || fread(data, 1, rowSize*height, file) != rowSize*height ){
+		printf("Not a correct BMP file\n");
+		free(data);
+		fclose(file);
+		return false;
+	}
 
 	// Everything is in memory now, the file can be closed.
 	fclose (file);
 
-	// Create one OpenGL texture
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-	
-	// "Bind" the newly created texture : all future texture functions will modify this texture
-	glBindTexture(GL_TEXTURE_2D, textureID);
-
-	// Give the image to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0,GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
+	image.target = GL_TEXTURE_2D;
+	image.internalFormat = GL_RGB;
+	image.format = GL_BGR;
+	image.type = GL_UNSIGNED_BYTE;
+	image.compressed = false;
+	image.generateMipmaps = true;
+	image.unpackAlignment = 4;
+	image.levelCount = 1;
+	image.levels[0].width = width;
+	image.levels[0].height = height;
+	image.levels[0].offset = 0;
+	image.levels[0].size = rowSize*height;
+	image.layers = 1;
+	image.faces = 1;
+	image.sliceSize = rowSize*height;
+	image.data = data;
+	image.dataSize = imageSize;
+	return true;
+}
 
+GLuint loadBMP_custom(const char * imagepath){
+	TextureImage image;
+	if ( !readBMP(imagepath, image) )
+		return 0;
+	GLuint textureID = createTexture(image);
 	// OpenGL has now copied the data. Free our own version
-	delete [] data;
+	freeTextureImage(image);
+	// Return the ID of the texture we just created
+	return textureID;
+}
+
+void freeTextureImage(TextureImage & image){
+	if ( image.file ){
+		closeMappedFile(*image.file);
+		delete image.file;
+		image.file = NULL;
+	}else{
+		free((void*)image.data);
+	}
+	image.data = NULL;
+	image.dataSize = 0;
+	image.levelCount = 0;
+}
+
+static void uploadLevel2D(GLenum target, const TextureImage & image, unsigned int level, const void * pixels){
+	const TextureLevel & l = image.levels[level];
+	if ( image.compressed )
+		glCompressedTexImage2D(target, level, image.internalFormat, l.width, l.height, 0, (GLsizei)l.size, pixels);
+	else
+		glTexImage2D(target, level, image.internalFormat, l.width, l.height, 0, image.format, image.type, pixels);
+}
+
+void uploadTextureLevel(const TextureImage & image, unsigned int level, const void * pixels){
+	glPixelStorei(GL_UNPACK_ALIGNMENT, image.unpackAlignment);
+	uploadLevel2D(GL_TEXTURE_2D, image, level, pixels);
+}
+
+// All the slices of one level of an array. OpenGL wants them next to each other, they aren't in
+// the file : the level is allocated first, then each slice is copied in.
+static void uploadLevelArray(const TextureImage & image, unsigned int level){
+	const TextureLevel & l = image.levels[level];
+	GLsizei depth = image.layers * image.faces;
+	if ( image.compressed )
+		glCompressedTexImage3D(image.target, level, image.internalFormat, l.width, l.height, depth, 0, (GLsizei)(l.size * depth), NULL);
+	else
+		glTexImage3D(image.target, level, image.internalFormat, l.width, l.height, depth, 0, image.format, image.type, NULL);
+	for ( GLsizei slice = 0; slice < depth; slice++ ){
+		const unsigned char * pixels = image.data + slice * image.sliceSize + l.offset;
+		if ( image.compressed )
+			glCompressedTexSubImage3D(image.target, level, 0, 0, slice, l.width, l.height, 1, image.internalFormat, (GLsizei)l.size, pixels);
+		else
+			glTexSubImage3D(image.target, level, 0, 0, slice, l.width, l.height, 1, image.format, image.type, pixels);
+	}
+}
+
+void finishTexture(const TextureImage & image){
+	if ( !image.generateMipmaps ){
+		// The levels of the file, and no others : the texture is complete even without a full chain
+		glTexParameteri(image.target, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(image.target, GL_TEXTURE_MAX_LEVEL, image.levelCount - 1);
+		return;
+	}
 
 	// Poor filtering, or ...
 	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); 
 
 	// ... nice trilinear filtering ...
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(image.target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(image.target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(image.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(image.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(image.target, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(image.target, GL_TEXTURE_MAX_LEVEL, 1000);
 	// ... which requires mipmaps. Generate them automatically.
-	glGenerateMipmap(GL_TEXTURE_2D);
+	glGenerateMipmap(image.target);
+}
 
-	// Return the ID of the texture we just created
+bool isTextureSupported(const TextureImage & image){
+	if ( image.target == GL_TEXTURE_CUBE_MAP_ARRAY && !GLEW_ARB_texture_cube_map_array ){
+		printf("Cubemap arrays need OpenGL 4.0\n");
+		return false;
+	}
+	switch ( image.internalFormat ){
+	case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB:
+	case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_ARB:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB:
+		if ( !GLEW_ARB_texture_compression_bptc ){
+			printf("BC6H and BC7 textures need OpenGL 4.2 or GL_ARB_texture_compression_bptc\n");
+			return false;
+		}
+		break;
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		if ( !GLEW_EXT_texture_sRGB ){
+			printf("sRGB DXT1, DXT3 and DXT5 textures need GL_EXT_texture_sRGB\n");
+			return false;
+		}
+		break;
+	}
+	return true;
+}
+
+GLuint createTexture(const TextureImage & image){
+	if ( !isTextureSupported(image) )
+		return 0;
+
+	// Create one OpenGL texture
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	
+	// "Bind" the newly created texture : all future texture functions will modify this texture
+	glBindTexture(image.target, textureID);
+
+	// Give the image to OpenGL
+	glPixelStorei(GL_UNPACK_ALIGNMENT, image.unpackAlignment);
+	for ( unsigned int level = 0; level < image.levelCount; level++ ){
+		if ( image.target == GL_TEXTURE_2D ){
+			uploadLevel2D(GL_TEXTURE_2D, image, level, image.data + image.levels[level].offset);
+		}else if ( image.target == GL_TEXTURE_CUBE_MAP ){
+			for ( unsigned int face = 0; face < 6; face++ )
+				uploadLevel2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, image, level, image.data + face * image.sliceSize + image.levels[level].offset);
+		}else{
+			uploadLevelArray(image, level);
+		}
+	}
+	finishTexture(image);
 	return textureID;
 }
 
+unsigned char * getRGBA8(const TextureImage & image){
+	const TextureLevel & level = image.levels[0];
+	bool bgr = image.format == GL_BGR || image.format == GL_RGB;
+	bool grey = image.format == GL_RED;
+	if ( image.compressed || image.type != GL_UNSIGNED_BYTE || !(bgr || grey || image.format == GL_RGBA) ){
+		printf("Only uncompressed BGR, RGB, RGBA8 and R8 images can be converted\n");
+		return NULL;
+	}
+	unsigned char * rgba = (unsigned char*)malloc((size_t)level.width * level.height * 4);
+	if ( !rgba )
+		return NULL;
+	if ( grey ){
+		// Grey : the red channel everywhere. The rows are not padded (unpackAlignment 1)
+		for ( size_t i=0; i<(size_t)level.width * level.height; i++ ){
+			rgba[4*i+0] = rgba[4*i+1] = rgba[4*i+2] = image.data[level.offset + i];
+			rgba[4*i+3] = 255;
+		}
+		return rgba;
+	}
+	if ( !bgr ){
+		memcpy(rgba, image.data + level.offset, (size_t)level.width * level.height * 4);
+		return rgba;
+	}
+	// Rows of 3 byte texels are padded to unpackAlignment
+	size_t rowSize = ((size_t)level.width * 3 + image.unpackAlignment - 1) / image.unpackAlignment * image.unpackAlignment;
+	int red = image.format == GL_BGR ? 2 : 0;
+	for ( unsigned int y=0; y<level.height; y++ ){
+		const unsigned char * in = image.data + level.offset + y * rowSize;
+		unsigned char * out = rgba + (size_t)y * level.width * 4;
+		for ( unsigned int x=0; x<level.width; x++ ){
+			out[4*x+0] = in[3*x+red];
+			out[4*x+1] = in[3*x+1];
+			out[4*x+2] = in[3*x+2-red];
+			out[4*x+3] = 255;
+		}
+	}
+	return rgba;
+}
+
+void downsampleRGBA8(const unsigned char * in, unsigned int width, unsigned int height, unsigned char * out){
+	unsigned int outWidth = width > 1 ? width / 2 : 1;
+	unsigned int outHeight = height > 1 ? height / 2 : 1;
+	for ( unsigned int y=0; y<outHeight; y++ ){
+		// A side of 1 stays 1 : the same texel twice
+		const unsigned char * row0 = in + (size_t)(2*y < height ? 2*y : height-1) * width * 4;
+		const unsigned char * row1 = in + (size_t)(2*y+1 < height ? 2*y+1 : height-1) * width * 4;
+		for ( unsigned int x=0; x<outWidth; x++ ){
+			unsigned int x0 = 2*x < width ? 2*x : width-1;
+			unsigned int x1 = 2*x+1 < width ? 2*x+1 : width-1;
+			for ( int c=0; c<4; c++ )
+				out[((size_t)y * outWidth + x) * 4 + c] = (unsigned char)((row0[4*x0+c] + row0[4*x1+c] + row1[4*x0+c] + row1[4*x1+c] + 2) >> 2);
+		}
+	}
+}
+
 // Since GLFW 3, glfwLoadTexture2D() has been removed. You have to use another texture loading library, 
 // or do it yourself (just like loadBMP_custom and loadDDS)
 //GLuint loadTGA_glfw(const char * imagepath){
@@ -123,96 +308,289 @@ GLuint loadBMP_custom(const char * imagepath){
 #define FOURCC_DXT1 0x31545844 // Equivalent to "DXT1" in ASCII
 #define FOURCC_DXT3 0x33545844 // Equivalent to "DXT3" in ASCII
 #define FOURCC_DXT5 0x35545844 // Equivalent to "DXT5" in ASCII
+#define FOURCC_ATI1 0x31495441 // BC4
+#define FOURCC_BC4U 0x55344342
+#define FOURCC_ATI2 0x32495441 // BC5
+#define FOURCC_BC5U 0x55354342
+#define FOURCC_DX10 0x30315844 // A DDS_HEADER_DXT10 follows the header
+
+// From the header
+#define DDSCAPS2_CUBEMAP          0x200
+#define DDSCAPS2_CUBEMAP_ALLFACES 0xFC00
+#define DDSCAPS2_VOLUME           0x200000
+
+// From the DX10 header
+#define DDS_DIMENSION_TEXTURE2D       3
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
+
+#define DXGI_FORMAT_R8G8B8A8_UNORM      28
+#define DXGI_FORMAT_R8G8B8A8_UNORM_SRGB 29
+#define DXGI_FORMAT_R8_UNORM            61
+#define DXGI_FORMAT_BC1_UNORM       71
+#define DXGI_FORMAT_BC1_UNORM_SRGB  72
+#define DXGI_FORMAT_BC2_UNORM       74
+#define DXGI_FORMAT_BC2_UNORM_SRGB  75
+#define DXGI_FORMAT_BC3_UNORM       77
+#define DXGI_FORMAT_BC3_UNORM_SRGB  78
+#define DXGI_FORMAT_BC4_UNORM       80
+#define DXGI_FORMAT_BC4_SNORM       81
+#define DXGI_FORMAT_BC5_UNORM       83
+#define DXGI_FORMAT_BC5_SNORM       84
+#define DXGI_FORMAT_BC6H_UF16       95
+#define DXGI_FORMAT_BC6H_SF16       96
+#define DXGI_FORMAT_BC7_UNORM       98
+#define DXGI_FORMAT_BC7_UNORM_SRGB  99
+
+static unsigned int readUint32(const unsigned char * bytes){
+	unsigned int value;
+	memcpy(&value, bytes, sizeof(value)); // The header fields aren't always aligned in memory
+	return value;
+}
 
-GLuint loadDDS(const char * imagepath){
-
-	unsigned char header[124];
-
-	FILE *fp; 
- 
-	/* try to open the file */ 
-	fp = fopen(imagepath, "rb"); 
-	if (fp == NULL){
-		printf("%s could not be opened. Are you in the right directory ? Don't forget to read the FAQ !\n", imagepath); getchar(); 
-		return 0;
-	}
-   
-	/* verify the type of file */ 
-	char filecode[4]; 
-	fread(filecode, 1, 4, fp); 
-	if (strncmp(filecode, "DDS ", 4) != 0) { 
-		fclose(fp); 
-		return 0; 
-	}
-	
-	/* get the surface desc */ 
-	fread(&header, 124, 1, fp); 
-
-	unsigned int height      = *(unsigned int*)&(header[8 ]);
-	unsigned int width	     = *(unsigned int*)&(header[12]);
-	unsigned int linearSize	 = *(unsigned int*)&(header[16]);
-	unsigned int mipMapCount = *(unsigned int*)&(header[24]);
-	unsigned int fourCC      = *(unsigned int*)&(header[80]);
-
- 
-	unsigned char * buffer;
-	unsigned int bufsize;
-	/* how big is it going to be including all mipmaps? */ 
-	bufsize = mipMapCount > 1 ? linearSize * 2 : linearSize; 
-	buffer = (unsigned char*)malloc(bufsize * sizeof(unsigned char)); 
-	fread(buffer, 1, bufsize, fp); 
-	/* close the file pointer */ 
-	fclose(fp);
-
-	unsigned int components  = (fourCC == FOURCC_DXT1) ? 3 : 4; 
-	unsigned int format;
+static GLenum getFourCCFormat(unsigned int fourCC){
 	switch(fourCC) 
 	{ 
-	case FOURCC_DXT1: 
-		format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; 
-		break; 
-	case FOURCC_DXT3: 
-		format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; 
-		break; 
-	case FOURCC_DXT5: 
-		format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; 
-		break; 
-	default: 
-		free(buffer); 
-		return 0; 
+	case FOURCC_DXT1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; 
+	case FOURCC_DXT3: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; 
+	case FOURCC_DXT5: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; 
+	case FOURCC_ATI1: 
+	case FOURCC_BC4U: return GL_COMPRESSED_RED_RGTC1;
+	case FOURCC_ATI2: 
+	case FOURCC_BC5U: return GL_COMPRESSED_RG_RGTC2;
+	default:          return 0;
 	}
+}
 
-	// Create one OpenGL texture
-	GLuint textureID;
-	glGenTextures(1, &textureID);
+// Bytes per 4x4 block
+static unsigned int getBlockSize(GLenum format){
+	switch(format)
+	{
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+		return 8;
+	default:
+		return 16;
+	}
+}
 
-	// "Bind" the newly created texture : all future texture functions will modify this texture
-	glBindTexture(GL_TEXTURE_2D, textureID);
-	glPixelStorei(GL_UNPACK_ALIGNMENT,1);	
-	
-	unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16; 
-	unsigned int offset = 0;
+// The DXGI formats we know, and their OpenGL equivalent
+static const struct { unsigned int dxgi; GLenum gl; } DXGIFormats[] = {
+	{ DXGI_FORMAT_R8G8B8A8_UNORM,      GL_RGBA8 },
+	{ DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, GL_SRGB8_ALPHA8 },
+	{ DXGI_FORMAT_R8_UNORM,            GL_R8 },
+	{ DXGI_FORMAT_BC1_UNORM,           GL_COMPRESSED_RGBA_S3TC_DXT1_EXT },
+	{ DXGI_FORMAT_BC1_UNORM_SRGB,      GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT },
+	{ DXGI_FORMAT_BC2_UNORM,           GL_COMPRESSED_RGBA_S3TC_DXT3_EXT },
+	{ DXGI_FORMAT_BC2_UNORM_SRGB,      GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT },
+	{ DXGI_FORMAT_BC3_UNORM,           GL_COMPRESSED_RGBA_S3TC_DXT5_EXT },
+	{ DXGI_FORMAT_BC3_UNORM_SRGB,      GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT },
+	{ DXGI_FORMAT_BC4_UNORM,           GL_COMPRESSED_RED_RGTC1 },
+	{ DXGI_FORMAT_BC4_SNORM,           GL_COMPRESSED_SIGNED_RED_RGTC1 },
+	{ DXGI_FORMAT_BC5_UNORM,           GL_COMPRESSED_RG_RGTC2 },
+	{ DXGI_FORMAT_BC5_SNORM,           GL_COMPRESSED_SIGNED_RG_RGTC2 },
+	{ DXGI_FORMAT_BC6H_UF16,           GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB },
+	{ DXGI_FORMAT_BC6H_SF16,           GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_ARB },
+	{ DXGI_FORMAT_BC7_UNORM,           GL_COMPRESSED_RGBA_BPTC_UNORM_ARB },
+	{ DXGI_FORMAT_BC7_UNORM_SRGB,      GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB },
+};
+
+static GLenum getDXGIFormat(unsigned int dxgiFormat){
+	for ( size_t i=0; i<sizeof(DXGIFormats)/sizeof(DXGIFormats[0]); i++ )
+		if ( DXGIFormats[i].dxgi == dxgiFormat )
+			return DXGIFormats[i].gl;
+	return 0;
+}
+
+static unsigned int getDXGIFromGL(GLenum format){
+	for ( size_t i=0; i<sizeof(DXGIFormats)/sizeof(DXGIFormats[0]); i++ )
+		if ( DXGIFormats[i].gl == format )
+			return DXGIFormats[i].dxgi;
+	return 0;
+}
+
+static bool isUncompressed(GLenum format){
+	return format == GL_RGBA8 || format == GL_SRGB8_ALPHA8 || format == GL_R8;
+}
+
+// Bytes of one level : whole 4x4 blocks, at least one, or 4 bytes per texel (1 for R8)
+static size_t getLevelSize(GLenum format, unsigned int width, unsigned int height){
+	if ( isUncompressed(format) )
+		return (size_t)width * height * (format == GL_R8 ? 1 : 4);
+	return (size_t)((width+3)/4)*((height+3)/4)*getBlockSize(format);
+}
+
+static bool failDDS(const char * imagepath, const char * reason, MappedFile * file){
+	printf("%s : %s\n", imagepath, reason);
+	closeMappedFile(*file);
+	delete file;
+	return false;
+}
+
+bool readDDS(const char * imagepath, TextureImage & image, bool asArray){
+
+	memset(&image, 0, sizeof(image));
 
-	/* load the mipmaps */ 
-	for (unsigned int level = 0; level < mipMapCount && (width || height); ++level) 
+	/* map the file : nothing is read until it's used */ 
+	MappedFile * file = new MappedFile;
+	if ( !openMappedFile(*file, imagepath) ){
+		printf("%s could not be opened. Are you in the right directory ? Don't forget to read the FAQ !\n", imagepath);
+		delete file;
+		return false;
+	}
+
+	/* verify the type of file, "DDS " then the 124 bytes of the surface desc */ 
+	if ( file->size < 128 || strncmp((const char*)file->data, "DDS ", 4) != 0 )
+		return failDDS(imagepath, "not a DDS file", file);
+	const unsigned char * header = file->data + 4;
+
+	unsigned int height      = readUint32(header + 8);
+	unsigned int width       = readUint32(header + 12);
+	unsigned int mipMapCount = readUint32(header + 24);
+	unsigned int fourCC      = readUint32(header + 80);
+	unsigned int caps2       = readUint32(header + 108);
+
+	size_t dataPos = 128;
+	unsigned int layers = 1;
+	bool cube = (caps2 & DDSCAPS2_CUBEMAP) != 0;
+	GLenum format;
+	if ( fourCC == FOURCC_DX10 ){
+		if ( file->size < 148 )
+			return failDDS(imagepath, "truncated DX10 header", file);
+		const unsigned char * dx10 = file->data + 128;
+		unsigned int dxgiFormat = readUint32(dx10);
+		unsigned int dimension  = readUint32(dx10 + 4);
+		unsigned int miscFlag   = readUint32(dx10 + 8);
+		unsigned int arraySize  = readUint32(dx10 + 12);
+		if ( dimension != DDS_DIMENSION_TEXTURE2D )
+			return failDDS(imagepath, "only 2D textures, arrays and cubemaps are supported", file);
+		cube = (miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+		layers = arraySize > 0 ? arraySize : 1;
+		format = getDXGIFormat(dxgiFormat);
+		dataPos = 148;
+	}else{
+		if ( caps2 & DDSCAPS2_VOLUME )
+			return failDDS(imagepath, "volume textures are not supported", file);
+		if ( cube && (caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES )
+			return failDDS(imagepath, "cubemaps without all 6 faces are not supported", file);
+		format = getFourCCFormat(fourCC);
+	}
+	if ( format == 0 )
+		return failDDS(imagepath, "only BC1 to BC7 (DXT1, DXT3, DXT5, ATI1, ATI2 or DX10) and DX10 RGBA8 and R8 are supported", file);
+	if ( width == 0 || height == 0 )
+		return failDDS(imagepath, "empty texture", file);
+
+	/* the exact size of each level */ 
+	if (mipMapCount == 0) mipMapCount = 1;
+	if (mipMapCount > TEXTURE_MAX_LEVELS) mipMapCount = TEXTURE_MAX_LEVELS;
+	size_t sliceSize = 0;
+	for (unsigned int level = 0; level < mipMapCount; ++level) 
 	{ 
-		unsigned int size = ((width+3)/4)*((height+3)/4)*blockSize; 
-		glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height,  
-			0, size, buffer + offset); 
-	 
-		offset += size; 
+		TextureLevel & l = image.levels[level];
+		l.width  = width;
+		l.height = height;
+		l.offset = sliceSize;
+		l.size   = getLevelSize(format, width, height);
+		sliceSize += l.size;
+
 		width  /= 2; 
 		height /= 2; 
-
 		// Deal with Non-Power-Of-Two textures. This code is not included in the webpage to reduce clutter.
 		if(width < 1) width = 1;
 		if(height < 1) height = 1;
+	}
 
-	} 
+	/* every layer, and every face of each layer, has its own mip chain */ 
+	unsigned int faces = cube ? 6 : 1;
+	size_t dataSize = sliceSize * faces * layers;
+	if ( dataSize / sliceSize / faces != layers || dataSize > file->size - dataPos )
+		return failDDS(imagepath, "truncated file", file);
+
+	/* an array of one layer looks like a plain texture : only the caller knows which it wants */ 
+	bool array = layers > 1 || (asArray && !cube);
+	image.target = cube ? (layers > 1 ? GL_TEXTURE_CUBE_MAP_ARRAY : GL_TEXTURE_CUBE_MAP)
+	                    : (array ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D);
+	image.internalFormat = format;
+	image.format = format == GL_R8 ? GL_RED : GL_RGBA;
+	image.type = GL_UNSIGNED_BYTE;
+	image.compressed = !isUncompressed(format);
+	image.generateMipmaps = false;
+	image.unpackAlignment = image.compressed || format == GL_R8 ? 1 : 4;
+	image.levelCount = mipMapCount;
+	image.layers = layers;
+	image.faces = faces;
+	image.sliceSize = sliceSize;
+	image.data = file->data + dataPos;
+	image.dataSize = dataSize;
+	image.file = file;
+	return true;
+}
 
-	free(buffer); 
+GLuint loadDDS(const char * imagepath){
+	TextureImage image;
+	if ( !readDDS(imagepath, image) )
+		return 0;
+	// The levels go to OpenGL straight from the mapping, no copy of the file in between
+	GLuint textureID = createTexture(image);
+	freeTextureImage(image); 
+	return textureID;
+}
 
+GLuint loadDDSArray(const char * imagepath){
+	TextureImage image;
+	if ( !readDDS(imagepath, image, true) )
+		return 0;
+	GLuint textureID = createTexture(image);
+	freeTextureImage(image); 
 	return textureID;
+}
 
+bool writeDDS(const char * imagepath, const TextureImage & image){
+	unsigned int dxgiFormat = getDXGIFromGL(image.internalFormat);
+	bool cube = image.target == GL_TEXTURE_CUBE_MAP || image.target == GL_TEXTURE_CUBE_MAP_ARRAY;
+	if ( dxgiFormat == 0 || image.generateMipmaps ){
+		printf("%s : only BC1 to BC7, RGBA8 and R8 images can be written\n", imagepath);
+		return false;
+	}
+	FILE * file = fopen(imagepath, "wb");
+	if ( !file ){
+		printf("%s could not be created\n", imagepath);
+		return false;
+	}
 
-}
\ No newline at end of file
+	// The old header when it's enough, like most tools write DXT files; the DX10 header for
+	// arrays, cubemaps and the formats the old one doesn't know
+	unsigned int fourCC = 0;
+	if ( image.target == GL_TEXTURE_2D ){
+		if ( image.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ) fourCC = FOURCC_DXT1;
+		if ( image.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT ) fourCC = FOURCC_DXT3;
+		if ( image.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ) fourCC = FOURCC_DXT5;
+	}
+	unsigned int header[31];
+	memset(header, 0, sizeof(header));
+	header[0]  = 124;
+	header[1]  = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000;            // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT
+	header[1] |= image.compressed ? 0x80000 : 0x8;              // LINEARSIZE : the size of level 0, or PITCH : of a row
+	header[2]  = image.levels[0].height;
+	header[3]  = image.levels[0].width;
+	header[4]  = (unsigned int)(image.compressed ? image.levels[0].size : image.levels[0].size / image.levels[0].height);
+	header[6]  = image.levelCount;
+	header[18] = 32;                                            // Size of the pixel format
+	header[19] = 0x4;                                           // DDPF_FOURCC
+	header[20] = fourCC ? fourCC : FOURCC_DX10;
+	header[26] = 0x1000 | (image.levelCount > 1 ? 0x400008 : 0); // TEXTURE, MIPMAP | COMPLEX
+	if ( cube )
+		header[27] = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES;
+	unsigned int dx10[5] = { dxgiFormat, DDS_DIMENSION_TEXTURE2D, cube ? (unsigned int)DDS_RESOURCE_MISC_TEXTURECUBE : 0, image.layers, 0 };
+
+	bool ok = fwrite("DDS ", 1, 4, file) == 4
+		&& fwrite(header, sizeof(header), 1, file) == 1
+		&& (fourCC || fwrite(dx10, sizeof(dx10), 1, file) == 1)
+		&& fwrite(image.data, 1, image.dataSize, file) == image.dataSize;
+	if ( fclose(file) != 0 || !ok ){
+		printf("%s : write error\n", imagepath);
+		return false;
+	}
+	return true;
+}
@@ -4,13 +4,82 @@
 // Load a .BMP file using our custom loader
 GLuint loadBMP_custom(const char * imagepath);
 
-//// Since GLFW 3, glfwLoadTexture2D() has been removed. You have to use another texture loading library, 
+//// Since GLFW 3, glfwLoadTexture2D() has been removed. You have to use another texture loading library,
 //// or do it yourself (just like loadBMP_custom and loadDDS)
 //// Load a .TGA file using GLFW's own loader
 //GLuint loadTGA_glfw(const char * imagepath);
 
 // Load a .DDS file using GLFW's own loader
 GLuint loadDDS(const char * imagepath);
+// The same, but always a GL_TEXTURE_2D_ARRAY (unless it is a cubemap), even with a single layer :
+// for a sampler2DArray, like the atlases of texturepacker.hpp
+GLuint loadDDSArray(const char * imagepath);
 
 
-#endif
\ No newline at end of file
+// The two steps of the loaders above, for those who want to read the file somewhere else
+// than on the render thread (see texturestreamer.hpp) : readBMP and readDDS don't call
+// OpenGL, createTexture does.
+//
+// readDDS maps the file in memory instead of reading it : the levels are given to OpenGL
+// straight from the mapping. It reads DXT1/3/5 (BC1-3), ATI1/ATI2 (BC4-5), and with the DX10
+// header BC1-BC7, RGBA8, R8, texture arrays and cubemaps (and cubemap arrays, which need OpenGL 4.0).
+
+#define TEXTURE_MAX_LEVELS 16
+
+// One mipmap level of the first slice, in TextureImage::data
+struct TextureLevel {
+	unsigned int width, height;
+	size_t offset;
+	size_t size;
+};
+
+struct MappedFile;
+
+struct TextureImage {
+	GLenum target;            // GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_CUBE_MAP_ARRAY
+	GLenum internalFormat;    // GL_RGB, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, ...
+	GLenum format, type;      // Of the data, for glTexImage2D. Unused when compressed.
+	bool compressed;
+	bool generateMipmaps;     // The file only has level 0
+	GLint unpackAlignment;    // Of the rows of the data
+	unsigned int levelCount;
+	TextureLevel levels[TEXTURE_MAX_LEVELS];
+	unsigned int layers;      // 1 when not an array
+	unsigned int faces;       // 6 for cubemaps, 1 otherwise
+	size_t sliceSize;         // All the levels of one face of one layer. Slice layer*faces+face starts at sliceSize*(layer*faces+face).
+	const unsigned char * data;
+	size_t dataSize;
+	MappedFile * file;        // NULL : data was malloc'ed
+};
+
+bool readBMP(const char * imagepath, TextureImage & image);
+// asArray : GL_TEXTURE_2D_ARRAY for a 2D texture of a single layer too, see loadDDSArray
+bool readDDS(const char * imagepath, TextureImage & image, bool asArray = false);
+// BC1-BC7, RGBA8 and R8 only, with all their levels. The DX10 header, unless the image is a
+// 2D DXT1, DXT3 or DXT5 one.
+bool writeDDS(const char * imagepath, const TextureImage & image);
+void freeTextureImage(TextureImage & image);
+
+// glTexImage2D or glCompressedTexImage2D for one level of a GL_TEXTURE_2D image, on the texture
+// bound to GL_TEXTURE_2D. pixels is either in memory, or an offset in the bound
+// GL_PIXEL_UNPACK_BUFFER.
+void uploadTextureLevel(const TextureImage & image, unsigned int level, const void * pixels);
+
+// Filtering and mipmaps, once all the levels are uploaded, on the texture bound to image.target
+void finishTexture(const TextureImage & image);
+
+// Level 0 as RGBA8, rows in the same order, alpha 255 for BGR, RGB and R8 (grey) images. Uncompressed
+// images only, otherwise NULL. free() it.
+unsigned char * getRGBA8(const TextureImage & image);
+
+// The next mipmap level, max(1, width/2) x max(1, height/2) : 2x2 box filter, like glGenerateMipmap
+void downsampleRGBA8(const unsigned char * in, unsigned int width, unsigned int height, unsigned char * out);
+
+// false, with a message, if this OpenGL can't have it : cubemap arrays without OpenGL 4.0, BC6H and
+// BC7 without GL_ARB_texture_compression_bptc, sRGB DXT1/3/5 without GL_EXT_texture_sRGB
+bool isTextureSupported(const TextureImage & image);
+
+// Any target. Returns 0 if !isTextureSupported(image).
+GLuint createTexture(const TextureImage & image);
+
+#endif
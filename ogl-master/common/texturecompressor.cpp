@@ -0,0 +1,465 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <GL/glew.h>
+
+#include "texture.hpp"
+#include "jobsystem.hpp"
+#include "texturecompressor.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURECOMPRESSOR_SSE
+#include <emmintrin.h>
+#endif
+
+// The 16 texels of a block as floats, one array per channel : ready for SSE
+struct ColorBlock {
+	float r[16], g[16], b[16];
+};
+
+static inline unsigned int quantize565(const float color[3]){
+	int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+	int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+	int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+	r = r < 0 ? 0 : r > 31 ? 31 : r;
+	g = g < 0 ? 0 : g > 63 ? 63 : g;
+	b = b < 0 ? 0 : b > 31 ? 31 : b;
+	return (unsigned int)((r << 11) | (g << 5) | b);
+}
+
+// The bits are repeated, like the GPU does : 31 is 255, not 248
+static inline void expand565(unsigned int color, int rgb[3]){
+	int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Index order of the block : c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+static void getPalette(unsigned int c0, unsigned int c1, float palette[4][3]){
+	int a[3], b[3];
+	expand565(c0, a);
+	expand565(c1, b);
+	for ( int c=0; c<3; c++ ){
+		palette[0][c] = (float)a[c];
+		palette[1][c] = (float)b[c];
+		palette[2][c] = (float)((2 * a[c] + b[c]) / 3);
+		palette[3][c] = (float)((a[c] + 2 * b[c]) / 3);
+	}
+}
+
+// The nearest palette color of each texel : 2 bits per texel, texel 0 in the low bits.
+// Returns the squared error. The distances are integers below 2^24, so the SSE and scalar
+// versions find exactly the same indices and error.
+static float chooseIndices(const ColorBlock & block, const float palette[4][3], unsigned int & indices){
+	indices = 0;
+	float error = 0.0f;
+	int i = 0;
+#ifdef TEXTURECOMPRESSOR_SSE
+	__m128 total = _mm_setzero_ps();
+	for ( ; i<16; i+=4 ){
+		__m128 r = _mm_loadu_ps(&block.r[i]), g = _mm_loadu_ps(&block.g[i]), b = _mm_loadu_ps(&block.b[i]);
+		__m128 best = _mm_set1_ps(3.0e38f);
+		__m128i bestIndex = _mm_setzero_si128();
+		for ( int p=0; p<4; p++ ){
+			__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p][0]));
+			__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p][1]));
+			__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p][2]));
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+			__m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+			best = _mm_min_ps(distance, best);
+			bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+		}
+		total = _mm_add_ps(total, best);
+		int chosen[4];
+		_mm_storeu_si128((__m128i*)chosen, bestIndex);
+		for ( int k=0; k<4; k++ )
+			indices |= (unsigned int)chosen[k] << (2 * (i + k));
+	}
+	float totals[4];
+	_mm_storeu_ps(totals, total);
+	error = (totals[0] + totals[1]) + (totals[2] + totals[3]);
+#endif
+	for ( ; i<16; i++ ){
+		float best = 3.0e38f;
+		unsigned int bestIndex = 0;
+		for ( int p=0; p<4; p++ ){
+			float dr = block.r[i] - palette[p][0], dg = block.g[i] - palette[p][1], db = block.b[i] - palette[p][2];
+			float distance = dr * dr + dg * dg + db * db;
+			if ( distance < best ){
+				best = distance;
+				bestIndex = p;
+			}
+		}
+		error += best;
+		indices |= bestIndex << (2 * i);
+	}
+	return error;
+}
+
+// The 2 colors that best fit the texels with these indices (least squares), or false if all the
+// texels chose the same weight
+static bool fitEndpoints(const ColorBlock & block, unsigned int indices, float c0[3], float c1[3]){
+	const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f }; // Of c0
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+	for ( int i=0; i<16; i++ ){
+		float a = weights[(indices >> (2 * i)) & 3], b = 1.0f - a;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		const float x[3] = { block.r[i], block.g[i], block.b[i] };
+		for ( int c=0; c<3; c++ ){
+			ax[c] += a * x[c];
+			bx[c] += b * x[c];
+		}
+	}
+	float determinant = aa * bb - ab * ab;
+	if ( fabsf(determinant) < 1e-6f )
+		return false;
+	for ( int c=0; c<3; c++ ){
+		c0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+		c1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+	}
+	return true;
+}
+
+// 4 color mode needs c0 > c1 : otherwise, swap them, and the indices 0<->1 and 2<->3
+static void writeColorBlock(unsigned int c0, unsigned int c1, unsigned int indices, unsigned char out[8]){
+	if ( c0 < c1 ){
+		unsigned int swap = c0; c0 = c1; c1 = swap;
+		indices ^= 0x55555555;
+	}else if ( c0 == c1 ){
+		indices = 0; // 3 color mode : index 3 would be transparent black
+	}
+	out[0] = (unsigned char)(c0 & 0xFF);
+	out[1] = (unsigned char)(c0 >> 8);
+	out[2] = (unsigned char)(c1 & 0xFF);
+	out[3] = (unsigned char)(c1 >> 8);
+	for ( int k=0; k<4; k++ )
+		out[4 + k] = (unsigned char)(indices >> (8 * k));
+}
+
+static void encodeColorBlock(const unsigned char texels[64], unsigned char out[8]){
+	ColorBlock block;
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	float low[3] = { 255.0f, 255.0f, 255.0f }, high[3] = { 0.0f, 0.0f, 0.0f };
+	for ( int i=0; i<16; i++ ){
+		block.r[i] = texels[4*i+0];
+		block.g[i] = texels[4*i+1];
+		block.b[i] = texels[4*i+2];
+		for ( int c=0; c<3; c++ ){
+			float value = texels[4*i+c];
+			mean[c] += value;
+			low[c] = value < low[c] ? value : low[c];
+			high[c] = value > high[c] ? value : high[c];
+		}
+	}
+	for ( int c=0; c<3; c++ )
+		mean[c] /= 16.0f;
+
+	// The principal axis of the colors : a few iterations of the covariance matrix on the
+	// diagonal of the bounding box
+	float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; // rr rg rb gg gb bb
+	for ( int i=0; i<16; i++ ){
+		float r = block.r[i] - mean[0], g = block.g[i] - mean[1], b = block.b[i] - mean[2];
+		covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+		covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+	}
+	float axis[3] = { high[0] - low[0], high[1] - low[1], high[2] - low[2] };
+	for ( int iteration=0; iteration<4; iteration++ ){
+		float x = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+		float y = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+		float z = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+		float largest = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+		if ( largest < 1e-6f )
+			break;
+		axis[0] = x / largest; axis[1] = y / largest; axis[2] = z / largest;
+	}
+
+	// The texels at both ends of the axis
+	int lowest = 0, highest = 0;
+	float lowestDot = 3.0e38f, highestDot = -3.0e38f;
+	for ( int i=0; i<16; i++ ){
+		float d = block.r[i] * axis[0] + block.g[i] * axis[1] + block.b[i] * axis[2];
+		if ( d < lowestDot )  { lowestDot = d;  lowest = i; }
+		if ( d > highestDot ) { highestDot = d; highest = i; }
+	}
+	float end0[3] = { block.r[highest], block.g[highest], block.b[highest] };
+	float end1[3] = { block.r[lowest],  block.g[lowest],  block.b[lowest]  };
+	unsigned int c0 = quantize565(end0), c1 = quantize565(end1);
+	float palette[4][3];
+	getPalette(c0, c1, palette);
+	unsigned int indices;
+	float error = chooseIndices(block, palette, indices);
+
+	// Refine : the colors that fit the chosen indices best, then the indices again
+	for ( int iteration=0; iteration<2 && error > 0.0f; iteration++ ){
+		if ( !fitEndpoints(block, indices, end0, end1) )
+			break;
+		unsigned int f0 = quantize565(end0), f1 = quantize565(end1);
+		if ( f0 == c0 && f1 == c1 )
+			break;
+		getPalette(f0, f1, palette);
+		unsigned int fitIndices;
+		float fitError = chooseIndices(block, palette, fitIndices);
+		if ( fitError >= error )
+			break;
+		c0 = f0; c1 = f1; indices = fitIndices; error = fitError;
+	}
+
+	writeColorBlock(c0, c1, indices, out);
+}
+
+// 8 levels from the highest alpha (a0) to the lowest (a1), 3 bits per texel
+static void encodeAlphaBlock(const unsigned char texels[64], unsigned char out[8]){
+	int low = 255, high = 0;
+	for ( int i=0; i<16; i++ ){
+		int a = texels[4*i+3];
+		low = a < low ? a : low;
+		high = a > high ? a : high;
+	}
+	out[0] = (unsigned char)high;
+	out[1] = (unsigned char)low;
+	unsigned long long bits = 0;
+	if ( high > low ){
+		for ( int i=0; i<16; i++ ){
+			// Level k of 7 from low to high; index 1 is a1 (k = 0), 0 is a0 (k = 7), 8-k in between
+			int k = ((texels[4*i+3] - low) * 14 + (high - low)) / (2 * (high - low));
+			unsigned long long index = k == 0 ? 1 : k == 7 ? 0 : 8 - k;
+			bits |= index << (3 * i);
+		}
+	}
+	for ( int k=0; k<6; k++ )
+		out[2 + k] = (unsigned char)(bits >> (8 * k));
+}
+
+void encodeBlockBC1(const unsigned char texels[64], unsigned char block[8]){
+	encodeColorBlock(texels, block);
+}
+
+void encodeBlockBC3(const unsigned char texels[64], unsigned char block[16]){
+	encodeAlphaBlock(texels, block);
+	encodeColorBlock(texels, block + 8);
+}
+
+static void decodeColorBlock(const unsigned char block[8], unsigned char texels[64], bool allowThreeColors){
+	unsigned int c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+	int a[3], b[3];
+	expand565(c0, a);
+	expand565(c1, b);
+	int palette[4][4];
+	for ( int c=0; c<3; c++ ){
+		palette[0][c] = a[c];
+		palette[1][c] = b[c];
+		if ( c0 > c1 || !allowThreeColors ){
+			palette[2][c] = (2 * a[c] + b[c]) / 3;
+			palette[3][c] = (a[c] + 2 * b[c]) / 3;
+		}else{
+			palette[2][c] = (a[c] + b[c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	palette[0][3] = palette[1][3] = palette[2][3] = 255;
+	palette[3][3] = (c0 > c1 || !allowThreeColors) ? 255 : 0;
+	unsigned int indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+	for ( int i=0; i<16; i++ )
+		for ( int c=0; c<4; c++ )
+			texels[4*i+c] = (unsigned char)palette[(indices >> (2 * i)) & 3][c];
+}
+
+void decodeBlockBC1(const unsigned char block[8], unsigned char texels[64]){
+	decodeColorBlock(block, texels, true);
+}
+
+void decodeBlockBC3(const unsigned char block[16], unsigned char texels[64]){
+	decodeColorBlock(block + 8, texels, false);
+	int a0 = block[0], a1 = block[1];
+	int levels[8] = { a0, a1 };
+	for ( int i=2; i<8; i++ ){
+		if ( a0 > a1 )
+			levels[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+		else
+			levels[i] = i < 6 ? ((6 - i) * a0 + (i - 1) * a1) / 5 : (i == 6 ? 0 : 255);
+	}
+	unsigned long long bits = 0;
+	for ( int k=0; k<6; k++ )
+		bits |= (unsigned long long)block[2 + k] << (8 * k);
+	for ( int i=0; i<16; i++ )
+		texels[4*i+3] = (unsigned char)levels[(bits >> (3 * i)) & 7];
+}
+
+// One level, encoded by rows of blocks
+struct LevelEncoding {
+	const unsigned char * texels;   // RGBA8
+	unsigned int width, height;
+	BlockFormat format;
+	unsigned char * out;
+};
+
+static void encodeBlockRows(void * data, unsigned int first, unsigned int last){
+	const LevelEncoding & level = *(const LevelEncoding*)data;
+	unsigned int blocksX = (level.width + 3) / 4;
+	size_t blockSize = level.format == BLOCK_BC1 ? 8 : 16;
+	unsigned char texels[64];
+	for ( unsigned int by=first; by<last; by++ ){
+		for ( unsigned int bx=0; bx<blocksX; bx++ ){
+			for ( unsigned int y=0; y<4; y++ ){
+				unsigned int ty = by * 4 + y < level.height ? by * 4 + y : level.height - 1;
+				for ( unsigned int x=0; x<4; x++ ){
+					unsigned int tx = bx * 4 + x < level.width ? bx * 4 + x : level.width - 1;
+					memcpy(&texels[(y * 4 + x) * 4], level.texels + ((size_t)ty * level.width + tx) * 4, 4);
+				}
+			}
+			unsigned char * block = level.out + ((size_t)by * blocksX + bx) * blockSize;
+			if ( level.format == BLOCK_BC1 )
+				encodeBlockBC1(texels, block);
+			else
+				encodeBlockBC3(texels, block);
+		}
+	}
+}
+
+bool compressTexture(const TextureImage & image, BlockFormat format, TextureImage & compressed, JobSystem * jobs, bool flipRows){
+	memset(&compressed, 0, sizeof(compressed));
+	if ( image.target != GL_TEXTURE_2D ){
+		printf("Only 2D textures can be compressed\n");
+		return false;
+	}
+	unsigned char * texels = getRGBA8(image);
+	if ( !texels )
+		return false;
+	unsigned int width = image.levels[0].width, height = image.levels[0].height;
+	if ( flipRows ){
+		size_t rowSize = (size_t)width * 4;
+		unsigned char * row = (unsigned char*)malloc(rowSize);
+		for ( unsigned int y=0; y<height/2; y++ ){
+			memcpy(row, texels + y * rowSize, rowSize);
+			memcpy(texels + y * rowSize, texels + (height - 1 - y) * rowSize, rowSize);
+			memcpy(texels + (height - 1 - y) * rowSize, row, rowSize);
+		}
+		free(row);
+	}
+
+	// All the levels, down to 1x1
+	unsigned int blockSize = format == BLOCK_BC1 ? 8 : 16;
+	unsigned int levelCount = 0;
+	size_t dataSize = 0;
+	for ( unsigned int w=width, h=height; levelCount<TEXTURE_MAX_LEVELS; levelCount++ ){
+		TextureLevel & level = compressed.levels[levelCount];
+		level.width = w;
+		level.height = h;
+		level.offset = dataSize;
+		level.size = (size_t)((w + 3) / 4) * ((h + 3) / 4) * blockSize;
+		dataSize += level.size;
+		if ( w == 1 && h == 1 ){
+			levelCount++;
+			break;
+		}
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+	unsigned char * data = (unsigned char*)malloc(dataSize);
+	unsigned char * smaller = (unsigned char*)malloc((size_t)(width / 2 + 1) * (height / 2 + 1) * 4);
+	if ( !data || !smaller ){
+		printf("Out of memory to compress a %ux%u texture\n", width, height);
+		free(data);
+		free(smaller);
+		free(texels);
+		return false;
+	}
+
+	for ( unsigned int l=0; l<levelCount; l++ ){
+		const TextureLevel & level = compressed.levels[l];
+		LevelEncoding encoding = { texels, level.width, level.height, format, data + level.offset };
+		unsigned int blocksY = (level.height + 3) / 4;
+		if ( jobs != NULL )
+			parallelFor(jobs, blocksY, 4, encodeBlockRows, &encoding);
+		else
+			encodeBlockRows(&encoding, 0, blocksY);
+
+		if ( l + 1 < levelCount ){
+			downsampleRGBA8(texels, level.width, level.height, smaller);
+			unsigned char * swap = texels; texels = smaller; smaller = swap;
+		}
+	}
+	free(texels);
+	free(smaller);
+
+	compressed.target = GL_TEXTURE_2D;
+	compressed.internalFormat = format == BLOCK_BC1 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	compressed.format = GL_RGBA;
+	compressed.type = GL_UNSIGNED_BYTE;
+	compressed.compressed = true;
+	compressed.generateMipmaps = false;
+	compressed.unpackAlignment = 1;
+	compressed.levelCount = levelCount;
+	compressed.layers = 1;
+	compressed.faces = 1;
+	compressed.sliceSize = dataSize;
+	compressed.data = data;
+	compressed.dataSize = dataSize;
+	compressed.file = NULL;
+	return true;
+}
+
+bool decompressTextureLevel(const TextureImage & compressed, unsigned int level, unsigned char * texels){
+	bool bc1 = compressed.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || compressed.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	bool bc3 = compressed.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	if ( (!bc1 && !bc3) || level >= compressed.levelCount ){
+		printf("Only the levels of BC1 and BC3 images can be decompressed\n");
+		return false;
+	}
+	const TextureLevel & l = compressed.levels[level];
+	unsigned int blocksX = (l.width + 3) / 4, blocksY = (l.height + 3) / 4;
+	size_t blockSize = bc1 ? 8 : 16;
+	unsigned char block[64];
+	for ( unsigned int by=0; by<blocksY; by++ ){
+		for ( unsigned int bx=0; bx<blocksX; bx++ ){
+			const unsigned char * in = compressed.data + l.offset + ((size_t)by * blocksX + bx) * blockSize;
+			if ( bc1 )
+				decodeBlockBC1(in, block);
+			else
+				decodeBlockBC3(in, block);
+			for ( unsigned int y=0; y<4 && by*4+y<l.height; y++ )
+				for ( unsigned int x=0; x<4 && bx*4+x<l.width; x++ )
+					memcpy(texels + ((size_t)(by*4+y) * l.width + bx*4+x) * 4, &block[(y * 4 + x) * 4], 4);
+		}
+	}
+	return true;
+}
+
+GLuint loadBMP_compressed(const char * imagepath, JobSystem * jobs){
+	TextureImage image, compressed;
+	if ( !readBMP(imagepath, image) )
+		return 0;
+	bool ok = compressTexture(image, BLOCK_BC1, compressed, jobs);
+	freeTextureImage(image);
+	if ( !ok )
+		return 0;
+	GLuint textureID = createTexture(compressed);
+	freeTextureImage(compressed);
+
+	// The same trilinear filtering as loadBMP_custom, on the mipmaps computed here
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	return textureID;
+}
+
+double computePSNR(const unsigned char * a, const unsigned char * b, size_t texelCount, bool alpha){
+	double sum = 0.0;
+	for ( size_t i=0; i<texelCount; i++ ){
+		for ( int c = alpha ? 3 : 0; c < (alpha ? 4 : 3); c++ ){
+			double d = (double)a[4*i+c] - (double)b[4*i+c];
+			sum += d * d;
+		}
+	}
+	double mse = sum / (double)(texelCount * (alpha ? 1 : 3));
+	if ( mse <= 0.0 )
+		return 100.0;
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
@@ -0,0 +1,41 @@
+#ifndef TEXTURECOMPRESSOR_HPP
+#define TEXTURECOMPRESSOR_HPP
+
+// BC1 (DXT1) and BC3 (DXT5) encoding on the CPU, so that BMP images take as little video memory
+// as DDS ones : 4 bits per texel in BC1 and 8 in BC3, instead of 24 or 32.
+//
+// Each 4x4 block gets 2 colors, on the principal axis of its texels, and 2 more in between;
+// each texel takes the nearest of the 4 (SSE, 4 texels at a time). A least squares fit of the
+// 2 colors to the chosen texels, then a second choice, usually improves it a little.
+// BC3 adds an alpha block : 8 levels between the lowest and highest alpha.
+struct JobSystem;
+
+enum BlockFormat {
+	BLOCK_BC1,     // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, opaque
+	BLOCK_BC3      // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+};
+
+// texels : 16 RGBA8 texels, row by row
+void encodeBlockBC1(const unsigned char texels[64], unsigned char block[8]);
+void encodeBlockBC3(const unsigned char texels[64], unsigned char block[16]);
+void decodeBlockBC1(const unsigned char block[8], unsigned char texels[64]);
+void decodeBlockBC3(const unsigned char block[16], unsigned char texels[64]);
+
+// An uncompressed image (see getRGBA8 in texture.hpp) to a compressed one with all its mipmap
+// levels (2x2 box filter, then encoded). Blocks at the right and top edges of sizes that are not
+// multiples of 4 repeat the last texels. jobs : NULL to encode on the calling thread only.
+// flipRows : top row first, like the DDS files of the tutorials (for which the OBJ loader inverts V).
+bool compressTexture(const TextureImage & image, BlockFormat format, TextureImage & compressed,
+	JobSystem * jobs = NULL, bool flipRows = false);
+
+// A level of a BC1 or BC3 image back to RGBA8 : texels holds width * height * 4 bytes
+bool decompressTextureLevel(const TextureImage & compressed, unsigned int level, unsigned char * texels);
+
+// Like loadBMP_custom, but BC1 on the GPU
+GLuint loadBMP_compressed(const char * imagepath, JobSystem * jobs = NULL);
+
+// Peak signal to noise ratio of b against a, in dB : over R, G and B, or over alpha only.
+// 100 when they are the same.
+double computePSNR(const unsigned char * a, const unsigned char * b, size_t texelCount, bool alpha);
+
+#endif
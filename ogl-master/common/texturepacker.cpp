@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "texture.hpp"
+#include "texturepacker.hpp"
+
+bool getAtlasSource(const TextureImage & image, AtlasSource & source){
+	unsigned char * rgba = getRGBA8(image);
+	if ( !rgba )
+		return false;
+	source.width = image.levels[0].width;
+	source.height = image.levels[0].height;
+	source.pixels.assign(rgba, rgba + (size_t)source.width * source.height * 4);
+	free(rgba);
+	return true;
+}
+
+// A row of cells of the same height at most, filled from left to right
+struct AtlasShelf {
+	unsigned int page;
+	unsigned int y, height;
+	unsigned int x;            // Where the next cell goes
+};
+
+struct CellOrder {
+	const std::vector<unsigned int> * widths;
+	const std::vector<unsigned int> * heights;
+	bool operator()(unsigned int a, unsigned int b) const {
+		if ( (*heights)[a] != (*heights)[b] ) return (*heights)[a] > (*heights)[b];
+		if ( (*widths)[a] != (*widths)[b] )   return (*widths)[a] > (*widths)[b];
+		return a < b;
+	}
+};
+
+static unsigned int roundUp(unsigned int value, unsigned int multiple){
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+bool packTextureAtlas(const std::vector<AtlasSource> & sources, unsigned int pageSize, unsigned int levelCount,
+	TextureImage & atlas, std::vector<AtlasRect> & rects){
+
+	memset(&atlas, 0, sizeof(atlas));
+	rects.clear();
+	if ( pageSize == 0 || (pageSize & (pageSize - 1)) != 0 ){
+		printf("The page size of an atlas must be a power of two\n");
+		return false;
+	}
+	unsigned int maxLevels = 1;
+	while ( (pageSize >> maxLevels) > 0 ) maxLevels++;
+	if ( levelCount < 1 ) levelCount = 1;
+	if ( levelCount > maxLevels ) levelCount = maxLevels;
+	if ( levelCount > TEXTURE_MAX_LEVELS ) levelCount = TEXTURE_MAX_LEVELS;
+
+	// Every cell starts on a multiple of align texels and is a multiple of align wide : at level
+	// levelCount-1, each texel is made of the texels of one cell only. Linear filtering there reads
+	// the next texel once the sample is less than half a texel from its edge : a gutter of half a
+	// texel of that level keeps the image itself far enough from the neighbour.
+	unsigned int align = 1u << (levelCount - 1);
+	unsigned int gutter = align > 1 ? align / 2 : 1;
+	std::vector<unsigned int> cellWidths(sources.size()), cellHeights(sources.size()), order(sources.size());
+	for ( size_t i=0; i<sources.size(); i++ ){
+		cellWidths[i]  = roundUp(sources[i].width  + 2 * gutter, align);
+		cellHeights[i] = roundUp(sources[i].height + 2 * gutter, align);
+		if ( cellWidths[i] > pageSize || cellHeights[i] > pageSize ){
+			printf("Image %u (%ux%u) doesn't fit in a %u atlas page with a %u texel gutter\n",
+				(unsigned int)i, sources[i].width, sources[i].height, pageSize, gutter);
+			return false;
+		}
+		order[i] = (unsigned int)i;
+	}
+
+	// Shelf packing, tallest first : each image goes on the lowest shelf it fits on,
+	// or on a new shelf, or on a new page
+	CellOrder compare = { &cellWidths, &cellHeights };
+	std::sort(order.begin(), order.end(), compare);
+	std::vector<AtlasShelf> shelves;
+	std::vector<unsigned int> pageTops; // First free row of each page
+	rects.resize(sources.size());
+	for ( size_t o=0; o<order.size(); o++ ){
+		unsigned int i = order[o];
+		int best = -1;
+		for ( size_t s=0; s<shelves.size(); s++ ){
+			if ( shelves[s].height >= cellHeights[i] && shelves[s].x + cellWidths[i] <= pageSize
+				&& (best < 0 || shelves[s].height < shelves[best].height) )
+				best = (int)s;
+		}
+		if ( best < 0 ){
+			unsigned int page = 0;
+			while ( page < pageTops.size() && pageTops[page] + cellHeights[i] > pageSize )
+				page++;
+			if ( page == pageTops.size() )
+				pageTops.push_back(0);
+			AtlasShelf shelf = { page, pageTops[page], cellHeights[i], 0 };
+			pageTops[page] += cellHeights[i];
+			shelves.push_back(shelf);
+			best = (int)shelves.size() - 1;
+		}
+		AtlasShelf & shelf = shelves[best];
+		AtlasRect & rect = rects[i];
+		rect.layer  = shelf.page;
+		rect.x      = shelf.x + gutter;
+		rect.y      = shelf.y + gutter;
+		rect.width  = sources[i].width;
+		rect.height = sources[i].height;
+		rect.uvOffset = glm::vec2(rect.x, rect.y) / (float)pageSize;
+		rect.uvScale  = glm::vec2(rect.width, rect.height) / (float)pageSize;
+		shelf.x += cellWidths[i];
+	}
+
+	// The pages, with all their levels, one after the other like in a DDS file
+	unsigned int layers = pageTops.empty() ? 1 : (unsigned int)pageTops.size();
+	size_t sliceSize = 0;
+	for ( unsigned int level=0; level<levelCount; level++ ){
+		unsigned int size = pageSize >> level;
+		atlas.levels[level].width  = size;
+		atlas.levels[level].height = size;
+		atlas.levels[level].offset = sliceSize;
+		atlas.levels[level].size   = (size_t)size * size * 4;
+		sliceSize += atlas.levels[level].size;
+	}
+	unsigned char * data = (unsigned char*)calloc(sliceSize * layers, 1);
+	if ( !data ){
+		printf("Out of memory for %u atlas pages\n", layers);
+		rects.clear();
+		return false;
+	}
+
+	// Level 0 : each image, and around it the gutter, filled with copies of its borders
+	for ( size_t i=0; i<sources.size(); i++ ){
+		const AtlasRect & rect = rects[i];
+		const AtlasSource & source = sources[i];
+		unsigned char * page = data + rect.layer * sliceSize;
+		unsigned int cellX = rect.x - gutter, cellY = rect.y - gutter;
+		for ( unsigned int y=cellY; y<cellY+cellHeights[i]; y++ ){
+			int sy = glm::clamp((int)y - (int)rect.y, 0, (int)source.height - 1);
+			for ( unsigned int x=cellX; x<cellX+cellWidths[i]; x++ ){
+				int sx = glm::clamp((int)x - (int)rect.x, 0, (int)source.width - 1);
+				memcpy(page + ((size_t)y * pageSize + x) * 4, &source.pixels[((size_t)sy * source.width + sx) * 4], 4);
+			}
+		}
+	}
+
+	// The other levels : 2x2 box filter, like glGenerateMipmap
+	for ( unsigned int layer=0; layer<layers; layer++ ){
+		unsigned char * page = data + layer * sliceSize;
+		for ( unsigned int level=1; level<levelCount; level++ )
+			downsampleRGBA8(page + atlas.levels[level-1].offset, atlas.levels[level-1].width, atlas.levels[level-1].height,
+				page + atlas.levels[level].offset);
+	}
+
+	atlas.target = GL_TEXTURE_2D_ARRAY;
+	atlas.internalFormat = GL_RGBA8;
+	atlas.format = GL_RGBA;
+	atlas.type = GL_UNSIGNED_BYTE;
+	atlas.compressed = false;
+	atlas.generateMipmaps = false;
+	atlas.unpackAlignment = 4;
+	atlas.levelCount = levelCount;
+	atlas.layers = layers;
+	atlas.faces = 1;
+	atlas.sliceSize = sliceSize;
+	atlas.data = data;
+	atlas.dataSize = sliceSize * layers;
+	atlas.file = NULL;
+	return true;
+}
+
+bool packTextureArray(const std::vector<TextureImage> & images, TextureImage & array, std::vector<AtlasRect> & rects){
+	memset(&array, 0, sizeof(array));
+	rects.clear();
+	if ( images.empty() )
+		return false;
+	const TextureImage & first = images[0];
+	for ( size_t i=0; i<images.size(); i++ ){
+		const TextureImage & image = images[i];
+		if ( image.target != GL_TEXTURE_2D || image.internalFormat != first.internalFormat || image.format != first.format
+			|| image.levelCount != first.levelCount || image.levels[0].width != first.levels[0].width
+			|| image.levels[0].height != first.levels[0].height ){
+			printf("Image %u : the images of an array must all be 2D, of the same size, format and number of levels\n", (unsigned int)i);
+			return false;
+		}
+	}
+
+	unsigned char * data = (unsigned char*)malloc(first.sliceSize * images.size());
+	if ( !data ){
+		printf("Out of memory for %u layers\n", (unsigned int)images.size());
+		return false;
+	}
+	for ( size_t i=0; i<images.size(); i++ ){
+		memcpy(data + i * first.sliceSize, images[i].data, first.sliceSize);
+		AtlasRect rect = { (unsigned int)i, 0, 0, first.levels[0].width, first.levels[0].height, glm::vec2(0.0f), glm::vec2(1.0f) };
+		rects.push_back(rect);
+	}
+
+	array = first;
+	array.target = GL_TEXTURE_2D_ARRAY;
+	array.layers = (unsigned int)images.size();
+	array.faces = 1;
+	array.data = data;
+	array.dataSize = first.sliceSize * images.size();
+	array.file = NULL;
+	return true;
+}
+
+void remapAtlasUVs(std::vector<glm::vec2> & uvs, const AtlasRect & rect){
+	for ( size_t i=0; i<uvs.size(); i++ )
+		uvs[i] = rect.uvOffset + uvs[i] * rect.uvScale;
+}
+
+bool writeAtlasRects(const char * path, const std::vector<std::string> & names, const std::vector<AtlasRect> & rects){
+	FILE * file = fopen(path, "w");
+	if ( !file ){
+		printf("%s could not be created\n", path);
+		return false;
+	}
+	for ( size_t i=0; i<rects.size(); i++ ){
+		const AtlasRect & r = rects[i];
+		// The name last : it is the rest of the line, spaces included
+		std::string name = i < names.size() ? names[i] : "";
+		std::replace(name.begin(), name.end(), '\n', ' ');
+		std::replace(name.begin(), name.end(), '\r', ' ');
+		fprintf(file, "%u %u %u %u %u %.9g %.9g %.9g %.9g %s\n", r.layer, r.x, r.y, r.width, r.height,
+			r.uvOffset.x, r.uvOffset.y, r.uvScale.x, r.uvScale.y, name.c_str());
+	}
+	return fclose(file) == 0;
+}
+
+bool readAtlasRects(const char * path, std::vector<std::string> & names, std::vector<AtlasRect> & rects){
+	FILE * file = fopen(path, "r");
+	if ( !file ){
+		printf("%s could not be opened. Are you in the right directory ?\n", path);
+		return false;
+	}
+	names.clear();
+	rects.clear();
+	bool ok = true;
+	std::string line;
+	int c;
+	do {
+		c = getc(file);
+		if ( c != '\n' && c != EOF ){
+			line += (char)c;
+			continue;
+		}
+		if ( !line.empty() && line[line.size() - 1] == '\r' )
+			line.erase(line.size() - 1);
+		if ( !line.empty() ){
+			AtlasRect r;
+			int nameStart = -1;
+			ok = sscanf(line.c_str(), "%u %u %u %u %u %f %f %f %f%n", &r.layer, &r.x, &r.y, &r.width, &r.height,
+				&r.uvOffset.x, &r.uvOffset.y, &r.uvScale.x, &r.uvScale.y, &nameStart) == 9 && nameStart >= 0
+				&& line[nameStart] == ' ';
+			if ( !ok )
+				break;
+			// Only the one space writeAtlasRects puts before the name : the name may start with more
+			names.push_back(line.substr(nameStart + 1));
+			rects.push_back(r);
+		}
+		line.clear();
+	} while ( c != EOF );
+	fclose(file);
+	if ( !ok )
+		printf("%s : not an atlas description\n", path);
+	return ok;
+}
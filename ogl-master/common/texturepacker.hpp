@@ -0,0 +1,53 @@
+#ifndef TEXTUREPACKER_HPP
+#define TEXTUREPACKER_HPP
+
+// Many textures in one GL_TEXTURE_2D_ARRAY, so that objects with different textures can be
+// drawn without a glBindTexture between them. Two ways to fill the array :
+//
+//   packTextureAtlas : small RGBA8 images, packed in pages (the layers of the array). Each
+//                      image is surrounded by a gutter of copies of its borders, in a cell that
+//                      starts on a multiple of 2^(levelCount-1) texels : down to the last mipmap
+//                      level, filtering never reads a texel of the neighbour. UVs must stay in
+//                      [0,1] (no GL_REPEAT); remap them with remapAtlasUVs.
+//   packTextureArray : images of the same size and format, one per layer, as they are : works
+//                      for compressed DDS files too, and UVs don't change.
+//
+// The result is a TextureImage (see texture.hpp) : createTexture makes the array, writeDDS
+// saves it (see misc07_tools/texpack.cpp), and loadDDSArray loads it back. Not loadDDS : with a
+// single page, the file looks like a plain GL_TEXTURE_2D. In the shader :
+//     uniform sampler2DArray atlas;
+//     color = texture(atlas, vec3(UV, layer)).rgb;
+
+// An image to pack : RGBA8, rows from the bottom up like OpenGL wants them
+struct AtlasSource {
+	unsigned int width, height;
+	std::vector<unsigned char> pixels;
+};
+
+// Where an image went
+struct AtlasRect {
+	unsigned int layer;
+	unsigned int x, y, width, height;   // In texels of level 0, without the gutter
+	glm::vec2 uvOffset, uvScale;        // UV in the array = uvOffset + UV * uvScale
+};
+
+// Uncompressed images only (see getRGBA8) : compressed ones can't be cut and packed
+bool getAtlasSource(const TextureImage & image, AtlasSource & source);
+
+// pageSize : a power of two. levelCount : the number of mipmap levels of the pages, at most
+// log2(pageSize)+1; the gutter is 2^(levelCount-2) texels on each side (1 with a single level).
+// Returns false if an image is bigger than a page.
+bool packTextureAtlas(const std::vector<AtlasSource> & sources, unsigned int pageSize, unsigned int levelCount,
+	TextureImage & atlas, std::vector<AtlasRect> & rects);
+
+// All the images must be 2D, of the same size, format and number of levels
+bool packTextureArray(const std::vector<TextureImage> & images, TextureImage & array, std::vector<AtlasRect> & rects);
+
+void remapAtlasUVs(std::vector<glm::vec2> & uvs, const AtlasRect & rect);
+
+// The rects as text, one line per image : "layer x y width height u v uScale vScale name". The
+// name is the rest of the line, so it can have spaces (line breaks in it are written as spaces).
+bool writeAtlasRects(const char * path, const std::vector<std::string> & names, const std::vector<AtlasRect> & rects);
+bool readAtlasRects(const char * path, std::vector<std::string> & names, std::vector<AtlasRect> & rects);
+
+#endif
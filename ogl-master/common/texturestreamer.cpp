@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <GL/glew.h>
+
+#include "texture.hpp"
+#include "streamingbuffer.hpp"
+#include "texturestreamer.hpp"
+
+enum StreamState {
+	STREAM_READING,     // Waiting for a worker, or being read
+	STREAM_UPLOADING,
+	STREAM_RESIDENT,
+	STREAM_FAILED
+};
+
+struct StreamedTexture {
+	GLuint texture;
+	std::string path;
+	TextureImage image;       // Written by a worker, then only used by the OpenGL thread
+	StreamState state;        // Only used by the OpenGL thread
+	unsigned int nextLevel;   // The levels [nextLevel, levelCount) are uploaded
+};
+
+struct TextureStreamer {
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<StreamedTexture*> requests;   // For the workers
+	std::deque<StreamedTexture*> ready;      // Read, or failed, for updateTextureStreamer
+	bool quit;
+
+	// Everything below is only used by the OpenGL thread
+	std::map<GLuint, StreamedTexture*> textures;
+	std::deque<StreamedTexture*> uploading;
+	StreamingBuffer staging;      // One segment per frame that uploads something
+	size_t uploadedBytes;
+	unsigned int resident;
+	unsigned int failed;
+};
+
+static bool hasExtension(const std::string & path, const char * extension){
+	size_t length = strlen(extension);
+	if ( path.size() < length )
+		return false;
+	for ( size_t i=0; i<length; i++ )
+		if ( tolower((unsigned char)path[path.size() - length + i]) != extension[i] )
+			return false;
+	return true;
+}
+
+static void workerLoop(TextureStreamer * streamer){
+	for (;;) {
+		StreamedTexture * texture;
+		{
+			std::unique_lock<std::mutex> lock(streamer->mutex);
+			streamer->wake.wait(lock, [streamer]{ return streamer->quit || !streamer->requests.empty(); });
+			if ( streamer->quit )
+				return;
+			texture = streamer->requests.front();
+			streamer->requests.pop_front();
+		}
+
+		// The slow part : the disk, and the parsing
+		bool ok = hasExtension(texture->path, ".dds")
+			? readDDS(texture->path.c_str(), texture->image)
+			: readBMP(texture->path.c_str(), texture->image);
+		if ( ok && texture->image.target != GL_TEXTURE_2D ){
+			printf("%s : only 2D textures can be streamed, use loadDDS\n", texture->path.c_str());
+			freeTextureImage(texture->image);
+			ok = false;
+		}
+		if ( ok && texture->image.file ){
+			// Touch every page of the mapping, so that the render thread doesn't wait for the
+			// disk when it copies them to the staging buffer
+			volatile unsigned char sum = 0;
+			for ( size_t i=0; i<texture->image.dataSize; i+=4096 )
+				sum += texture->image.data[i];
+		}
+		if ( !ok )
+			texture->image.levelCount = 0;
+
+		std::lock_guard<std::mutex> lock(streamer->mutex);
+		streamer->ready.push_back(texture);
+	}
+}
+
+TextureStreamer * createTextureStreamer(size_t uploadBudget, unsigned int threadCount){
+	TextureStreamer * streamer = new TextureStreamer;
+	streamer->quit = false;
+	streamer->uploadedBytes = 0;
+	streamer->resident = 0;
+	streamer->failed = 0;
+
+	createStreamingBuffer(streamer->staging, GL_PIXEL_UNPACK_BUFFER, uploadBudget);
+
+	if ( threadCount == 0 ){
+		threadCount = std::thread::hardware_concurrency();
+		if ( threadCount == 0 ) threadCount = 1;
+		if ( threadCount > 4 )  threadCount = 4; // The disk is the limit, not the cores
+	}
+	for ( unsigned int i=0; i<threadCount; i++ )
+		streamer->threads.push_back(std::thread(workerLoop, streamer));
+	return streamer;
+}
+
+void destroyTextureStreamer(TextureStreamer * streamer){
+	{
+		std::lock_guard<std::mutex> lock(streamer->mutex);
+		streamer->quit = true;
+	}
+	streamer->wake.notify_all();
+	for ( size_t i=0; i<streamer->threads.size(); i++ )
+		streamer->threads[i].join();
+
+	for ( std::map<GLuint, StreamedTexture*>::iterator it = streamer->textures.begin(); it != streamer->textures.end(); ++it ){
+		freeTextureImage(it->second->image);
+		delete it->second;
+	}
+	destroyStreamingBuffer(streamer->staging);
+	delete streamer;
+}
+
+GLuint requestTexture(TextureStreamer * streamer, const char * imagepath){
+	StreamedTexture * texture = new StreamedTexture;
+	memset(&texture->image, 0, sizeof(texture->image));
+	texture->path = imagepath;
+	texture->state = STREAM_READING;
+	texture->nextLevel = 0;
+
+	// The placeholder : one grey texel. The filters are left to their defaults, like loadDDS does.
+	const unsigned char grey[4] = { 128, 128, 128, 255 };
+	glGenTextures(1, &texture->texture);
+	glBindTexture(GL_TEXTURE_2D, texture->texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	streamer->textures[texture->texture] = texture;
+
+	{
+		std::lock_guard<std::mutex> lock(streamer->mutex);
+		streamer->requests.push_back(texture);
+	}
+	streamer->wake.notify_one();
+	return texture->texture;
+}
+
+// One level to upload this frame
+struct LevelCopy {
+	StreamedTexture * texture;
+	unsigned int level;
+	size_t offset;   // In the slice
+	bool staged;     // false : bigger than a slice, uploaded from memory
+};
+
+void updateTextureStreamer(TextureStreamer * streamer){
+	// What the workers have read since the last frame
+	{
+		std::lock_guard<std::mutex> lock(streamer->mutex);
+		while ( !streamer->ready.empty() ){
+			StreamedTexture * texture = streamer->ready.front();
+			streamer->ready.pop_front();
+			if ( texture->image.levelCount == 0 || !isTextureSupported(texture->image) ){
+				freeTextureImage(texture->image);
+				texture->state = STREAM_FAILED;
+				streamer->failed++;
+			}else{
+				texture->state = STREAM_UPLOADING;
+				texture->nextLevel = texture->image.levelCount;
+				streamer->uploading.push_back(texture);
+			}
+		}
+	}
+	streamer->uploadedBytes = 0;
+	if ( streamer->uploading.empty() )
+		return;
+
+	// The segment of this frame was last used 3 uploads ago : the fence is normally long signaled.
+	// If the GPU is still on it, nothing is staged this frame : one level goes straight from memory.
+	StreamingBuffer & staging = streamer->staging;
+	bool canStage = waitStreamingSegment(staging);
+	size_t sliceSize = canStage ? staging.segmentSize : 0;
+
+	// Which levels fit in the budget, smallest first
+	std::vector<LevelCopy> copies;
+	size_t used = 0;
+	bool full = false;
+	for ( size_t t=0; t<streamer->uploading.size() && !full; t++ ){
+		StreamedTexture * texture = streamer->uploading[t];
+		while ( texture->nextLevel > 0 ){
+			unsigned int level = texture->nextLevel - 1;
+			size_t size = texture->image.levels[level].size;
+			LevelCopy copy = { texture, level, used, true };
+			if ( size > sliceSize ){
+				// Too big for the staging buffer : alone in its frame, straight from memory
+				if ( !copies.empty() ){ full = true; break; }
+				copy.staged = false;
+				copies.push_back(copy);
+				texture->nextLevel--;
+				full = true;
+				break;
+			}
+			if ( used + size > sliceSize ){ full = true; break; }
+			copies.push_back(copy);
+			used = (used + size + 15) & ~(size_t)15; // Keeps the rows aligned
+			if ( used > sliceSize ) used = sliceSize;
+			texture->nextLevel--;
+		}
+	}
+
+	// Into the staging buffer
+	size_t sliceOffset = getStreamingSegmentOffset(staging);
+	bool staged = used > 0;
+	if ( staged ){
+		unsigned char * mapped = mapStreamingRange(staging, 0, used);
+		if ( mapped ){
+			for ( size_t i=0; i<copies.size(); i++ ){
+				const TextureImage & image = copies[i].texture->image;
+				const TextureLevel & level = image.levels[copies[i].level];
+				if ( copies[i].staged )
+					memcpy(mapped + copies[i].offset, image.data + level.offset, level.size);
+			}
+			unmapStreamingRange(staging);
+		}else{
+			// Couldn't map : the slow way
+			for ( size_t i=0; i<copies.size(); i++ )
+				copies[i].staged = false;
+			staged = false;
+		}
+	}
+
+	// To OpenGL. From the buffer, glTexImage2D returns before the copy is done.
+	for ( size_t i=0; i<copies.size(); i++ ){
+		StreamedTexture * texture = copies[i].texture;
+		TextureImage & image = texture->image;
+		unsigned int level = copies[i].level;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, copies[i].staged ? staging.buffer : 0);
+		glBindTexture(GL_TEXTURE_2D, texture->texture);
+		uploadTextureLevel(image, level, copies[i].staged
+			? (const void*)(sliceOffset + copies[i].offset)
+			: (const void*)(image.data + image.levels[level].offset));
+		streamer->uploadedBytes += image.levels[level].size;
+
+		// Only sample the levels that are there : [level, levelCount)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levelCount - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+		if ( level == 0 ){
+			finishTexture(image);
+			freeTextureImage(image);
+			texture->state = STREAM_RESIDENT;
+			streamer->resident++;
+		}
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	if ( staged )
+		nextStreamingSegment(staging);
+
+	while ( !streamer->uploading.empty() && streamer->uploading.front()->state == STREAM_RESIDENT )
+		streamer->uploading.pop_front();
+}
+
+bool isTextureResident(const TextureStreamer * streamer, GLuint texture){
+	std::map<GLuint, StreamedTexture*>::const_iterator it = streamer->textures.find(texture);
+	return it != streamer->textures.end() && it->second->state == STREAM_RESIDENT;
+}
+
+void getTextureStreamerStats(const TextureStreamer * streamer, TextureStreamerStats & stats){
+	stats.resident = streamer->resident;
+	stats.failed = streamer->failed;
+	stats.pending = (unsigned int)streamer->textures.size() - stats.resident - stats.failed;
+	stats.uploadedBytes = streamer->uploadedBytes;
+	stats.persistent = streamer->staging.persistent != NULL;
+}
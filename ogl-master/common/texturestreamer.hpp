@@ -0,0 +1,45 @@
+#ifndef TEXTURESTREAMER_HPP
+#define TEXTURESTREAMER_HPP
+
+// Textures loaded in the background, so that loading a level doesn't stall the frames :
+//
+// 1. requestTexture returns a texture right away, with a small grey placeholder in it.
+// 2. Worker threads read and parse the file (readBMP / readDDS of texture.hpp, no OpenGL).
+// 3. Once per frame, updateTextureStreamer copies at most uploadBudget bytes of the parsed
+//    images into a pixel unpack buffer and gives them to OpenGL from there, so the copy to
+//    video memory is done by the driver without waiting. The smallest mipmap levels come
+//    first : a texture gets sharper over a few frames instead of popping in all at once.
+//
+// The staging buffer is a StreamingBuffer (streamingbuffer.hpp) of 3 segments of uploadBudget
+// bytes, one per frame that uploads something.
+struct TextureStreamer;
+
+// Call with a current OpenGL context. threadCount = 0 : one per hardware thread, at most 4.
+TextureStreamer * createTextureStreamer(size_t uploadBudget = 4 << 20, unsigned int threadCount = 1);
+
+// Waits for the workers. The textures are not deleted : they belong to whoever asked for them.
+void destroyTextureStreamer(TextureStreamer * streamer);
+
+// .bmp or .dds, by extension, 2D textures only. If the file can't be read, or this OpenGL can't
+// have it (isTextureSupported in texture.hpp), the texture keeps its placeholder.
+// Leaves GL_TEXTURE_2D of the active texture unit unbound.
+GLuint requestTexture(TextureStreamer * streamer, const char * imagepath);
+
+// Call once per frame, on the thread of the OpenGL context. Leaves GL_TEXTURE_2D of the active
+// texture unit and GL_PIXEL_UNPACK_BUFFER unbound, and changes GL_UNPACK_ALIGNMENT.
+void updateTextureStreamer(TextureStreamer * streamer);
+
+// All its levels are uploaded (false for failed ones)
+bool isTextureResident(const TextureStreamer * streamer, GLuint texture);
+
+struct TextureStreamerStats {
+	unsigned int pending;     // Being read, or waiting for their upload
+	unsigned int resident;
+	unsigned int failed;
+	size_t uploadedBytes;     // During the last update
+	bool persistent;          // The staging buffer is persistently mapped
+};
+
+void getTextureStreamerStats(const TextureStreamer * streamer, TextureStreamerStats & stats);
+
+#endif
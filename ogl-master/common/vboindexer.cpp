@@ -1,5 +1,7 @@
 #include <vector>
 #include <map>
+#include <stdio.h>
+#include <math.h>
 
 #include <glm/glm.hpp>
 
@@ -9,14 +11,14 @@
 
 
 // Returns true iif v1 can be considered equal to v2
-bool is_near(float v1, float v2){
+static bool is_near(float v1, float v2){
 	return fabs( v1-v2 ) < 0.01f;
 }
 
 // Searches through all already-exported vertices
 // for a similar one.
 // Similar = same position + same UVs + same normal
-bool getSimilarVertexIndex( 
+static bool getSimilarVertexIndex( 
 	glm::vec3 & in_vertex, 
 	glm::vec2 & in_uv, 
 	glm::vec3 & in_normal, 
@@ -83,7 +85,7 @@ struct PackedVertex{
 	};
 };
 
-bool getSimilarVertexIndex_fast( 
+static bool getSimilarVertexIndex_fast( 
 	PackedVertex & packed, 
 	std::map<PackedVertex,unsigned short> & VertexToOutIndex,
 	unsigned short & result
@@ -97,7 +99,7 @@ bool getSimilarVertexIndex_fast(
 	}
 }
 
-void indexVBO(
+void indexVBO_map(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
@@ -133,12 +135,7 @@ void indexVBO(
 }
 
 
-
-
-
-
-
-void indexVBO_TBN(
+void indexVBO_TBN_slow(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
@@ -175,3 +172,189 @@ void indexVBO_TBN(
 		}
 	}
 }
+
+
+// The hash welder.
+// A vertex is reduced to a key of 8 words : the bits of each component, rounded to a multiple
+// of epsilon first if epsilon > 0. Equal keys = same output vertex. Keys go in an open
+// addressing table (linear probing) that is allocated once, so welding is O(n) with no
+// allocation per vertex, unlike the std::map above.
+
+struct WeldKey {
+	unsigned int words[8];
+};
+
+static inline unsigned int floatKey(float value, float inverseEpsilon){
+	if ( inverseEpsilon > 0.0f )
+		value = floorf(value * inverseEpsilon + 0.5f) + 0.0f; // + 0.0f turns -0 into 0
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static inline unsigned int hashWeldKey(const WeldKey & key){
+	// FNV-1a on words, then a final mix so that the low bits are good enough for the mask
+	unsigned int hash = 2166136261u;
+	for ( int i=0; i<8; i++ )
+		hash = (hash ^ key.words[i]) * 16777619u;
+	hash ^= hash >> 15;
+	hash *= 0x2c1b3c6du;
+	hash ^= hash >> 12;
+	return hash;
+}
+
+template <typename Index>
+static bool weldVertices(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> * in_tangents,   // NULL without TBN
+	std::vector<glm::vec3> * in_bitangents,
+	float epsilon,
+
+	std::vector<Index> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> * out_tangents,
+	std::vector<glm::vec3> * out_bitangents
+){
+	const unsigned int empty = 0xFFFFFFFFu;
+	const size_t maxVertices = (size_t)(Index)~(Index)0 + 1; // 65536 for unsigned short
+	float inverseEpsilon = epsilon > 0.0f ? 1.0f / epsilon : 0.0f;
+
+	// Sized for what a mesh usually welds to, and grown when half full to keep probe sequences
+	// short. A table sized for all the input corners would be mostly empty, and miss the cache.
+	size_t count = in_vertices.size();
+	size_t capacity = 1024;
+	size_t mask = capacity - 1;
+	std::vector<unsigned int> table(capacity, empty); // Output vertex, or empty
+	std::vector<WeldKey> keys;                        // Key of each output vertex
+
+	// Like the other versions, indices point into the whole output arrays. Only the vertices
+	// added by this call are welded together though.
+	size_t base = out_vertices.size();
+	out_indices.reserve(out_indices.size() + count);
+
+	for ( size_t i=0; i<count; i++ ){
+		WeldKey key;
+		key.words[0] = floatKey(in_vertices[i].x, inverseEpsilon);
+		key.words[1] = floatKey(in_vertices[i].y, inverseEpsilon);
+		key.words[2] = floatKey(in_vertices[i].z, inverseEpsilon);
+		key.words[3] = floatKey(in_uvs[i].x     , inverseEpsilon);
+		key.words[4] = floatKey(in_uvs[i].y     , inverseEpsilon);
+		key.words[5] = floatKey(in_normals[i].x , inverseEpsilon);
+		key.words[6] = floatKey(in_normals[i].y , inverseEpsilon);
+		key.words[7] = floatKey(in_normals[i].z , inverseEpsilon);
+
+		size_t slot = hashWeldKey(key) & mask;
+		while ( table[slot] != empty && memcmp(&keys[table[slot]], &key, sizeof(WeldKey)) != 0 )
+			slot = (slot + 1) & mask;
+
+		if ( table[slot] != empty ){ // A similar vertex is already in the VBO, use it instead !
+			size_t index = base + table[slot];
+			out_indices.push_back( (Index)index );
+			if ( in_tangents != NULL ){
+				// Average the tangents and the bitangents
+				(*out_tangents)  [index] += (*in_tangents)[i];
+				(*out_bitangents)[index] += (*in_bitangents)[i];
+			}
+		}else{ // If not, it needs to be added in the output data.
+			size_t index = base + keys.size();
+			if ( index >= maxVertices ){
+				printf("Too many vertices for %u-bit indices\n", (unsigned int)(sizeof(Index) * 8));
+				return false;
+			}
+			table[slot] = (unsigned int)keys.size();
+			keys.push_back(key);
+			if ( keys.size() * 2 > capacity ){
+				capacity *= 2;
+				mask = capacity - 1;
+				table.assign(capacity, empty);
+				for ( size_t k=0; k<keys.size(); k++ ){
+					size_t s = hashWeldKey(keys[k]) & mask;
+					while ( table[s] != empty )
+						s = (s + 1) & mask;
+					table[s] = (unsigned int)k;
+				}
+			}
+			out_vertices.push_back( in_vertices[i]);
+			out_uvs     .push_back( in_uvs[i]);
+			out_normals .push_back( in_normals[i]);
+			if ( in_tangents != NULL ){
+				out_tangents  ->push_back( (*in_tangents)[i]);
+				out_bitangents->push_back( (*in_bitangents)[i]);
+			}
+			out_indices.push_back( (Index)index );
+		}
+	}
+	return true;
+}
+
+bool indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	float epsilon
+){
+	return weldVertices(in_vertices, in_uvs, in_normals, NULL, NULL, epsilon,
+		out_indices, out_vertices, out_uvs, out_normals, NULL, NULL);
+}
+
+bool indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	float epsilon
+){
+	return weldVertices(in_vertices, in_uvs, in_normals, NULL, NULL, epsilon,
+		out_indices, out_vertices, out_uvs, out_normals, NULL, NULL);
+}
+
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents,
+	float epsilon
+){
+	return weldVertices(in_vertices, in_uvs, in_normals, &in_tangents, &in_bitangents, epsilon,
+		out_indices, out_vertices, out_uvs, out_normals, &out_tangents, &out_bitangents);
+}
+
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents,
+	float epsilon
+){
+	return weldVertices(in_vertices, in_uvs, in_normals, &in_tangents, &in_bitangents, epsilon,
+		out_indices, out_vertices, out_uvs, out_normals, &out_tangents, &out_bitangents);
+}
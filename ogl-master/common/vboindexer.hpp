@@ -1,7 +1,77 @@
 #ifndef VBOINDEXER_HPP
 #define VBOINDEXER_HPP
 
-void indexVBO(
+// Welds identical vertices and generates the index list, with a hash table (O(n)).
+// epsilon = 0 : vertices must be bit-for-bit identical, which is right for meshes that come from
+// a file. epsilon > 0 : every component is rounded to the nearest multiple of epsilon, and vertices
+// that round the same are welded. That is a grid, not a distance : two values less than epsilon
+// apart don't weld if a rounding boundary (an odd multiple of epsilon/2) falls between them, and
+// values up to epsilon apart do weld when it doesn't.
+// Returns false if there are more vertices than the index type can address.
+bool indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	float epsilon = 0.0f
+);
+
+// Same, with 32-bit indices, for meshes with more than 65536 vertices
+bool indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	float epsilon = 0.0f
+);
+
+// Same, and the tangents and bitangents of welded vertices are summed (see tutorial 13).
+// The default epsilon has the size of the tolerance of the original, linear search version
+// (indexVBO_TBN_slow, |a - b| < 0.01), but rounds to a grid of 0.01 as above : it welds mostly,
+// not exactly, the same vertices.
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents,
+	float epsilon = 0.01f
+);
+
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents,
+	float epsilon = 0.01f
+);
+
+// The previous versions, kept for misc06_benchmarks/bench_vboindexer.cpp :
+// a linear search (O(n^2)), and a std::map of the exact vertices (O(n log n)).
+void indexVBO_slow(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
@@ -12,8 +82,18 @@ void indexVBO(
 	std::vector<glm::vec3> & out_normals
 );
 
+void indexVBO_map(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned short> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+);
 
-void indexVBO_TBN(
+void indexVBO_TBN_slow(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
@@ -28,4 +108,4 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & out_bitangents
 );
 
-#endif
\ No newline at end of file
+#endif
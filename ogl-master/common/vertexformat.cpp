@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "vertexformat.hpp"
+
+// Size in bytes and GL description of each encoding
+static void describeEncoding(VertexEncoding encoding, GLint floatComponents, VertexAttributeLayout & layout, GLsizei & bytes){
+	layout.encoding = encoding;
+	layout.normalized = GL_TRUE;
+	switch ( encoding ){
+	case VERTEX_UNORM16 :        layout.size = 3; layout.type = GL_UNSIGNED_SHORT; bytes = 8; break; // + 2 bytes of padding
+	case VERTEX_HALF :           layout.size = 2; layout.type = GL_HALF_FLOAT; layout.normalized = GL_FALSE; bytes = 4; break;
+	case VERTEX_OCT16 :          layout.size = 2; layout.type = GL_SHORT; bytes = 4; break;
+	case VERTEX_INT_2_10_10_10 : layout.size = 4; layout.type = GL_INT_2_10_10_10_REV; bytes = 4; break;
+	case VERTEX_RGBA8 :          layout.size = 4; layout.type = GL_UNSIGNED_BYTE; bytes = 4; break;
+	case VERTEX_FLOAT :          layout.size = floatComponents; layout.type = GL_FLOAT; layout.normalized = GL_FALSE; bytes = floatComponents * sizeof(float); break;
+	default :                    layout.size = 0; layout.type = GL_FLOAT; layout.normalized = GL_FALSE; bytes = 0; break;
+	}
+}
+
+void initVertexFormat(
+	VertexFormat & format,
+	VertexEncoding position, VertexEncoding uv, VertexEncoding normal, VertexEncoding color,
+	glm::vec3 boxMin, glm::vec3 boxMax
+){
+	const VertexEncoding encodings[VERTEX_ATTRIBUTE_COUNT] = { position, uv, normal, color };
+	const GLint floatComponents[VERTEX_ATTRIBUTE_COUNT] = { 3, 2, 3, 3 };
+	format.stride = 0;
+	for ( int a=0; a<VERTEX_ATTRIBUTE_COUNT; a++ ){
+		GLsizei bytes;
+		describeEncoding(encodings[a], floatComponents[a], format.attributes[a], bytes);
+		format.attributes[a].offset = format.stride;
+		format.stride += bytes;
+	}
+
+	// A flat box : any value will do for that axis, as long as it's not a division by 0
+	format.positionMin = boxMin;
+	format.positionExtent = boxMax - boxMin;
+	for ( int i=0; i<3; i++ )
+		if ( !(format.positionExtent[i] > 0.0f) )
+			format.positionExtent[i] = 1.0f;
+}
+
+glm::mat4 getDequantizeMatrix(const VertexFormat & format){
+	if ( format.attributes[VERTEX_POSITION].encoding != VERTEX_UNORM16 )
+		return glm::mat4(1.0f);
+	return glm::scale(glm::translate(glm::mat4(1.0f), format.positionMin), format.positionExtent);
+}
+
+static inline unsigned short quantizeUnorm16(float value){
+	value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+	return (unsigned short)(value * 65535.0f + 0.5f);
+}
+
+static inline unsigned char quantizeUnorm8(float value){
+	value = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+	return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+void packVertices(
+	const VertexFormat & format, size_t count,
+	const glm::vec3 * positions, const glm::vec2 * uvs, const glm::vec3 * normals, const glm::vec3 * colors,
+	unsigned char * out
+){
+	memset(out, 0, count * format.stride); // Padding included : the files and buffers are reproducible
+	for ( size_t i=0; i<count; i++ ){
+		unsigned char * vertex = out + i * format.stride;
+
+		const VertexAttributeLayout & position = format.attributes[VERTEX_POSITION];
+		if ( position.encoding == VERTEX_FLOAT ){
+			memcpy(vertex + position.offset, &positions[i], sizeof(glm::vec3));
+		}else if ( position.encoding == VERTEX_UNORM16 ){
+			glm::vec3 relative = (positions[i] - format.positionMin) / format.positionExtent;
+			unsigned short quantized[3] = { quantizeUnorm16(relative.x), quantizeUnorm16(relative.y), quantizeUnorm16(relative.z) };
+			memcpy(vertex + position.offset, quantized, sizeof(quantized));
+		}
+
+		const VertexAttributeLayout & uv = format.attributes[VERTEX_UV];
+		if ( uv.encoding == VERTEX_FLOAT ){
+			memcpy(vertex + uv.offset, &uvs[i], sizeof(glm::vec2));
+		}else if ( uv.encoding == VERTEX_HALF ){
+			unsigned short halves[2] = { floatToHalf(uvs[i].x), floatToHalf(uvs[i].y) };
+			memcpy(vertex + uv.offset, halves, sizeof(halves));
+		}
+
+		const VertexAttributeLayout & normal = format.attributes[VERTEX_NORMAL];
+		if ( normal.encoding == VERTEX_FLOAT ){
+			memcpy(vertex + normal.offset, &normals[i], sizeof(glm::vec3));
+		}else if ( normal.encoding == VERTEX_OCT16 ){
+			short encoded[2];
+			encodeOctahedral(normals[i], encoded);
+			memcpy(vertex + normal.offset, encoded, sizeof(encoded));
+		}else if ( normal.encoding == VERTEX_INT_2_10_10_10 ){
+			unsigned int packed = packInt2101010(normals[i]);
+			memcpy(vertex + normal.offset, &packed, sizeof(packed));
+		}
+
+		const VertexAttributeLayout & color = format.attributes[VERTEX_COLOR];
+		if ( color.encoding == VERTEX_FLOAT ){
+			memcpy(vertex + color.offset, &colors[i], sizeof(glm::vec3));
+		}else if ( color.encoding == VERTEX_RGBA8 ){
+			unsigned char rgba[4] = { quantizeUnorm8(colors[i].r), quantizeUnorm8(colors[i].g), quantizeUnorm8(colors[i].b), 255 };
+			memcpy(vertex + color.offset, rgba, sizeof(rgba));
+		}
+	}
+}
+
+void setVertexAttribPointers(const VertexFormat & format, const GLint locations[VERTEX_ATTRIBUTE_COUNT], size_t bufferOffset){
+	for ( int a=0; a<VERTEX_ATTRIBUTE_COUNT; a++ ){
+		const VertexAttributeLayout & attribute = format.attributes[a];
+		if ( attribute.encoding == VERTEX_ABSENT || locations[a] < 0 )
+			continue;
+		glEnableVertexAttribArray(locations[a]);
+		glVertexAttribPointer(
+			locations[a],
+			attribute.size,
+			attribute.type,
+			attribute.normalized,
+			format.stride,
+			(void*)(bufferOffset + attribute.offset)
+		);
+	}
+}
+
+GLsizei getFloatVertexSize(const VertexFormat & format){
+	const GLsizei floatBytes[VERTEX_ATTRIBUTE_COUNT] = { 12, 8, 12, 12 };
+	GLsizei size = 0;
+	for ( int a=0; a<VERTEX_ATTRIBUTE_COUNT; a++ )
+		if ( format.attributes[a].encoding != VERTEX_ABSENT )
+			size += floatBytes[a];
+	return size;
+}
+
+void reportVertexFormat(const char * name, const VertexFormat & format, size_t vertexCount){
+	size_t packed = vertexCount * format.stride;
+	size_t floats = vertexCount * getFloatVertexSize(format);
+	printf("%s : %u vertices, %u bytes each, %.1f KB instead of %.1f KB (%.0f%% saved)\n",
+		name, (unsigned int)vertexCount, (unsigned int)format.stride, packed / 1024.0, floats / 1024.0,
+		floats > 0 ? 100.0 * (floats - packed) / floats : 0.0);
+}
+
+
+// IEEE half : 1 sign bit, 5 exponent bits, 10 mantissa bits. Rounds to nearest even, like the GPU.
+unsigned short floatToHalf(float value){
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+	unsigned int sign = (bits >> 16) & 0x8000;
+	unsigned int exponent = (bits >> 23) & 0xFF;
+	unsigned int mantissa = bits & 0x7FFFFF;
+
+	if ( exponent == 0xFF ) // Infinity, NaN
+		return (unsigned short)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+	int halfExponent = (int)exponent - 127 + 15;
+	if ( halfExponent >= 31 ) // Too big : infinity
+		return (unsigned short)(sign | 0x7C00);
+	if ( halfExponent <= 0 ){ // Too small for a normal half : denormal, or 0
+		if ( halfExponent < -10 )
+			return (unsigned short)sign;
+		mantissa |= 0x800000;
+		unsigned int shift = (unsigned int)(14 - halfExponent);
+		unsigned int half = mantissa >> shift;
+		unsigned int rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+		if ( rest > halfway || (rest == halfway && (half & 1)) )
+			half++;
+		return (unsigned short)(sign | half);
+	}
+	unsigned int half = ((unsigned int)halfExponent << 10) | (mantissa >> 13);
+	unsigned int rest = mantissa & 0x1FFF;
+	if ( rest > 0x1000 || (rest == 0x1000 && (half & 1)) )
+		half++; // A carry into the exponent is still the right answer, up to infinity
+	return (unsigned short)(sign | half);
+}
+
+float halfToFloat(unsigned short half){
+	unsigned int sign = (half & 0x8000u) << 16;
+	unsigned int exponent = (half >> 10) & 0x1F;
+	unsigned int mantissa = half & 0x3FF;
+	if ( exponent == 0 ){
+		float value = ldexpf((float)mantissa, -24);
+		return sign ? -value : value;
+	}
+	unsigned int bits = exponent == 31
+		? sign | 0x7F800000u | (mantissa << 13)
+		: sign | ((exponent + 112) << 23) | (mantissa << 13);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Normalized signed integers, as OpenGL 3.3 reads them : c of b bits is (2c + 1) / (2^b - 1).
+// (OpenGL 4.2 changed it to max(c / (2^(b-1) - 1), -1), so 0 is exact there; with these values, a
+// 4.2 driver reads at most half a step off.)
+static inline int quantizeSnorm(float value, int bits){
+	float steps = (float)((1 << bits) - 1);
+	value = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+	int quantized = (int)floorf((value * steps - 1.0f) * 0.5f + 0.5f);
+	int maxValue = (1 << (bits - 1)) - 1;
+	return quantized < -maxValue - 1 ? -maxValue - 1 : quantized > maxValue ? maxValue : quantized;
+}
+
+static inline float dequantizeSnorm(int quantized, int bits){
+	return (2.0f * quantized + 1.0f) / (float)((1 << bits) - 1);
+}
+
+static inline float signNotZero(float value){
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+// The unit sphere projected on the octahedron |x|+|y|+|z| = 1, whose lower half is folded
+// over the upper one : a square, with very even precision over all directions.
+void encodeOctahedral(glm::vec3 normal, short encoded[2]){
+	float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	glm::vec2 p = l1 > 0.0f ? glm::vec2(normal.x, normal.y) / l1 : glm::vec2(0.0f);
+	if ( normal.z < 0.0f )
+		p = glm::vec2((1.0f - fabsf(p.y)) * signNotZero(p.x), (1.0f - fabsf(p.x)) * signNotZero(p.y));
+	for ( int i=0; i<2; i++ )
+		encoded[i] = (short)quantizeSnorm(p[i], 16);
+}
+
+glm::vec3 decodeOctahedral(const short encoded[2]){
+	glm::vec2 e(dequantizeSnorm(encoded[0], 16), dequantizeSnorm(encoded[1], 16));
+	glm::vec3 n(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+	if ( n.z < 0.0f ){
+		float x = n.x;
+		n.x = (1.0f - fabsf(n.y)) * signNotZero(x);
+		n.y = (1.0f - fabsf(x))   * signNotZero(n.y);
+	}
+	return glm::normalize(n);
+}
+
+// GL_INT_2_10_10_10_REV : x in the low bits, then y, z, and 2 bits of w (0 here)
+unsigned int packInt2101010(glm::vec3 normal){
+	unsigned int packed = 0;
+	for ( int i=0; i<3; i++ )
+		packed |= ((unsigned int)quantizeSnorm(normal[i], 10) & 0x3FF) << (10 * i);
+	return packed;
+}
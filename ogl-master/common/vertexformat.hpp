@@ -0,0 +1,89 @@
+#ifndef VERTEXFORMAT_HPP
+#define VERTEXFORMAT_HPP
+
+// Compact vertex attributes. Floats everywhere are simple, but a vertex then takes 24 to 44
+// bytes; most attributes don't need that much precision :
+//
+//   positions : 3 x 16 bits, relative to the bounding box of the mesh (8 bytes instead of 12).
+//               The shader sees [0,1] : multiply the model matrix by getDequantizeMatrix.
+//   normals   : 10_10_10_2 (4 bytes, no shader change), or octahedral 2 x 16 bits (4 bytes,
+//               more precise, decoded in the shader) :
+//                   vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+//                   if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+//                   n = normalize(n);
+//   UVs       : half floats (4 bytes instead of 8)
+//   colors    : RGBA8 (4 bytes instead of 12)
+//
+// Every attribute starts on a 4 byte boundary, as the drivers like it.
+
+enum VertexAttribute {
+	VERTEX_POSITION,
+	VERTEX_UV,
+	VERTEX_NORMAL,
+	VERTEX_COLOR,
+	VERTEX_ATTRIBUTE_COUNT
+};
+
+enum VertexEncoding {
+	VERTEX_ABSENT,
+	VERTEX_FLOAT,            // Any attribute, as is
+	VERTEX_UNORM16,          // Positions
+	VERTEX_HALF,             // UVs
+	VERTEX_OCT16,            // Normals
+	VERTEX_INT_2_10_10_10,   // Normals
+	VERTEX_RGBA8             // Colors
+};
+
+// What glVertexAttribPointer needs for one attribute
+struct VertexAttributeLayout {
+	VertexEncoding encoding;
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	GLuint offset;            // In bytes, from the start of the vertex
+};
+
+// The quantization descriptor of one mesh (or one buffer of meshes)
+struct VertexFormat {
+	VertexAttributeLayout attributes[VERTEX_ATTRIBUTE_COUNT];
+	GLsizei stride;
+	glm::vec3 positionMin;    // Position = positionMin + stored position * positionExtent
+	glm::vec3 positionExtent;
+};
+
+// boxMin/boxMax : bounding box of the positions, only used with VERTEX_UNORM16
+void initVertexFormat(
+	VertexFormat & format,
+	VertexEncoding position, VertexEncoding uv, VertexEncoding normal, VertexEncoding color,
+	glm::vec3 boxMin = glm::vec3(0.0f), glm::vec3 boxMax = glm::vec3(1.0f)
+);
+
+// Identity, except for VERTEX_UNORM16 positions : model space from [0,1]^3
+glm::mat4 getDequantizeMatrix(const VertexFormat & format);
+
+// Writes count vertices of format.stride bytes to out. Arrays of absent attributes can be NULL.
+void packVertices(
+	const VertexFormat & format, size_t count,
+	const glm::vec3 * positions, const glm::vec2 * uvs, const glm::vec3 * normals, const glm::vec3 * colors,
+	unsigned char * out
+);
+
+// glVertexAttribPointer + glEnableVertexAttribArray for every attribute of the format, on the
+// buffer bound to GL_ARRAY_BUFFER. locations[attribute] = -1 : not used by the shader.
+void setVertexAttribPointers(const VertexFormat & format, const GLint locations[VERTEX_ATTRIBUTE_COUNT], size_t bufferOffset = 0);
+
+// Size of a vertex with the same attributes, all as floats
+GLsizei getFloatVertexSize(const VertexFormat & format);
+
+// Prints the size of vertexCount vertices, and how much smaller than floats it is
+void reportVertexFormat(const char * name, const VertexFormat & format, size_t vertexCount);
+
+// The encoders, for those who pack their own vertices. encodeOctahedral and packInt2101010 write
+// signed normalized integers for the OpenGL 3.3 rule : c of b bits reads as (2c + 1) / (2^b - 1).
+unsigned short floatToHalf(float value);
+float halfToFloat(unsigned short half);
+void encodeOctahedral(glm::vec3 normal, short encoded[2]);
+glm::vec3 decodeOctahedral(const short encoded[2]);
+unsigned int packInt2101010(glm::vec3 normal);
+
+#endif
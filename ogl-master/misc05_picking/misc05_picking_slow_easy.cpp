@@ -26,6 +26,8 @@ using namespace glm;
 #include <common/controls.hpp>
 #include <common/objloader.hpp>
 #include <common/vboindexer.hpp>
+#include <common/mappedfile.hpp>
+#include <common/meshcache.hpp>
 
 int main( void )
 {
@@ -107,40 +109,14 @@ int main( void )
 	// Get a handle for our "myTextureSampler" uniform
 	GLuint TextureID  = glGetUniformLocation(programID, "myTextureSampler");
 
-	// Read our .obj file
-	std::vector<glm::vec3> vertices;
-	std::vector<glm::vec2> uvs;
-	std::vector<glm::vec3> normals;
-	bool res = loadOBJ("suzanne.obj", vertices, uvs, normals);
+	// Read our model : from the binary mesh cache when there is one, from the .obj file otherwise
+	MeshBuffers suzanne;
+	loadMeshBuffers("suzanne.mesh", "suzanne.obj", suzanne);
 
-	std::vector<unsigned short> indices;
-	std::vector<glm::vec3> indexed_vertices;
-	std::vector<glm::vec2> indexed_uvs;
-	std::vector<glm::vec3> indexed_normals;
-	indexVBO(vertices, uvs, normals, indices, indexed_vertices, indexed_uvs, indexed_normals);
-
-	// Load it into a VBO
-
-	GLuint vertexbuffer;
-	glGenBuffers(1, &vertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, indexed_vertices.size() * sizeof(glm::vec3), &indexed_vertices[0], GL_STATIC_DRAW);
-
-	GLuint uvbuffer;
-	glGenBuffers(1, &uvbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uvbuffer);
-	glBufferData(GL_ARRAY_BUFFER, indexed_uvs.size() * sizeof(glm::vec2), &indexed_uvs[0], GL_STATIC_DRAW);
-
-	GLuint normalbuffer;
-	glGenBuffers(1, &normalbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, normalbuffer);
-	glBufferData(GL_ARRAY_BUFFER, indexed_normals.size() * sizeof(glm::vec3), &indexed_normals[0], GL_STATIC_DRAW);
-
-	// Generate a buffer for the indices as well
-	GLuint elementbuffer;
-	glGenBuffers(1, &elementbuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementbuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), &indices[0] , GL_STATIC_DRAW);
+	GLuint vertexbuffer = suzanne.vertexbuffer;
+	GLuint uvbuffer = suzanne.uvbuffer;
+	GLuint normalbuffer = suzanne.normalbuffer;
+	GLuint elementbuffer = suzanne.elementbuffer;
 
 
 
@@ -238,8 +214,8 @@ int main( void )
 				// Draw the triangles !
 				glDrawElements(
 					GL_TRIANGLES,      // mode
-					indices.size(),    // count
-					GL_UNSIGNED_SHORT,   // type
+					suzanne.indexCount, // count
+					suzanne.indexType,   // type
 					(void*)0           // element array buffer offset
 				);
 
@@ -363,8 +339,8 @@ int main( void )
 			// Draw the triangles !
 			glDrawElements(
 				GL_TRIANGLES,      // mode
-				indices.size(),    // count
-				GL_UNSIGNED_SHORT,   // type
+				suzanne.indexCount, // count
+				suzanne.indexType,   // type
 				(void*)0           // element array buffer offset
 			);
 
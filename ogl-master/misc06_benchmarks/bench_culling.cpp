@@ -0,0 +1,62 @@
+// Headless benchmark : frustum culling of a large fleet.
+// Culls one bounding box per rocket, laid out on the launch grid of tutorial04, with the SSE
+// batch test and with the scalar reference, checks that both agree, and prints boxes per second
+// and how many rockets would have been drawn.
+//
+//   ./bench_culling [rockets] [frames]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+// Include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <common/frustum.hpp>
+#include <common/benchtimer.hpp>
+
+int main(int argc, char* argv[])
+{
+	unsigned int rockets = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+	unsigned int frames  = argc > 2 ? (unsigned int)atoi(argv[2]) : 100;
+
+	// Same grid as tutorial04 : 6 units apart, behind the launch pad
+	int fleetSide = (int)ceil(sqrt((float)rockets));
+	BoundingBoxes boxes;
+	for (unsigned int i = 0; i < rockets; i++)
+		addBoundingSphere(boxes, glm::vec3((i % fleetSide) * 6.0f, 2.0f, -(float)(i / fleetSide) * 6.0f), 4.0f);
+
+	// The default camera of controls.cpp, with the clip planes of tutorial04
+	glm::vec3 position(0, 2, 70);
+	glm::vec3 direction(cos(0.3f) * sin(3.14f), sin(0.3f), cos(0.3f) * cos(3.14f));
+	glm::mat4 ProjectionMatrix = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.5f, 3000.0f);
+	glm::mat4 ViewMatrix = glm::lookAt(position, position + direction, glm::vec3(0, 1, 0));
+	Frustum frustum;
+	extractFrustum(frustum, ProjectionMatrix * ViewMatrix);
+
+	std::vector<unsigned char> simdVisible(rockets), scalarVisible(rockets);
+	unsigned int simdCount = 0, scalarCount = 0;
+
+	double start = now();
+	for (unsigned int f = 0; f < frames; f++)
+		simdCount = cullBoundingBoxes(frustum, boxes, &simdVisible[0]);
+	double simdTime = now() - start;
+
+	start = now();
+	for (unsigned int f = 0; f < frames; f++)
+		scalarCount = cullBoundingBoxesScalar(frustum, boxes, &scalarVisible[0]);
+	double scalarTime = now() - start;
+
+	bool identical = simdCount == scalarCount && simdVisible == scalarVisible;
+
+	printf("%u rockets, %u frames : %u visible, %u culled\n", rockets, frames, simdCount, rockets - simdCount);
+	printf("%-8s %10.3f ms/frame %10.1f Mboxes/s\n", "scalar", scalarTime * 1000.0 / frames, (double)rockets * frames / scalarTime / 1e6);
+	printf("%-8s %10.3f ms/frame %10.1f Mboxes/s\n", "SIMD",   simdTime   * 1000.0 / frames, (double)rockets * frames / simdTime   / 1e6);
+	printf("speedup %.2fx, results %s\n", scalarTime / simdTime, identical ? "identical" : "DIFFERENT");
+
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+// Headless benchmark : loadDDS, the old way (fread of the whole file into a malloc'ed buffer,
+// then glCompressedTexImage2D from the buffer) against the memory-mapped readDDS, whose levels
+// go to OpenGL straight from the mapping. Times the read and the upload separately.
+// Without a file, writes and uses three test files : a DXT1 texture, a DX10 BC3 texture array
+// and a DXT1 cubemap. The files are in the OS cache after the first run : this measures the
+// copies, not the disk.
+//
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./bench_dds [texture.dds] [runs]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Include GLEW
+#include <GL/glew.h>
+
+// Include GLFW
+#include <GLFW/glfw3.h>
+GLFWwindow* window;
+
+#include <common/mappedfile.hpp>
+#include <common/texture.hpp>
+
+static void writeUint32(FILE * file, unsigned int value){
+	fwrite(&value, 4, 1, file);
+}
+
+// Random blocks : any bits are a valid BC1 or BC3 block
+static void writeTestDDS(const char * path, unsigned int size, unsigned int blockSize, bool dx10, unsigned int layers, bool cube){
+	unsigned int levels = 0;
+	size_t sliceSize = 0;
+	for (unsigned int s = size; ; s /= 2) {
+		levels++;
+		sliceSize += (size_t)((s + 3) / 4) * ((s + 3) / 4) * blockSize;
+		if (s == 1) break;
+	}
+	FILE * file = fopen(path, "wb");
+	fwrite("DDS ", 1, 4, file);
+	unsigned int header[31];
+	memset(header, 0, sizeof(header));
+	header[0] = 124;
+	header[1] = 0x000A1007;               // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+	header[2] = size;
+	header[3] = size;
+	header[4] = (unsigned int)(((size + 3) / 4) * ((size + 3) / 4) * blockSize);
+	header[6] = levels;
+	header[18] = 32;                      // Pixel format size
+	header[19] = 0x4;                     // DDPF_FOURCC
+	memcpy(&header[20], dx10 ? "DX10" : (blockSize == 8 ? "DXT1" : "DXT5"), 4);
+	header[26] = 0x401008;                // TEXTURE | MIPMAP | COMPLEX
+	if (cube) header[27] = 0x200 | 0xFC00;
+	fwrite(header, 4, 31, file);
+	if (dx10) {
+		writeUint32(file, blockSize == 8 ? 71 : 77); // DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM
+		writeUint32(file, 3);             // DDS_DIMENSION_TEXTURE2D
+		writeUint32(file, cube ? 0x4 : 0);
+		writeUint32(file, layers);
+		writeUint32(file, 0);
+	}
+	std::vector<unsigned int> data(sliceSize / 4);
+	unsigned int seed = 1234;
+	for (unsigned int slice = 0; slice < layers * (cube ? 6 : 1); slice++) {
+		for (size_t i = 0; i < data.size(); i++) {
+			seed = seed * 1664525u + 1013904223u;
+			data[i] = seed;
+		}
+		fwrite(&data[0], 4, data.size(), file);
+	}
+	fclose(file);
+}
+
+static const char * targetName(GLenum target){
+	switch (target) {
+	case GL_TEXTURE_2D:             return "2D";
+	case GL_TEXTURE_2D_ARRAY:       return "2D array";
+	case GL_TEXTURE_CUBE_MAP:       return "cubemap";
+	case GL_TEXTURE_CUBE_MAP_ARRAY: return "cubemap array";
+	default:                        return "?";
+	}
+}
+
+static void bench(const char * path, int runs){
+	TextureImage image;
+	if (!readDDS(path, image))
+		return;
+	printf("%s : %s, %ux%u, %u levels, %u layers, %.1f MB\n", path, targetName(image.target),
+		image.levels[0].width, image.levels[0].height, image.levelCount, image.layers * image.faces, image.dataSize / 1048576.0);
+	size_t headerSize = image.data - image.file->data;
+	freeTextureImage(image);
+
+	double copyRead = 0.0, copyUpload = 0.0, mapRead = 0.0, mapUpload = 0.0;
+	for (int r = 0; r < runs; r++) {
+		// The RAM copy : the whole file in a buffer, then OpenGL copies it again
+		readDDS(path, image); // Only for the level sizes
+		glFinish();
+		double start = glfwGetTime();
+		FILE * file = fopen(path, "rb");
+		fseek(file, 0, SEEK_END);
+		size_t fileSize = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		unsigned char * buffer = (unsigned char*)malloc(fileSize);
+		if (fread(buffer, 1, fileSize, file) != fileSize)
+			printf("Short read\n");
+		fclose(file);
+		double middle = glfwGetTime();
+		TextureImage copy = image;
+		copy.data = buffer + headerSize;
+		GLuint texture = createTexture(copy);
+		glFinish();
+		double end = glfwGetTime();
+		copyRead += middle - start;
+		copyUpload += end - middle;
+		freeTextureImage(image);
+		free(buffer);
+		glDeleteTextures(1, &texture);
+
+		// The mapping : the pages go from the file cache to OpenGL
+		glFinish();
+		start = glfwGetTime();
+		readDDS(path, image);
+		middle = glfwGetTime();
+		texture = createTexture(image);
+		glFinish();
+		end = glfwGetTime();
+		mapRead += middle - start;
+		mapUpload += end - middle;
+		freeTextureImage(image);
+		glDeleteTextures(1, &texture);
+	}
+	printf("  RAM copy : read %8.3f ms  upload %8.3f ms  total %8.3f ms\n",
+		copyRead * 1000.0 / runs, copyUpload * 1000.0 / runs, (copyRead + copyUpload) * 1000.0 / runs);
+	printf("  mapped   : read %8.3f ms  upload %8.3f ms  total %8.3f ms\n\n",
+		mapRead * 1000.0 / runs, mapUpload * 1000.0 / runs, (mapRead + mapUpload) * 1000.0 / runs);
+}
+
+int main(int argc, char* argv[])
+{
+	int runs = argc > 2 ? atoi(argv[2]) : 10;
+
+	if (!glfwInit())
+	{
+		fprintf(stderr, "Failed to initialize GLFW\n");
+		return -1;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE); // Headless : nothing is ever shown
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	window = glfwCreateWindow(64, 64, "bench_dds", NULL, NULL);
+	if (window == NULL) {
+		fprintf(stderr, "Failed to open GLFW window.\n");
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+
+	glewExperimental = true;
+	if (glewInit() != GLEW_OK) {
+		fprintf(stderr, "Failed to initialize GLEW\n");
+		glfwTerminate();
+		return -1;
+	}
+
+	printf("Renderer : %s\n\n", glGetString(GL_RENDERER));
+
+	if (argc > 1) {
+		bench(argv[1], runs);
+	} else {
+		writeTestDDS("bench_dxt1.dds", 2048, 8, false, 1, false);
+		writeTestDDS("bench_bc3_array.dds", 1024, 16, true, 8, false);
+		writeTestDDS("bench_dxt1_cube.dds", 1024, 8, false, 1, true);
+		bench("bench_dxt1.dds", runs);
+		bench("bench_bc3_array.dds", runs);
+		bench("bench_dxt1_cube.dds", runs);
+	}
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,151 @@
+// Headless benchmark : frame time of the rocket fleet, one draw per rocket part per rocket
+// (the old way, one glUniformMatrix4fv + draw each) against one instanced draw per part.
+//
+// Runs in a hidden window, so it works on Mesa llvmpipe :
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./bench_instancing [maxInstances] [frames]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// Include GLEW
+#include <GL/glew.h>
+
+// Include GLFW
+#include <GLFW/glfw3.h>
+GLFWwindow* window;
+
+// Include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+using namespace glm;
+
+#include <common/shader.hpp>
+#include <common/vertexformat.hpp>
+#include <common/meshregistry.hpp>
+
+// A rocket-sized box : 12 triangles, like the body in tutorial04
+static const GLfloat box_vertex_buffer_data[] = {
+	-1.0f,0.0f,1.0f, -1.0f,0.0f,3.0f, -1.0f,3.0f,3.0f,
+	 1.0f,3.0f,1.0f, -1.0f,0.0f,1.0f, -1.0f,3.0f,1.0f,
+	 1.0f,0.0f,3.0f, -1.0f,0.0f,1.0f,  1.0f,0.0f,1.0f,
+	 1.0f,3.0f,1.0f,  1.0f,0.0f,1.0f, -1.0f,0.0f,1.0f,
+	-1.0f,0.0f,1.0f, -1.0f,3.0f,3.0f, -1.0f,3.0f,1.0f,
+	 1.0f,0.0f,3.0f, -1.0f,0.0f,3.0f, -1.0f,0.0f,1.0f,
+	-1.0f,3.0f,3.0f, -1.0f,0.0f,3.0f,  1.0f,0.0f,3.0f,
+	 1.0f,3.0f,3.0f,  1.0f,0.0f,1.0f,  1.0f,3.0f,1.0f,
+	 1.0f,0.0f,1.0f,  1.0f,3.0f,3.0f,  1.0f,0.0f,3.0f,
+	 1.0f,3.0f,3.0f,  1.0f,3.0f,1.0f, -1.0f,3.0f,1.0f,
+	 1.0f,3.0f,3.0f, -1.0f,3.0f,1.0f, -1.0f,3.0f,3.0f,
+	 1.0f,3.0f,3.0f, -1.0f,3.0f,3.0f,  1.0f,0.0f,3.0f,
+};
+
+int main(int argc, char* argv[])
+{
+	int maxInstances = argc > 1 ? atoi(argv[1]) : 16384;
+	int frames       = argc > 2 ? atoi(argv[2]) : 50;
+
+	if (!glfwInit())
+	{
+		fprintf(stderr, "Failed to initialize GLFW\n");
+		return -1;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE); // Headless : nothing is ever shown
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	window = glfwCreateWindow(1024, 768, "bench_instancing", NULL, NULL);
+	if (window == NULL) {
+		fprintf(stderr, "Failed to open GLFW window.\n");
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(0); // No vsync : we measure the frame, not the display
+
+	glewExperimental = true;
+	if (glewInit() != GLEW_OK) {
+		fprintf(stderr, "Failed to initialize GLEW\n");
+		glfwTerminate();
+		return -1;
+	}
+
+	printf("Renderer : %s\n", glGetString(GL_RENDERER));
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+
+	GLuint programID = LoadShaders("../tutorial04_colored_cube/TransformVertexShader.vertexshader", "../tutorial04_colored_cube/ColorFragmentShader.fragmentshader");
+	GLuint MatrixID = glGetUniformLocation(programID, "MVP");
+	GLuint instancedProgramID = LoadShaders("../tutorial04_colored_cube/InstancedTransform.vertexshader", "../tutorial04_colored_cube/ColorFragmentShader.fragmentshader");
+	GLuint ViewProjectionID = glGetUniformLocation(instancedProgramID, "VP");
+	GLuint DequantizeID = glGetUniformLocation(instancedProgramID, "Dequantize");
+
+	MeshRegistry meshes;
+	initMeshRegistry(meshes);
+	unsigned int boxMesh = addMesh(meshes, GL_TRIANGLES, box_vertex_buffer_data, NULL, 12 * 3, glm::vec3(1.0f));
+	uploadMeshRegistry(meshes);
+
+	InstanceBuffer instances;
+	initInstanceBuffer(instances, maxInstances);
+
+	// The rockets are spread on a grid in front of the camera
+	glm::mat4 VP = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 10000.0f)
+		* glm::lookAt(glm::vec3(0, 300, 400), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+	std::vector<glm::mat4> models(maxInstances);
+
+	printf("%10s %14s %14s\n", "instances", "uniform ms", "instanced ms");
+	for (int count = 1; count <= maxInstances; count *= 4) {
+
+		int side = 1;
+		while (side * side < count) side++;
+		for (int i = 0; i < count; i++)
+			models[i] = glm::translate(glm::mat4(), glm::vec3((i % side - side / 2) * 3.0f, 0.0f, -(i / side) * 3.0f));
+
+		bindMeshRegistry(meshes);
+
+		// One uniform upload and one draw per rocket
+		glUseProgram(programID);
+		glFinish();
+		double start = glfwGetTime();
+		for (int f = 0; f < frames; f++) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			for (int i = 0; i < count; i++) {
+				glm::mat4 MVP = VP * models[i] * meshes.meshes[boxMesh].dequantize;
+				glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
+				drawMesh(meshes, boxMesh);
+			}
+			glFinish();
+		}
+		double uniformTime = (glfwGetTime() - start) * 1000.0 / frames;
+
+		// One instance buffer upload and one draw for the whole fleet
+		glUseProgram(instancedProgramID);
+		glUniformMatrix4fv(ViewProjectionID, 1, GL_FALSE, &VP[0][0]);
+		glUniformMatrix4fv(DequantizeID, 1, GL_FALSE, &meshes.meshes[boxMesh].dequantize[0][0]);
+		glFinish();
+		start = glfwGetTime();
+		for (int f = 0; f < frames; f++) {
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			streamInstances(instances, &models[0], count);
+			bindInstanceBuffer(instances, 0);
+			drawMeshInstanced(meshes, boxMesh, count);
+			glFinish();
+		}
+		double instancedTime = (glfwGetTime() - start) * 1000.0 / frames;
+
+		printf("%10d %14.3f %14.3f\n", count, uniformTime, instancedTime);
+	}
+
+	cleanupInstanceBuffer(instances);
+	cleanupMeshRegistry(meshes);
+	glDeleteProgram(programID);
+	glDeleteProgram(instancedProgramID);
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,61 @@
+// Headless benchmark : scaling of the parallel rocket simulation with the number of workers.
+// Runs the same launch with 1, 2, ... N workers, checks that every run ends in exactly the same
+// state, and prints the time per tick and the speedup against one worker.
+//
+//   ./bench_jobsystem [rockets] [ticks] [maxWorkers]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include <common/rocketfleet.hpp>
+#include <common/benchtimer.hpp>
+
+int main(int argc, char* argv[])
+{
+	unsigned int rockets    = argc > 1 ? (unsigned int)atoi(argv[1]) : 4000000;
+	unsigned int ticks      = argc > 2 ? (unsigned int)atoi(argv[2]) : 300;
+	unsigned int maxWorkers = argc > 3 ? (unsigned int)atoi(argv[3]) : std::thread::hardware_concurrency();
+	if (maxWorkers == 0)
+		maxWorkers = 1;
+
+	printf("%u rockets, %u ticks, up to %u workers\n", rockets, ticks, maxWorkers);
+	printf("%8s %12s %10s %12s\n", "workers", "ms/tick", "speedup", "result");
+
+	RocketSnapshot reference;
+	double referenceTime = 0.0;
+
+	for (unsigned int workers = 1; workers <= maxWorkers; workers++) {
+		RocketFleet * fleet = createRocketFleet(rockets, workers);
+
+		double start = now();
+		requestFleetLaunch(fleet, 2.0f, 0);
+		advanceRocketFleet(fleet, ticks);
+		waitForRocketFleet(fleet);
+		double time = now() - start;
+
+		const RocketSnapshot * snapshot = acquireRocketSnapshot(fleet);
+		bool identical = true;
+		if (workers == 1) {
+			reference = *snapshot;
+			referenceTime = time;
+		}else{
+			identical =
+				reference.tick == snapshot->tick &&
+				memcmp(&reference.height[0],   &snapshot->height[0],   rockets * sizeof(float)) == 0 &&
+				memcmp(&reference.rotation[0], &snapshot->rotation[0], rockets * sizeof(float)) == 0 &&
+				memcmp(&reference.chute[0],    &snapshot->chute[0],    rockets * sizeof(int))   == 0;
+		}
+		releaseRocketSnapshot(fleet);
+		destroyRocketFleet(fleet);
+
+		printf("%8u %12.3f %9.2fx %12s\n", workers, time * 1000.0 / ticks, referenceTime / time, identical ? "identical" : "DIFFERENT");
+		if (!identical)
+			return 1;
+	}
+	return 0;
+}
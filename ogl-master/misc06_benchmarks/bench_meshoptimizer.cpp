@@ -0,0 +1,122 @@
+// Headless benchmark : vertex cache and overdraw optimization of common/meshoptimizer.cpp.
+// Indexes a mesh with indexVBO, then prints the simulated ACMR and ATVR (see meshoptimizer.hpp)
+// after each step, and how long each step took. Without a file, uses a UV sphere (with
+// triangles in a random order, as exporters sometimes leave them) and a 500 x 500 grid.
+// Fails (exit code 1) if the overdraw pass makes a single cluster, or leaves a curved mesh as it was.
+//
+//   ./bench_meshoptimizer [model.obj]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <map>
+#include <chrono>
+
+// Include GLEW, for the types of shapes.hpp
+#include <GL/glew.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/objloader.hpp>
+#include <common/vboindexer.hpp>
+#include <common/meshoptimizer.hpp>
+#include <common/shapes.hpp>
+#include <common/benchtimer.hpp>
+
+static void report(const char * step, const std::vector<unsigned int> & indices, size_t vertexCount, double time){
+	VertexCacheStats fifo16 = analyzeVertexCache(indices, vertexCount, 16);
+	VertexCacheStats fifo32 = analyzeVertexCache(indices, vertexCount, 32);
+	printf("%-16s ACMR %.3f ATVR %.3f (FIFO 16) | ACMR %.3f ATVR %.3f (FIFO 32) %9.1f ms\n",
+		step, fifo16.acmr, fifo16.atvr, fifo32.acmr, fifo32.atvr, time * 1000.0);
+}
+
+// The overdraw pass must cut the mesh in several clusters and, unless it is flat (every cluster
+// faces the same way), move them : false otherwise
+static bool optimize(const char * name, std::vector<glm::vec3> & vertices, std::vector<glm::vec2> & uvs, std::vector<glm::vec3> & normals, bool flat = false){
+	std::vector<unsigned int> indices;
+	std::vector<glm::vec3> indexed_vertices;
+	std::vector<glm::vec2> indexed_uvs;
+	std::vector<glm::vec3> indexed_normals;
+	indexVBO(vertices, uvs, normals, indices, indexed_vertices, indexed_uvs, indexed_normals);
+	size_t vertexCount = indexed_vertices.size();
+	printf("%s : %u triangles, %u vertices\n", name, (unsigned int)(indices.size() / 3), (unsigned int)vertexCount);
+	report("input order", indices, vertexCount, 0.0);
+
+	double start = now();
+	optimizeVertexCache(indices, vertexCount);
+	report("vertex cache", indices, vertexCount, now() - start);
+
+	start = now();
+	std::vector<unsigned int> cacheOrder(indices);
+	size_t clusters = 0;
+	bool sorted = optimizeOverdraw(indices, indexed_vertices, 1.05f, &clusters);
+	report(sorted ? "overdraw" : "overdraw (kept)", indices, vertexCount, now() - start);
+	bool reordered = indices != cacheOrder;
+	printf("%-16s %u clusters, triangle order %s\n", "", (unsigned int)clusters, reordered ? "changed" : "unchanged");
+	bool ok = clusters > 1 && (reordered || flat);
+	if (!ok)
+		printf("CHECK FAILED : the overdraw pass did nothing\n");
+
+	start = now();
+	std::vector<unsigned int> remap;
+	size_t used = optimizeVertexFetch(indices, vertexCount, remap);
+	remapVertices(indexed_vertices, remap, used);
+	remapVertices(indexed_uvs, remap, used);
+	remapVertices(indexed_normals, remap, used);
+	report("vertex fetch", indices, used, now() - start);
+	printf("\n");
+	return ok;
+}
+
+// Shuffles whole triangles
+static void shuffleTriangles(std::vector<glm::vec3> & vertices, std::vector<glm::vec2> & uvs, std::vector<glm::vec3> & normals){
+	unsigned int seed = 1234;
+	for (size_t t = vertices.size() / 3; t > 1; t--) {
+		seed = seed * 1664525u + 1013904223u;
+		size_t other = (seed >> 8) % t;
+		for (int c = 0; c < 3; c++) {
+			std::swap(vertices[3 * (t - 1) + c], vertices[3 * other + c]);
+			std::swap(uvs     [3 * (t - 1) + c], uvs     [3 * other + c]);
+			std::swap(normals [3 * (t - 1) + c], normals [3 * other + c]);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+
+	if (argc > 1) {
+		if (!loadOBJ(argv[1], vertices, uvs, normals))
+			return 1;
+		return optimize(argv[1], vertices, uvs, normals) ? 0 : 1;
+	}
+
+	generateSphereSoup(sphereShape(glm::vec3(0.0f), 1.0f, 256, 128), vertices, uvs, normals);
+	shuffleTriangles(vertices, uvs, normals);
+	bool ok = optimize("Shuffled sphere", vertices, uvs, normals);
+
+	// A grid in scanline order : already not too bad, but rows are longer than the cache
+	vertices.clear();
+	uvs.clear();
+	normals.clear();
+	const unsigned int side = 500;
+	for (unsigned int z = 0; z < side; z++) {
+		for (unsigned int x = 0; x < side; x++) {
+			const unsigned int corners[6][2] = { {0,0}, {0,1}, {1,1}, {0,0}, {1,1}, {1,0} };
+			for (int c = 0; c < 6; c++) {
+				float u = (float)(x + corners[c][0]), v = (float)(z + corners[c][1]);
+				vertices.push_back(glm::vec3(u, 0.0f, v));
+				uvs.push_back(glm::vec2(u / side, v / side));
+				normals.push_back(glm::vec3(0, 1, 0));
+			}
+		}
+	}
+	ok = optimize("Grid", vertices, uvs, normals, true) && ok;
+	return ok ? 0 : 1;
+}
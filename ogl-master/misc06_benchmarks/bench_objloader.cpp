@@ -0,0 +1,137 @@
+// Headless benchmark : OBJ parsing throughput.
+// Loads an OBJ file with loadOBJ and prints MB/s. Without a file, writes a synthetic one first :
+// a finely tessellated, wavy grid with positions, UVs and normals, made of quads.
+// Then loads it again on 1, 2, 4... up to maxThreads workers, and checks that every parallel
+// load gives exactly the same arrays as the serial one.
+//
+//   ./bench_objloader [model.obj | size in MB] [runs] [maxThreads]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/objloader.hpp>
+#include <common/jobsystem.hpp>
+#include <common/benchtimer.hpp>
+
+template <typename T>
+static bool sameBytes(const std::vector<T> & a, const std::vector<T> & b){
+	return a.size() == b.size() && (a.empty() || memcmp(&a[0], &b[0], a.size() * sizeof(T)) == 0);
+}
+
+// A (side+1)^2 vertex grid, written until the file reaches about megabytes MB
+static bool writeSyntheticOBJ(const char * path, unsigned int megabytes){
+	FILE * file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+	// About 100 bytes of v/vt/vn per vertex, and 60 bytes of face per vertex
+	unsigned int side = (unsigned int)sqrt(megabytes * 1024.0 * 1024.0 / 160.0);
+	fprintf(file, "# Synthetic grid, %u x %u quads\no grid\n", side, side);
+	for (unsigned int z = 0; z <= side; z++)
+		for (unsigned int x = 0; x <= side; x++)
+			fprintf(file, "v %.6f %.6f %.6f\n", x * 0.01f, 0.1f * sinf(x * 0.05f) * cosf(z * 0.05f), z * 0.01f);
+	for (unsigned int z = 0; z <= side; z++)
+		for (unsigned int x = 0; x <= side; x++)
+			fprintf(file, "vt %.6f %.6f\n", x / (float)side, z / (float)side);
+	for (unsigned int z = 0; z <= side; z++)
+		for (unsigned int x = 0; x <= side; x++)
+			fprintf(file, "vn %.6f %.6f %.6f\n", 0.0f, 1.0f, 0.0f);
+	for (unsigned int z = 0; z < side; z++) {
+		for (unsigned int x = 0; x < side; x++) {
+			unsigned int a = z * (side + 1) + x + 1, b = a + 1, c = a + side + 2, d = a + side + 1;
+			fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, d, d, d, c, c, c, b, b, b);
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	const char * path = "synthetic.obj";
+	unsigned int megabytes = 256;
+	bool generate = true;
+	if (argc > 1) {
+		if (atoi(argv[1]) > 0) {
+			megabytes = (unsigned int)atoi(argv[1]);
+		} else {
+			path = argv[1];
+			generate = false;
+		}
+	}
+	int runs = argc > 2 ? atoi(argv[2]) : 3;
+	unsigned int maxThreads = argc > 3 ? (unsigned int)atoi(argv[3]) : std::thread::hardware_concurrency();
+	if (maxThreads == 0)
+		maxThreads = 1;
+
+	if (generate) {
+		printf("Writing a %u MB synthetic OBJ...\n", megabytes);
+		if (!writeSyntheticOBJ(path, megabytes)) {
+			printf("%s could not be written\n", path);
+			return 1;
+		}
+	}
+
+	FILE * file = fopen(path, "rb");
+	if (file == NULL) {
+		printf("%s could not be opened\n", path);
+		return 1;
+	}
+	fseek(file, 0, SEEK_END);
+	double size = ftell(file) / (1024.0 * 1024.0);
+	fclose(file);
+
+	// The first run also pulls the file into the OS cache : the best run is the parsing speed
+	double best = 1e30;
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	for (int r = 0; r < runs; r++) {
+		vertices.clear();
+		uvs.clear();
+		normals.clear();
+		double start = now();
+		if (!loadOBJ(path, vertices, uvs, normals))
+			return 1;
+		double time = now() - start;
+		best = time < best ? time : best;
+		printf("run %d : %8.1f ms %8.1f MB/s\n", r, time * 1000.0, size / time);
+	}
+	double serial = best;
+	printf("%s : %.1f MB, %u triangles, best %.1f ms = %.1f MB/s\n", path, size, (unsigned int)(vertices.size() / 3), best * 1000.0, size / best);
+
+	// Scaling : same file, more and more workers
+	printf("workers      ms     MB/s  speedup\n");
+	for (unsigned int threads = 1; threads <= maxThreads; threads = threads * 2 > maxThreads && threads < maxThreads ? maxThreads : threads * 2) {
+		JobSystem * jobs = createJobSystem(threads);
+		best = 1e30;
+		for (int r = 0; r < runs; r++) {
+			std::vector<glm::vec3> parallelVertices;
+			std::vector<glm::vec2> parallelUVs;
+			std::vector<glm::vec3> parallelNormals;
+			double start = now();
+			if (!loadOBJ(path, parallelVertices, parallelUVs, parallelNormals, jobs)) {
+				destroyJobSystem(jobs);
+				return 1;
+			}
+			double time = now() - start;
+			best = time < best ? time : best;
+			if (!sameBytes(vertices, parallelVertices) || !sameBytes(uvs, parallelUVs) || !sameBytes(normals, parallelNormals)) {
+				printf("%u workers : not the same result as the serial loader !\n", threads);
+				destroyJobSystem(jobs);
+				return 1;
+			}
+		}
+		printf("%7u %7.1f %8.1f %7.2fx\n", threads, best * 1000.0, size / best, serial / best);
+		destroyJobSystem(jobs);
+	}
+	return 0;
+}
@@ -0,0 +1,63 @@
+// Headless benchmark : throughput of the rocket system update kernel.
+// Steps 1M rockets per tick with the SIMD kernel and with the scalar reference,
+// checks that both give bit-identical results, and prints rockets updated per second.
+//
+//   ./bench_rocketsystem [rockets] [ticks]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include <common/rocketsystem.hpp>
+#include <common/benchtimer.hpp>
+
+// The whole fleet launches at once, with launch powers between 0.5 and 3
+static void launchFleet(RocketSystem & system){
+	for (unsigned int i = 0; i < system.count; i++)
+		launchRocket(system, i, 0.5f + 2.5f * (i % 1000) / 1000.0f);
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int rockets = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+	unsigned int ticks   = argc > 2 ? (unsigned int)atoi(argv[2]) : 600; // 10 simulated seconds
+
+	RocketSystem simd, scalar;
+	initRocketSystem(simd, rockets);
+	initRocketSystem(scalar, rockets);
+	launchFleet(simd);
+	launchFleet(scalar);
+
+	printf("%u rockets, %u ticks, SIMD width %d\n", rockets, ticks, ROCKET_SYSTEM_WIDTH);
+
+	double start = now();
+	for (unsigned int t = 0; t < ticks; t++)
+		updateRocketSystem(simd);
+	double simdTime = now() - start;
+
+	start = now();
+	for (unsigned int t = 0; t < ticks; t++)
+		updateRocketSystemScalar(scalar, 0, scalar.count);
+	double scalarTime = now() - start;
+
+	bool identical =
+		memcmp(simd.height,  scalar.height,  rockets * sizeof(float)) == 0 &&
+		memcmp(simd.ySpeed,  scalar.ySpeed,  rockets * sizeof(float)) == 0 &&
+		memcmp(simd.rotation,scalar.rotation,rockets * sizeof(float)) == 0 &&
+		memcmp(simd.chute,   scalar.chute,   rockets * sizeof(int))   == 0 &&
+		memcmp(simd.landing, scalar.landing, rockets * sizeof(int))   == 0;
+
+	unsigned int landed = 0;
+	for (unsigned int i = 0; i < rockets; i++)
+		if (simd.landing[i]) landed++;
+
+	printf("%-8s %10.3f ms/tick %10.1f Mrockets/s\n", "scalar", scalarTime * 1000.0 / ticks, (double)rockets * ticks / scalarTime / 1e6);
+	printf("%-8s %10.3f ms/tick %10.1f Mrockets/s\n", "SIMD",   simdTime   * 1000.0 / ticks, (double)rockets * ticks / simdTime   / 1e6);
+	printf("speedup %.2fx, %u rockets landed, results %s\n", scalarTime / simdTime, landed, identical ? "identical" : "DIFFERENT");
+
+	cleanupRocketSystem(simd);
+	cleanupRocketSystem(scalar);
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// Headless benchmark : LoadShaders cold (compile and link, cache disabled) against warm (the
+// program binary of the cache, see common/shader.hpp), for the shaders of the tutorials.
+// The results come after the log of LoadShaders.
+// Mesa has its own cache of compiled shaders : disable it to measure a real cold start.
+//
+//   MESA_SHADER_CACHE_DISABLE=true LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./bench_shadercache [runs]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+// Include GLEW
+#include <GL/glew.h>
+
+// Include GLFW
+#include <GLFW/glfw3.h>
+GLFWwindow* window;
+
+#include <common/shader.hpp>
+#include <common/benchtimer.hpp>
+
+static const char * ShaderPairs[][2] = {
+	{ "../tutorial04_colored_cube/TransformVertexShader.vertexshader", "../tutorial04_colored_cube/ColorFragmentShader.fragmentshader" },
+	{ "../tutorial04_colored_cube/InstancedTransform.vertexshader",    "../tutorial04_colored_cube/ColorFragmentShader.fragmentshader" },
+	{ "../misc05_picking/StandardShading.vertexshader",                "../misc05_picking/StandardShading.fragmentshader" },
+	{ "../misc05_picking/Picking.vertexshader",                        "../misc05_picking/Picking.fragmentshader" },
+};
+static const int PairCount = sizeof(ShaderPairs) / sizeof(ShaderPairs[0]);
+
+// Best time of runs calls of LoadShaders, in ms. glFinish : some drivers link lazily.
+static double timeLoadShaders(int pair, int runs, bool & ok){
+	double best = 1e30;
+	for (int run = 0; run < runs; run++) {
+		double start = now();
+		GLuint programID = LoadShaders(ShaderPairs[pair][0], ShaderPairs[pair][1]);
+		glFinish();
+		double time = now() - start;
+		if (time < best) best = time;
+		GLint linked = GL_FALSE;
+		if (programID)
+			glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+		ok = ok && linked == GL_TRUE;
+		glDeleteProgram(programID);
+	}
+	return best * 1000.0;
+}
+
+int main(int argc, char* argv[])
+{
+	int runs = argc > 1 ? atoi(argv[1]) : 5;
+	if (runs < 1) runs = 1;
+
+	if (!glfwInit())
+	{
+		fprintf(stderr, "Failed to initialize GLFW\n");
+		return -1;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE); // Headless : nothing is ever shown
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	window = glfwCreateWindow(64, 64, "bench_shadercache", NULL, NULL);
+	if (window == NULL) {
+		fprintf(stderr, "Failed to open GLFW window.\n");
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+
+	glewExperimental = true;
+	if (glewInit() != GLEW_OK) {
+		fprintf(stderr, "Failed to initialize GLEW\n");
+		glfwTerminate();
+		return -1;
+	}
+
+	GLint formats = 0;
+	if (GLEW_ARB_get_program_binary)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+	double cold[PairCount], save[PairCount], warm[PairCount];
+	bool ok = true;
+	for (int pair = 0; pair < PairCount; pair++) {
+		setShaderCacheDirectory(NULL);
+		cold[pair] = timeLoadShaders(pair, runs, ok);
+		setShaderCacheDirectory(".");
+		save[pair] = timeLoadShaders(pair, 1, ok); // The entry doesn't exist or is stale the first time
+		warm[pair] = timeLoadShaders(pair, runs, ok);
+	}
+
+	printf("\n%s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	printf("%d program binary formats%s, best of %d runs\n", formats, formats > 0 ? "" : " : the cache is disabled", runs);
+	printf("%-40s %12s %14s %12s %10s\n", "vertex shader", "cold (ms)", "first (ms)", "warm (ms)", "speedup");
+	double coldTotal = 0.0, warmTotal = 0.0;
+	for (int pair = 0; pair < PairCount; pair++) {
+		const char * name = strrchr(ShaderPairs[pair][0], '/') + 1;
+		printf("%-40s %12.3f %14.3f %12.3f %9.1fx\n", name, cold[pair], save[pair], warm[pair], cold[pair] / warm[pair]);
+		coldTotal += cold[pair];
+		warmTotal += warm[pair];
+	}
+	printf("%-40s %12.3f %14s %12.3f %9.1fx\n", "total", coldTotal, "", warmTotal, coldTotal / warmTotal);
+	if (!ok)
+		printf("Some programs did not link\n");
+
+	glfwTerminate();
+	return ok ? 0 : 1;
+}
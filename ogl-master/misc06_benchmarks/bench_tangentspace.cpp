@@ -0,0 +1,87 @@
+// Headless benchmark : tangent space generation.
+// The tutorial 13 way : computeTangentBasis on the triangle soup, then indexVBO_TBN to weld the
+// vertices and sum their tangents. Against : indexVBO, then computeTangents on the indexed mesh
+// (SSE when available). Uses a UV sphere, with a few faces whose UVs are degenerate, and checks
+// that every tangent is a unit vector orthogonal to its normal.
+//
+//   ./bench_tangentspace [rings] [runs]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <map>
+#include <chrono>
+
+// Include GLEW, for the types of shapes.hpp
+#include <GL/glew.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/vboindexer.hpp>
+#include <common/tangentspace.hpp>
+#include <common/shapes.hpp>
+#include <common/benchtimer.hpp>
+
+// One triangle in 97 has all its UVs in the same place
+static void degenerateUVs(std::vector<glm::vec2> & uvs){
+	for (size_t i = 0; i < uvs.size(); i += 3 * 97)
+		uvs[i] = uvs[i + 1] = uvs[i + 2] = glm::vec2(0.5f);
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int rings = argc > 1 ? (unsigned int)atoi(argv[1]) : 512;
+	int runs = argc > 2 ? atoi(argv[2]) : 3;
+
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	generateSphereSoup(sphereShape(glm::vec3(0.0f), 1.0f, 2 * rings, rings), vertices, uvs, normals);
+	degenerateUVs(uvs);
+	printf("Sphere : %u triangles\n", (unsigned int)(vertices.size() / 3));
+
+	double bestSoup = 1e30, bestIndexed = 1e30, bestTangents = 1e30;
+	std::vector<glm::vec4> tangents;
+	std::vector<glm::vec3> indexed_normals;
+	for (int r = 0; r < runs; r++) {
+		// Soup, then weld
+		double start = now();
+		std::vector<glm::vec3> soupTangents, soupBitangents;
+		computeTangentBasis(vertices, uvs, normals, soupTangents, soupBitangents);
+		std::vector<unsigned int> indices;
+		std::vector<glm::vec3> out_vertices, out_normals, out_tangents, out_bitangents;
+		std::vector<glm::vec2> out_uvs;
+		indexVBO_TBN(vertices, uvs, normals, soupTangents, soupBitangents, indices, out_vertices, out_uvs, out_normals, out_tangents, out_bitangents);
+		double time = now() - start;
+		bestSoup = time < bestSoup ? time : bestSoup;
+
+		// Weld, then tangents
+		start = now();
+		indices.clear();
+		out_vertices.clear();
+		out_uvs.clear();
+		out_normals.clear();
+		indexVBO(vertices, uvs, normals, indices, out_vertices, out_uvs, out_normals);
+		double indexTime = now() - start;
+		computeTangents(indices, out_vertices, out_uvs, out_normals, tangents);
+		time = now() - start;
+		bestIndexed = time < bestIndexed ? time : bestIndexed;
+		bestTangents = time - indexTime < bestTangents ? time - indexTime : bestTangents;
+		indexed_normals.swap(out_normals);
+	}
+	printf("computeTangentBasis + indexVBO_TBN : %8.1f ms\n", bestSoup * 1000.0);
+	printf("indexVBO + computeTangents         : %8.1f ms (computeTangents alone : %.1f ms)\n", bestIndexed * 1000.0, bestTangents * 1000.0);
+
+	// Unit, orthogonal to the normal, and a sign in w
+	unsigned int bad = 0;
+	for (size_t i = 0; i < tangents.size(); i++) {
+		glm::vec3 t(tangents[i]);
+		if (!(fabsf(glm::length(t) - 1.0f) < 1e-4f) || !(fabsf(glm::dot(t, indexed_normals[i])) < 1e-3f) || fabsf(tangents[i].w) != 1.0f)
+			bad++;
+	}
+	printf("%u vertices, %u bad tangents\n", (unsigned int)tangents.size(), bad);
+	return bad == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+// Headless benchmark : the BC1 / BC3 encoder of common/texturecompressor.hpp, with 1, 2, ... N
+// workers. Prints the speed in megapixels per second (all the mipmap levels count) and the
+// quality of level 0 as a PSNR, and checks that every run writes exactly the same blocks.
+// Without a file, uses a synthetic image : gradients, noise and hard edges, in the alpha too.
+//
+//   ./bench_texturecompressor [image.bmp] [runs] [maxWorkers]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+// Include GLEW, for the GL enums
+#include <GL/glew.h>
+
+#include <common/texture.hpp>
+#include <common/jobsystem.hpp>
+#include <common/texturecompressor.hpp>
+#include <common/benchtimer.hpp>
+
+static void makeTestImage(unsigned int size, TextureImage & image){
+	memset(&image, 0, sizeof(image));
+	unsigned char * data = (unsigned char*)malloc((size_t)size * size * 4);
+	unsigned int seed = 1;
+	for (unsigned int y = 0; y < size; y++) {
+		for (unsigned int x = 0; x < size; x++) {
+			unsigned char * texel = data + ((size_t)y * size + x) * 4;
+			seed = seed * 1664525u + 1013904223u;
+			int noise = (int)(seed >> 28) - 8;
+			float u = (float)x / size, v = (float)y / size;
+			bool checker = ((x / 32) + (y / 32)) % 2 == 0;
+			int r = (int)(255.0f * u) + noise;
+			int g = checker ? 200 : (int)(128.0f + 127.0f * sinf(u * 20.0f)) + noise;
+			int b = (int)(255.0f * v * (1.0f - u));
+			texel[0] = (unsigned char)(r < 0 ? 0 : r > 255 ? 255 : r);
+			texel[1] = (unsigned char)(g < 0 ? 0 : g > 255 ? 255 : g);
+			texel[2] = (unsigned char)(b < 0 ? 0 : b > 255 ? 255 : b);
+			// Alpha : cut-out discs, not aligned on the blocks, in a noisy ramp
+			int dx = (int)(x % 24) - 11, dy = (int)(y % 24) - 13;
+			int alphaNoise = (int)((seed >> 20) & 63) - 32;
+			int a = dx * dx + dy * dy < 64 ? ((x / 24) % 2 ? 0 : 255) : (int)(255.0f * v) + alphaNoise;
+			texel[3] = (unsigned char)(a < 0 ? 0 : a > 255 ? 255 : a);
+		}
+	}
+	image.target = GL_TEXTURE_2D;
+	image.internalFormat = GL_RGBA8;
+	image.format = GL_RGBA;
+	image.type = GL_UNSIGNED_BYTE;
+	image.unpackAlignment = 4;
+	image.levelCount = 1;
+	image.levels[0].width = size;
+	image.levels[0].height = size;
+	image.levels[0].size = (size_t)size * size * 4;
+	image.layers = 1;
+	image.faces = 1;
+	image.sliceSize = image.levels[0].size;
+	image.data = data;
+	image.dataSize = image.levels[0].size;
+}
+
+int main(int argc, char* argv[])
+{
+	TextureImage image;
+	if (argc > 1 && strcmp(argv[1], "-") != 0) {
+		if (!readBMP(argv[1], image))
+			return 1;
+	} else {
+		makeTestImage(2048, image);
+	}
+	unsigned int runs       = argc > 2 ? (unsigned int)atoi(argv[2]) : 3;
+	unsigned int maxWorkers = argc > 3 ? (unsigned int)atoi(argv[3]) : std::thread::hardware_concurrency();
+	if (runs == 0) runs = 1;
+	if (maxWorkers == 0) maxWorkers = 1;
+
+	unsigned char * original = getRGBA8(image);
+	unsigned int width = image.levels[0].width, height = image.levels[0].height;
+	size_t texels = (size_t)width * height;
+	std::vector<unsigned char> decoded(texels * 4);
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	printf("%ux%u, SSE2, best of %u runs\n", width, height, runs);
+#else
+	printf("%ux%u, scalar, best of %u runs\n", width, height, runs);
+#endif
+	printf("%6s %8s %10s %10s %10s %12s %10s\n", "format", "workers", "ms", "MPixel/s", "speedup", "PSNR (dB)", "result");
+
+	const BlockFormat formats[2] = { BLOCK_BC1, BLOCK_BC3 };
+	for (int f = 0; f < 2; f++) {
+		std::vector<unsigned char> reference;
+		double referenceTime = 0.0;
+		for (unsigned int workers = 1; workers <= maxWorkers; workers++) {
+			JobSystem * jobs = createJobSystem(workers);
+			double best = 1e30;
+			TextureImage compressed;
+			memset(&compressed, 0, sizeof(compressed));
+			for (unsigned int run = 0; run < runs; run++) {
+				freeTextureImage(compressed);
+				double start = now();
+				if (!compressTexture(image, formats[f], compressed, jobs)) {
+					destroyJobSystem(jobs);
+					return 1;
+				}
+				double time = now() - start;
+				if (time < best) best = time;
+			}
+			destroyJobSystem(jobs);
+
+			size_t pixels = 0;
+			for (unsigned int l = 0; l < compressed.levelCount; l++)
+				pixels += (size_t)compressed.levels[l].width * compressed.levels[l].height;
+			bool same = true;
+			if (workers == 1) {
+				reference.assign(compressed.data, compressed.data + compressed.dataSize);
+				referenceTime = best;
+			} else {
+				same = memcmp(&reference[0], compressed.data, compressed.dataSize) == 0;
+			}
+
+			decompressTextureLevel(compressed, 0, &decoded[0]);
+			char psnr[32];
+			if (formats[f] == BLOCK_BC3)
+				sprintf(psnr, "%.2f / %.2f", computePSNR(original, &decoded[0], texels, false), computePSNR(original, &decoded[0], texels, true));
+			else
+				sprintf(psnr, "%.2f", computePSNR(original, &decoded[0], texels, false));
+			printf("%6s %8u %10.2f %10.1f %9.2fx %12s %10s\n", formats[f] == BLOCK_BC1 ? "BC1" : "BC3", workers,
+				best * 1000.0, pixels / best / 1e6, referenceTime / best, psnr, same ? "same" : "DIFFERENT");
+			freeTextureImage(compressed);
+		}
+	}
+
+	free(original);
+	freeTextureImage(image);
+	return 0;
+}
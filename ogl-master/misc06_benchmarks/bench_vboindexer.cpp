@@ -0,0 +1,151 @@
+// Headless benchmark : vertex welding in common/vboindexer.cpp.
+// Builds the triangle soup of a tessellated grid (what loadOBJ returns), with tangents, and
+// indexes it with the hash welder and with the three previous versions :
+// - indexVBO_map      : std::map of exact vertices
+// - indexVBO_slow     : linear search
+// - indexVBO_TBN_slow : linear search, with tangent averaging
+// The grid is 255 x 255 quads so that 16-bit indices are enough for everyone, repeated until
+// there are about a million triangles. The linear searches only get the first slowTriangles
+// triangles : on the whole mesh they would take hours. Last, a grid of half a million different
+// vertices goes through the 32-bit hash welder.
+//
+//   ./bench_vboindexer [triangles] [slowTriangles]
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/vboindexer.hpp>
+#include <common/benchtimer.hpp>
+
+struct Soup {
+	std::vector<glm::vec3> vertices;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec3> tangents;
+	std::vector<glm::vec3> bitangents;
+};
+
+// side x side quads, 2 triangles each, as many times as needed to reach triangles
+static void makeGridSoup(Soup & soup, unsigned int side, unsigned int triangles){
+	while (soup.vertices.size() < triangles * 3) {
+		for (unsigned int z = 0; z < side; z++) {
+			for (unsigned int x = 0; x < side; x++) {
+				const unsigned int corners[6][2] = { {0,0}, {0,1}, {1,1}, {0,0}, {1,1}, {1,0} };
+				for (int c = 0; c < 6; c++) {
+					unsigned int i = x + corners[c][0], j = z + corners[c][1];
+					float u = (float)i, v = (float)j;
+					soup.vertices.push_back(glm::vec3(u, 0.25f * ((i + j) % 3), v));
+					soup.uvs.push_back(glm::vec2(u / side, v / side));
+					soup.normals.push_back(glm::vec3(0, 1, 0));
+					soup.tangents.push_back(glm::vec3(1, 0, 0));
+					soup.bitangents.push_back(glm::vec3(0, 0, 1));
+				}
+				if (soup.vertices.size() >= triangles * 3)
+					return;
+			}
+		}
+	}
+}
+
+static void prefix(const Soup & soup, unsigned int corners, Soup & out){
+	out.vertices  .assign(soup.vertices.begin()  , soup.vertices.begin()   + corners);
+	out.uvs       .assign(soup.uvs.begin()       , soup.uvs.begin()        + corners);
+	out.normals   .assign(soup.normals.begin()   , soup.normals.begin()    + corners);
+	out.tangents  .assign(soup.tangents.begin()  , soup.tangents.begin()   + corners);
+	out.bitangents.assign(soup.bitangents.begin(), soup.bitangents.begin() + corners);
+}
+
+static void report(const char * name, double time, size_t corners, size_t vertices){
+	printf("%-22s %9u corners %8u vertices %10.1f ms %8.1f ns/corner\n",
+		name, (unsigned int)corners, (unsigned int)vertices, time * 1000.0, time * 1e9 / corners);
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int triangles     = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+	unsigned int slowTriangles = argc > 2 ? (unsigned int)atoi(argv[2]) : 20000;
+	if (slowTriangles > triangles)
+		slowTriangles = triangles;
+
+	Soup soup;
+	makeGridSoup(soup, 255, triangles);
+	size_t corners = soup.vertices.size();
+
+	// Exact welding, whole mesh : hash against std::map, which must give the same result
+	std::vector<unsigned short> hashIndices, mapIndices;
+	Soup hashed, mapped;
+	double start = now();
+	if (!indexVBO(soup.vertices, soup.uvs, soup.normals, hashIndices, hashed.vertices, hashed.uvs, hashed.normals))
+		return 1;
+	report("indexVBO (hash)", now() - start, corners, hashed.vertices.size());
+
+	start = now();
+	indexVBO_map(soup.vertices, soup.uvs, soup.normals, mapIndices, mapped.vertices, mapped.uvs, mapped.normals);
+	report("indexVBO_map", now() - start, corners, mapped.vertices.size());
+
+	if (hashIndices != mapIndices || hashed.vertices.size() != mapped.vertices.size()
+		|| memcmp(&hashed.vertices[0], &mapped.vertices[0], hashed.vertices.size() * sizeof(glm::vec3)) != 0) {
+		printf("The hash and std::map versions disagree !\n");
+		return 1;
+	}
+
+	// TBN on the whole mesh, with the usual epsilon
+	std::vector<unsigned short> tbnIndices;
+	Soup tbn;
+	start = now();
+	indexVBO_TBN(soup.vertices, soup.uvs, soup.normals, soup.tangents, soup.bitangents,
+		tbnIndices, tbn.vertices, tbn.uvs, tbn.normals, tbn.tangents, tbn.bitangents);
+	report("indexVBO_TBN (hash)", now() - start, corners, tbn.vertices.size());
+
+	// The linear searches, on a part of the mesh. The hash versions again on the same part.
+	Soup part;
+	prefix(soup, slowTriangles * 3, part);
+	{
+		std::vector<unsigned short> indices;
+		Soup out;
+		start = now();
+		indexVBO_slow(part.vertices, part.uvs, part.normals, indices, out.vertices, out.uvs, out.normals);
+		report("indexVBO_slow", now() - start, part.vertices.size(), out.vertices.size());
+	}
+	{
+		std::vector<unsigned short> indices;
+		Soup out;
+		start = now();
+		indexVBO_TBN_slow(part.vertices, part.uvs, part.normals, part.tangents, part.bitangents,
+			indices, out.vertices, out.uvs, out.normals, out.tangents, out.bitangents);
+		report("indexVBO_TBN_slow", now() - start, part.vertices.size(), out.vertices.size());
+	}
+	{
+		std::vector<unsigned short> indices;
+		Soup out;
+		start = now();
+		indexVBO_TBN(part.vertices, part.uvs, part.normals, part.tangents, part.bitangents,
+			indices, out.vertices, out.uvs, out.normals, out.tangents, out.bitangents);
+		report("indexVBO_TBN (hash)", now() - start, part.vertices.size(), out.vertices.size());
+	}
+
+	// Too many vertices for 16 bits : 16-bit must refuse, 32-bit must work
+	Soup big;
+	makeGridSoup(big, 707, triangles);
+	{
+		std::vector<unsigned short> indices;
+		Soup out;
+		if (indexVBO(big.vertices, big.uvs, big.normals, indices, out.vertices, out.uvs, out.normals)) {
+			printf("16-bit indexing of %u vertices should have failed !\n", (unsigned int)out.vertices.size());
+			return 1;
+		}
+	}
+	std::vector<unsigned int> bigIndices;
+	Soup bigOut;
+	start = now();
+	indexVBO(big.vertices, big.uvs, big.normals, bigIndices, bigOut.vertices, bigOut.uvs, bigOut.normals);
+	report("indexVBO (hash, 32-bit)", now() - start, big.vertices.size(), bigOut.vertices.size());
+	return 0;
+}
@@ -0,0 +1,77 @@
+// Offline compressor : a BMP image to a BC1 (or BC3) DDS file with all its mipmap levels
+// (see common/texturecompressor.hpp). The rows are flipped to the DDS convention of the
+// tutorials, so the file replaces the BMP in loadDDS with the same OBJ.
+//
+//   ./bmp2dds [--bc3] [--threads 8] image.bmp image.dds
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+// Include GLEW, for the GL enums
+#include <GL/glew.h>
+
+#include <common/texture.hpp>
+#include <common/jobsystem.hpp>
+#include <common/texturecompressor.hpp>
+#include <common/benchtimer.hpp>
+
+int main(int argc, char* argv[])
+{
+	BlockFormat format = BLOCK_BC1;
+	unsigned int workers = 0;
+	int arg = 1;
+	for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+		if (strcmp(argv[arg], "--bc3") == 0)
+			format = BLOCK_BC3;
+		else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+			workers = atoi(argv[++arg]);
+	}
+	if (argc - arg < 2) {
+		printf("Usage : %s [--bc3] [--threads 8] image.bmp image.dds\n", argv[0]);
+		return 1;
+	}
+
+	TextureImage image;
+	if (!readBMP(argv[arg], image))
+		return 1;
+	unsigned char * original = getRGBA8(image);
+	if (!original) {
+		freeTextureImage(image);
+		return 1;
+	}
+
+	JobSystem * jobs = createJobSystem(workers);
+	double start = now();
+	TextureImage compressed;
+	bool ok = compressTexture(image, format, compressed, jobs, true);
+	double compressTime = now() - start;
+	destroyJobSystem(jobs);
+	freeTextureImage(image);
+	if (!ok || !writeDDS(argv[arg + 1], compressed)) {
+		free(original);
+		if (ok) freeTextureImage(compressed);
+		return 1;
+	}
+
+	// Quality of level 0 : decoded, then flipped back to the rows of the BMP
+	unsigned int width = compressed.levels[0].width, height = compressed.levels[0].height;
+	std::vector<unsigned char> decoded((size_t)width * height * 4), unflipped(decoded.size());
+	decompressTextureLevel(compressed, 0, &decoded[0]);
+	for (unsigned int y = 0; y < height; y++)
+		memcpy(&unflipped[(size_t)y * width * 4], &decoded[(size_t)(height - 1 - y) * width * 4], (size_t)width * 4);
+	size_t texels = (size_t)width * height;
+	printf("%ux%u, %u levels, %s : %.1f KB, %.1f ms\n", width, height, compressed.levelCount,
+		format == BLOCK_BC1 ? "BC1" : "BC3", compressed.dataSize / 1024.0, compressTime * 1000.0);
+	printf("PSNR : %.2f dB", computePSNR(original, &unflipped[0], texels, false));
+	if (format == BLOCK_BC3)
+		printf(", alpha %.2f dB", computePSNR(original, &unflipped[0], texels, true));
+	printf("\n%s written\n", argv[arg + 1]);
+
+	free(original);
+	freeTextureImage(compressed);
+	return 0;
+}
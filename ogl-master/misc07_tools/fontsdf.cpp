@@ -0,0 +1,94 @@
+// Offline signed distance field font builder : a big 16x16 grid font (a DDS like the fonts of
+// text2D, or a BMP) to a small R8 atlas of distances and the metrics of its glyphs
+// (see common/sdffont.hpp). Give both to initText2DSDF.
+//
+//   ./fontsdf [--cell 32] [--spread 4] font.dds atlas.dds atlas.txt
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+// Include GLEW, for the GL enums
+#include <GL/glew.h>
+
+#include <common/texture.hpp>
+#include <common/texturecompressor.hpp>
+#include <common/sdffont.hpp>
+#include <common/benchtimer.hpp>
+
+int main(int argc, char* argv[])
+{
+	unsigned int cellSize = 32;
+	float spread = 4.0f;
+	int arg = 1;
+	for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+		if (strcmp(argv[arg], "--cell") == 0 && arg + 1 < argc)
+			cellSize = atoi(argv[++arg]);
+		else if (strcmp(argv[arg], "--spread") == 0 && arg + 1 < argc)
+			spread = (float)atof(argv[++arg]);
+	}
+	if (argc - arg < 3 || cellSize == 0 || spread <= 0.0f) {
+		printf("Usage : %s [--cell 32] [--spread 4] font.dds|font.bmp atlas.dds atlas.txt\n", argv[0]);
+		return 1;
+	}
+
+	const char * path = argv[arg];
+	size_t length = strlen(path);
+	bool bmp = length > 4 && (strcmp(path + length - 4, ".bmp") == 0 || strcmp(path + length - 4, ".BMP") == 0);
+	TextureImage image;
+	if (!(bmp ? readBMP(path, image) : readDDS(path, image)))
+		return 1;
+	if (image.target != GL_TEXTURE_2D) {
+		printf("%s is not a 2D texture\n", path);
+		freeTextureImage(image);
+		return 1;
+	}
+
+	// Level 0 as RGBA8, top row first
+	unsigned int width = image.levels[0].width, height = image.levels[0].height;
+	unsigned char * rgba;
+	if (image.compressed) {
+		rgba = (unsigned char*)malloc((size_t)width * height * 4);
+		if (rgba && !decompressTextureLevel(image, 0, rgba)) {
+			free(rgba);
+			rgba = NULL;
+		}
+	} else {
+		rgba = getRGBA8(image);
+	}
+	freeTextureImage(image);
+	if (!rgba) {
+		printf("%s : unsupported format\n", path);
+		return 1;
+	}
+	if (bmp) {
+		// BMP rows are bottom up
+		std::vector<unsigned char> row((size_t)width * 4);
+		for (unsigned int y = 0; y < height / 2; y++) {
+			unsigned char * top = rgba + (size_t)y * width * 4;
+			unsigned char * bottom = rgba + (size_t)(height - 1 - y) * width * 4;
+			memcpy(&row[0], top, row.size());
+			memcpy(top, bottom, row.size());
+			memcpy(bottom, &row[0], row.size());
+		}
+	}
+
+	double start = now();
+	TextureImage atlas;
+	SDFFont font;
+	bool ok = buildSDFFont(rgba, width, height, cellSize, spread, atlas, font);
+	double buildTime = now() - start;
+	free(rgba);
+	if (!ok)
+		return 1;
+	ok = writeDDS(argv[arg + 1], atlas) && writeSDFFont(argv[arg + 2], font);
+	if (ok)
+		printf("%ux%u font, %u texels per cell -> %ux%u atlas (%.1f KB), %.1f ms\n%s and %s written\n",
+			width, height, width / 16, atlas.levels[0].width, atlas.levels[0].height,
+			atlas.dataSize / 1024.0, buildTime * 1000.0, argv[arg + 1], argv[arg + 2]);
+	freeTextureImage(atlas);
+	return ok ? 0 : 1;
+}
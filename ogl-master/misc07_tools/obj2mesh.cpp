@@ -0,0 +1,65 @@
+// Offline converter : OBJ to the binary mesh cache format of common/meshcache.hpp.
+// Parses, indexes and optimizes the OBJ once (see meshoptimizer.hpp), writes the .mesh, then
+// times both ways of loading it back.
+//
+//   ./obj2mesh model.obj model.mesh
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <chrono>
+
+// Include GLEW, for the GL enums
+#include <GL/glew.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/meshoptimizer.hpp>
+#include <common/mappedfile.hpp>
+#include <common/meshcache.hpp>
+#include <common/benchtimer.hpp>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		printf("Usage : %s model.obj model.mesh\n", argv[0]);
+		return 1;
+	}
+
+	double start = now();
+	IndexedMesh mesh;
+	if (!loadIndexedMesh(argv[1], mesh))
+		return 1;
+	double objTime = now() - start;
+
+	start = now();
+	VertexCacheStats before = analyzeVertexCache(mesh.indices, mesh.positions.size());
+	optimizeIndexedMesh(mesh);
+	VertexCacheStats after = analyzeVertexCache(mesh.indices, mesh.positions.size());
+	double optimizeTime = now() - start;
+
+	if (!writeIndexedMesh(argv[2], argv[1], mesh))
+		return 1;
+
+	// Loading it back : map, check the header, and read every byte once, as glBufferData would
+	start = now();
+	MeshCache cache;
+	if (!openMeshCache(argv[2], cache, argv[1]))
+		return 1;
+	unsigned int checksum = 0;
+	for (size_t i = 0; i < cache.file.size; i += 64)
+		checksum += cache.file.data[i];
+	size_t fileSize = cache.file.size;
+	unsigned int vertexCount = cache.header->vertexCount, indexCount = cache.header->indexCount;
+	closeMeshCache(cache);
+	double cacheTime = now() - start;
+
+	printf("%s : %u vertices, %u indices, %.1f KB (checksum %u)\n", argv[2], vertexCount, indexCount, fileSize / 1024.0, checksum);
+	printf("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr);
+	printf("loadOBJ + indexVBO %10.3f ms\n", objTime * 1000.0);
+	printf("optimize           %10.3f ms\n", optimizeTime * 1000.0);
+	printf("openMeshCache      %10.3f ms\n", cacheTime * 1000.0);
+	return 0;
+}
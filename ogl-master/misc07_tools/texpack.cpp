@@ -0,0 +1,129 @@
+// Offline packer : many textures into one GL_TEXTURE_2D_ARRAY (see common/texturepacker.hpp),
+// written as a DDS file with the DX10 header, and the place of each texture in a text file.
+// At runtime : loadDDSArray("atlas.dds") for the array, readAtlasRects("atlas.txt", ...) for the UVs.
+//
+//   ./texpack [--page 1024] [--levels 5] atlas.dds atlas.txt a.bmp b.bmp c.dds ...
+//       BMP or RGBA8 DDS images, packed in pages of page x page texels, with their gutters
+//   ./texpack --array atlas.dds atlas.txt a.dds b.dds c.dds ...
+//       DDS images of the same size and format (compressed or not), one per layer
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <chrono>
+
+// Include GLEW, for the GL enums
+#include <GL/glew.h>
+
+// Include GLM
+#include <glm/glm.hpp>
+
+#include <common/texture.hpp>
+#include <common/texturepacker.hpp>
+#include <common/benchtimer.hpp>
+
+static bool readImage(const char * path, TextureImage & image){
+	size_t length = strlen(path);
+	bool dds = length > 4 && (strcmp(path + length - 4, ".dds") == 0 || strcmp(path + length - 4, ".DDS") == 0);
+	return dds ? readDDS(path, image) : readBMP(path, image);
+}
+
+static std::string baseName(const char * path){
+	const char * slash = strrchr(path, '/');
+	const char * backslash = strrchr(path, '\\');
+	if (backslash > slash) slash = backslash;
+	return slash ? slash + 1 : path;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int pageSize = 1024;
+	unsigned int levelCount = 5;
+	bool array = false;
+	int arg = 1;
+	for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+		if (strcmp(argv[arg], "--array") == 0)
+			array = true;
+		else if (strcmp(argv[arg], "--page") == 0 && arg + 1 < argc)
+			pageSize = atoi(argv[++arg]);
+		else if (strcmp(argv[arg], "--levels") == 0 && arg + 1 < argc)
+			levelCount = atoi(argv[++arg]);
+	}
+	if (argc - arg < 3) {
+		printf("Usage : %s [--page 1024] [--levels 5] [--array] atlas.dds atlas.txt image.bmp|image.dds ...\n", argv[0]);
+		return 1;
+	}
+	const char * ddsPath = argv[arg];
+	const char * rectsPath = argv[arg + 1];
+
+	double start = now();
+	std::vector<std::string> names;
+	std::vector<TextureImage> images;
+	std::vector<AtlasSource> sources;
+	for (int i = arg + 2; i < argc; i++) {
+		TextureImage image;
+		if (!readImage(argv[i], image))
+			return 1;
+		names.push_back(baseName(argv[i]));
+		if (array) {
+			images.push_back(image);
+		} else {
+			AtlasSource source;
+			bool ok = getAtlasSource(image, source);
+			freeTextureImage(image);
+			if (!ok)
+				return 1;
+			sources.push_back(source);
+		}
+	}
+	double readTime = now() - start;
+
+	start = now();
+	TextureImage atlas;
+	std::vector<AtlasRect> rects;
+	bool packed = array
+		? packTextureArray(images, atlas, rects)
+		: packTextureAtlas(sources, pageSize, levelCount, atlas, rects);
+	for (size_t i = 0; i < images.size(); i++)
+		freeTextureImage(images[i]);
+	if (!packed)
+		return 1;
+	double packTime = now() - start;
+
+	if (!writeDDS(ddsPath, atlas) || !writeAtlasRects(rectsPath, names, rects)) {
+		freeTextureImage(atlas);
+		return 1;
+	}
+
+	// Read back the way the program will : still an array, even of one layer, and the same names
+	TextureImage written;
+	std::vector<std::string> writtenNames;
+	std::vector<AtlasRect> writtenRects;
+	bool same = readDDS(ddsPath, written, true);
+	if (same) {
+		same = written.target == GL_TEXTURE_2D_ARRAY && written.layers == atlas.layers;
+		freeTextureImage(written);
+	}
+	same = same && readAtlasRects(rectsPath, writtenNames, writtenRects) && writtenNames == names;
+	if (!same) {
+		printf("%s and %s don't read back as they were written\n", ddsPath, rectsPath);
+		freeTextureImage(atlas);
+		return 1;
+	}
+
+	// How much of the pages the images use, gutters and empty space excluded
+	double used = 0.0;
+	for (size_t i = 0; i < rects.size(); i++)
+		used += (double)rects[i].width * rects[i].height;
+	double total = (double)atlas.levels[0].width * atlas.levels[0].height * atlas.layers;
+	printf("%u images in %u layers of %ux%u, %u levels : %.1f%% used, %.1f MB\n",
+		(unsigned int)rects.size(), atlas.layers, atlas.levels[0].width, atlas.levels[0].height, atlas.levelCount,
+		100.0 * used / total, atlas.dataSize / 1048576.0);
+	printf("Read %.1f ms, packed %.1f ms\n", readTime * 1000.0, packTime * 1000.0);
+	printf("%s and %s written\n", ddsPath, rectsPath);
+	freeTextureImage(atlas);
+	return 0;
+}
@@ -1,6 +1,10 @@
 // Include standard headers
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <map>
+#include <algorithm>
 
 // Include GLEW
 #include <GL/glew.h>
@@ -17,17 +21,53 @@ GLFWwindow* window;
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtx/norm.hpp>
 #include <common/shader.hpp>
+#include <common/shaderregistry.hpp>
 #include <common/texture.hpp>
 #include <common/controls.hpp>
+#include <common/input.hpp>
+#include <common/inputrecord.hpp>
+#include <common/vertexformat.hpp>
+#include <common/meshregistry.hpp>
+#include <common/shapes.hpp>
+#include <common/frustum.hpp>
+#include <common/terrain.hpp>
+#include <common/rocketfleet.hpp>
 using namespace glm;
 
 
-GLfloat* makeCircleVertexData(GLfloat x, GLfloat y, GLfloat z, GLfloat radius, GLint numberOfSides);
-GLfloat* makeConeVertexData(GLfloat x, GLfloat y, GLfloat z, GLfloat height, GLfloat radius, GLint numberOfSides);
-
-
-int main(void)
+int main(int argc, char* argv[])
 {
+	// Number of rockets launched together, and of simulation threads : tutorial04 --rockets 1000 --workers 4
+	// The terrain is generated, unless a height image is given : --heightmap heightmap.bmp
+	// The rocket parts are stored with floats, unless asked otherwise : --quantize 1
+	// The input can be saved, --record session.input, and played back as fast as possible in a
+	// hidden window, writing the time of every frame : --replay session.input --timings frames.csv
+	int rocketCount = 1;
+	int workerCount = 0; // All the cores
+	const char* heightmapPath = NULL;
+	bool quantize = false;
+	const char* recordPath = NULL;
+	const char* replayPath = NULL;
+	const char* timingsPath = NULL;
+	for (int i = 1; i < argc - 1; i++) {
+		if (strcmp(argv[i], "--rockets") == 0)
+			rocketCount = atoi(argv[i + 1]);
+		if (strcmp(argv[i], "--workers") == 0)
+			workerCount = atoi(argv[i + 1]);
+		if (strcmp(argv[i], "--heightmap") == 0)
+			heightmapPath = argv[i + 1];
+		if (strcmp(argv[i], "--quantize") == 0)
+			quantize = atoi(argv[i + 1]) != 0;
+		if (strcmp(argv[i], "--record") == 0)
+			recordPath = argv[i + 1];
+		if (strcmp(argv[i], "--replay") == 0)
+			replayPath = argv[i + 1];
+		if (strcmp(argv[i], "--timings") == 0)
+			timingsPath = argv[i + 1];
+	}
+	if (rocketCount < 1)
+		rocketCount = 1;
+
 	// Initialise GLFW
 	if (!glfwInit())
 	{
@@ -41,6 +81,8 @@ int main(void)
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // To make MacOS happy; should not be needed
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (replayPath)
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE); // Headless : nothing is ever shown
 
 	// Open a window and create its OpenGL context
 	window = glfwCreateWindow(1024, 768, "Computer Graphics Project", NULL, NULL);
@@ -51,6 +93,13 @@ int main(void)
 		return -1;
 	}
 	glfwMakeContextCurrent(window);
+	if (replayPath)
+		glfwSwapInterval(0); // No vsync : we measure the frame, not the display
+
+	if (replayPath ? !startInputReplay(replayPath) : recordPath && !startInputRecording(recordPath)) {
+		glfwTerminate();
+		return -1;
+	}
 
 	// Initialize GLEW
 	glewExperimental = true; // Needed for core profile
@@ -63,12 +112,7 @@ int main(void)
 
 	// Ensure we can capture the escape key being pressed below
 	glfwSetInputMode(window, GLFW_STICKY_KEYS, GL_TRUE);
-	// Hide the mouse and enable unlimited mouvement
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-	// Set the mouse at the center of the screen
-	glfwPollEvents();
-	glfwSetCursorPos(window, 1024 / 2, 768 / 2);
+	// The mouse is hidden, for unlimited movement, by initInput (input.hpp)
 
 	// Dark blue background
 	glClearColor(0.4f, 0.6f, 1.0f, 0.0f);
@@ -78,57 +122,25 @@ int main(void)
 	// Accept fragment if it closer to the camera than the former one
 	glDepthFunc(GL_LESS);
 
-	// Cull triangles which normal is not towards the camera
-	glEnable(GL_CULL_FACE);
+	// The rocket parts are not consistently wound, so face culling stays off
+	glDisable(GL_CULL_FACE);
 
-	GLuint VertexArrayID;
-	glGenVertexArrays(1, &VertexArrayID);
-	glBindVertexArray(VertexArrayID);
+	// Create and compile our GLSL programs from the shaders. They reload when the files are
+	// saved : edit the shaders while the tutorial runs.
+	ShaderRegistry* shaders = createShaderRegistry(window);
+	unsigned int transformProgram = registerShaderProgram(shaders, "TransformVertexShader.vertexshader", "ColorFragmentShader.fragmentshader");
 
-	// Create and compile our GLSL program from the shaders
-	GLuint programID = LoadShaders("TransformVertexShader.vertexshader", "ColorFragmentShader.fragmentshader");
+	// The rockets are instanced : the model matrix comes from an instance buffer
+	unsigned int instancedProgram = registerShaderProgram(shaders, "InstancedTransform.vertexshader", "ColorFragmentShader.fragmentshader");
 
-	// Get a handle for our "MVP" uniform
-	GLuint MatrixID = glGetUniformLocation(programID, "MVP");
+	// Get a handle for our uniforms, again each time the programs are reloaded
+	GLuint programID, MatrixID, instancedProgramID, ViewProjectionID, DequantizeID;
+	bool programsChanged = true;
 
 
 	// Our vertices. Tree consecutive floats give a 3D vertex; Three consecutive vertices give a triangle.
 	// A cube has 6 faces with 2 triangles each, so this makes 6*2=12 triangles, and 12*3 vertices
 
-	static const GLfloat ground_vertex_buffer_data[] = {
-		-10000.0f,0.0f,10000.0f,
-		10000.0f,0.0f,10000.0f,
-		-10000.0f,0.0f,-10000.0f,
-		10000.0f,0.0f,10000.0f,
-		-10000.0f,0.0f,-10000.0f,
-		10000.0f,0.0f,-10000.0f,
-		/*
-		10000.0f,0.0f,0.0f,
-	  -10000.0f,0.0f,0.0f,
-	  -10000.0f,-10000.0f,0.0f,
-	  10000.0f,0.0f,0.0f,
-	  -10000.0f,-10000.0f,0.0f,
-	  10000.0f,-10000.0f,0.0f
-	  */
-	};
-
-	static const GLfloat ground_color_buffer_data[] = {
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		/*
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f,
-		0.18f, 0.62f, 0.15f
-		*/
-	};
-
 	static const GLfloat g_vertex_buffer_data[] = {
 		-1.0f,0.0f,1.0f,
 	  -1.0f,0.0f, 3.0f,
@@ -180,137 +192,15 @@ int main(void)
 
 	};
 
-	// One color for each vertex. They were generated randomly.
-	static const GLfloat g_color_buffer_data[] = {
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-	};
+	// The round parts are generated, each distinct one only once
+	ShapeCache shapes;
+	initShapeCache(shapes);
 
 	// window
-	GLfloat* window_vertex_buffer_data = makeCircleVertexData(0.0, 2, 3.01, 0.4, 36);
-	static const GLfloat window_color_buffer_data[]{
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f
-	}; 
+	const ShapeMesh & window_shape = getShape(shapes, discShape(vec3(0.0f, 2.0f, 3.01f), 0.4f, 36));
 
 	// window2
-	GLfloat* window2_vertex_buffer_data = makeCircleVertexData(0, 2, 0.99, 0.4, 36);
-	static const GLfloat window2_color_buffer_data[]{
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f,
-		0.70f, 0.92f, 0.96f
-	};
+	const ShapeMesh & window2_shape = getShape(shapes, discShape(vec3(0.0f, 2.0f, 0.99f), 0.4f, 36));
 
 	// wing
 	static const GLfloat wing_vertex_buffer_data[]{
@@ -324,165 +214,8 @@ int main(void)
 
 	};
 
-	static const GLfloat wing_color_buffer_data[]{
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f
-
-	};
-
 	// head
-	static const GLfloat* head_vertex_buffer_data = makeConeVertexData(0, 3, 2, 2, 0.9, 36);
-	static const GLfloat head_color_buffer_data[] = {
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-	};
+	const ShapeMesh & head_shape = getShape(shapes, coneShape(vec3(0.0f, 3.0f, 2.0f), 0.9f, 2.0f, 36));
 
 	static const GLfloat chute_vertex_buffer_data[] = {
 		0.0f, 8.0f, -1.0f,
@@ -584,157 +317,89 @@ int main(void)
 		1.0f, 0.37f, 0.0f,
 	};
 
-	static const GLfloat* line_vertex_buffer_data = makeConeVertexData(0, 6, -1, -5.5, 3, 12);
-	static const GLfloat line_color_buffer_data[] = {
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-		0.74f, 0.74f, 0.74f,
-	};
+	// The chute lines : a cone hanging from the chute down to the rocket
+	const ShapeMesh & line_shape = getShape(shapes, coneShape(vec3(0.0f, 6.0f, -1.0f), 3.0f, -5.5f, 12));
+
+	// Pack every part in one interleaved, indexed vertex/index buffer pair
+	MeshRegistry meshes;
+	initMeshRegistry(meshes);
+
+	unsigned int bodyMesh     = addMesh(meshes, GL_TRIANGLES, g_vertex_buffer_data, NULL, 12 * 3, glm::vec3(1.0f, 1.0f, 1.0f));
+	unsigned int windowMesh   = addMesh(meshes, window_shape.mode, (const GLfloat*)window_shape.vertices, NULL, window_shape.vertexCount, glm::vec3(0.70f, 0.92f, 0.96f), window_shape.indices, window_shape.indexCount);
+	unsigned int window2Mesh  = addMesh(meshes, window2_shape.mode, (const GLfloat*)window2_shape.vertices, NULL, window2_shape.vertexCount, glm::vec3(0.70f, 0.92f, 0.96f), window2_shape.indices, window2_shape.indexCount);
+	unsigned int wingMesh     = addMesh(meshes, GL_TRIANGLES, wing_vertex_buffer_data, NULL, 2 * 3, glm::vec3(1.0f, 0.0f, 0.0f));
+	unsigned int headMesh     = addMesh(meshes, head_shape.mode, (const GLfloat*)head_shape.vertices, NULL, head_shape.vertexCount, glm::vec3(1.0f, 0.0f, 0.0f), head_shape.indices, head_shape.indexCount);
+	unsigned int chuteMesh    = addMesh(meshes, GL_TRIANGLES, chute_vertex_buffer_data, chute_color_buffer_data, 12 * 3);
+
+	// Vertex 0 of a cone is the apex, then comes the rim : one line from each rim vertex to the apex
+	unsigned int line_indices[12 * 2];
+	for (int i = 0; i < 12; i++) {
+		line_indices[i * 2 + 0] = 1 + i;
+		line_indices[i * 2 + 1] = 0;
+	}
+	unsigned int lineMesh = addMesh(meshes, GL_LINES, (const GLfloat*)line_shape.vertices, NULL, line_shape.vertexCount, glm::vec3(0.74f, 0.74f, 0.74f), line_indices, 12 * 2);
 
-	static const GLfloat mountine_vertex_buffer_data[] = {
-		10.0f, 0.0f, 0.0f,
-		20.0f, 0.0f, 0.0f, 
-		15.0f, 7.0f, 0.0f, 
+	uploadMeshRegistry(meshes, quantize);
 
-		17.0f, 0.0f, 0.0f, 
-		23.0f, 0.0f, 0.0f, 
-		20.0f, 4.0f, 0.0f
-	};
-	static const GLfloat mountine_color_buffer_data[] = {
-		0.11f, 0.55f, 0.08f,
-		0.11f, 0.55f, 0.08f,
-		0.11f, 0.55f, 0.08f,
-
-		0.11f, 0.55f, 0.08f,
-		0.11f, 0.55f, 0.08f,
-		0.11f, 0.55f, 0.08f
-	};
+	// The registry keeps its own copy
+	cleanupShapeCache(shapes);
+
+	// The fleet : rocket 0 is on the launch pad, the others on a grid behind it
+	int fleetSide = (int)ceil(sqrt((float)rocketCount));
+
+	// The ground : 4 km of hills, flat around the launch pad and the fleet
+	Terrain terrain;
+	float padRadius = glm::max(40.0f, fleetSide * 6.0f * 1.5f);
+	if (heightmapPath == NULL || !loadHeightfieldBMP(terrain.heightfield, heightmapPath, 6, 2.0f, 120.0f))
+		generateHeightfield(terrain.heightfield, 6, 2.0f, 60.0f, 1234, padRadius);
+	initTerrain(terrain);
+
+	// Far enough to see the hills
+	setClipPlanes(0.5f, 3000.0f);
+
+	std::vector<glm::vec3> launchSites(rocketCount);
+	for (int i = 0; i < rocketCount; i++) {
+		launchSites[i] = glm::vec3((i % fleetSide) * 6.0f, 0.0f, -(i / fleetSide) * 6.0f);
+		launchSites[i].y = getTerrainHeight(terrain.heightfield, launchSites[i].x, launchSites[i].z);
+	}
+
+	// Bounding spheres around the model origin, so that they hold whatever the rotation
+	float rocketRadius = 0.0f, chuteRadius = 0.0f;
+	unsigned int rocketParts[] = { bodyMesh, windowMesh, window2Mesh, wingMesh, headMesh };
+	unsigned int chuteParts[] = { chuteMesh, lineMesh };
+	for (int i = 0; i < 5 + 2; i++) {
+		const MeshRange & range = meshes.meshes[i < 5 ? rocketParts[i] : chuteParts[i - 5]];
+		float radius = glm::length(glm::max(glm::abs(range.boxMin), glm::abs(range.boxMax)));
+		if (i < 5)
+			rocketRadius = glm::max(rocketRadius, radius);
+		else
+			chuteRadius = glm::max(chuteRadius, radius);
+	}
 
-	GLuint groundVertexbuffer;
-	glGenBuffers(1, &groundVertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, groundVertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(ground_vertex_buffer_data), ground_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint groundColorbuffer;
-	glGenBuffers(1, &groundColorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, groundColorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 6 * 3, ground_color_buffer_data, GL_STATIC_DRAW);
-
-	GLuint vertexbuffer;
-	glGenBuffers(1, &vertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data), g_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint colorbuffer;
-	glGenBuffers(1, &colorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_color_buffer_data), g_color_buffer_data, GL_STATIC_DRAW);
-
-	GLuint windowVertexbuffer;
-	glGenBuffers(1, &windowVertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, windowVertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, 37 * 3 * sizeof(GLfloat), window_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint windowColorbuffer;
-	glGenBuffers(1, &windowColorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, windowColorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(window_color_buffer_data), window_color_buffer_data, GL_STATIC_DRAW);
-
-	GLuint window2Vertexbuffer;
-	glGenBuffers(1, &window2Vertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, window2Vertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, 37 * 3 * sizeof(GLfloat), window2_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint window2Colorbuffer;
-	glGenBuffers(1, &window2Colorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, window2Colorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(window2_color_buffer_data), window2_color_buffer_data, GL_STATIC_DRAW);
-
-
-	GLuint wingVertexbuffer;
-	glGenBuffers(1, &wingVertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, wingVertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wing_vertex_buffer_data), wing_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint wingColorbuffer;
-	glGenBuffers(1, &wingColorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, wingColorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wing_color_buffer_data), wing_color_buffer_data, GL_STATIC_DRAW);
-
-	GLuint headVertexbuffer;
-	glGenBuffers(1, &headVertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, headVertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 36 * 9, head_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint headColorbuffer;
-	glGenBuffers(1, &headColorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, headColorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 36 * 9, head_color_buffer_data, GL_STATIC_DRAW);
-
-	GLuint chuteVertexbuffer;
-	glGenBuffers(1, &chuteVertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, chuteVertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(chute_vertex_buffer_data), chute_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint chuteColorbuffer;
-	glGenBuffers(1, &chuteColorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, chuteColorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(chute_color_buffer_data), chute_color_buffer_data, GL_STATIC_DRAW);
-
-	GLuint lineVertexbuffer;
-	glGenBuffers(1, &lineVertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, lineVertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 12 * 9, line_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint lineColorbuffer;
-	glGenBuffers(1, &lineColorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, lineColorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 12 * 9, line_color_buffer_data, GL_STATIC_DRAW);
-
-	GLuint mountineVertexbuffer;
-	glGenBuffers(1, &mountineVertexbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, mountineVertexbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(mountine_vertex_buffer_data), mountine_vertex_buffer_data, GL_STATIC_DRAW);
-
-	GLuint mountineColorbuffer;
-	glGenBuffers(1, &mountineColorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, mountineColorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(mountine_color_buffer_data), mountine_color_buffer_data, GL_STATIC_DRAW);
+	// Every rocket and open chute, then only the ones in view : they go to the instance buffer,
+	// the visible rocket matrices followed by the visible chute matrices
+	std::vector<glm::mat4> rocketModels(rocketCount);
+	std::vector<glm::mat4> chuteModels(rocketCount);
+	std::vector<glm::mat4> instanceModels(rocketCount * 2);
+	InstanceBuffer instances;
+	initInstanceBuffer(instances, rocketCount * 2);
+
+	Frustum frustum;
+	BoundingBoxes modelBoxes;
+	std::vector<unsigned char> modelVisible(rocketCount * 2);
+	CullStats rocketStats;
+	double lastTitleTime = 0.0;
+
+	// Rocket 0 is flown with the keyboard; the rest of the fleet flies on its own,
+	// in the same fixed ticks but on other threads, and launches with it
+	RocketFleet* fleet = createRocketFleet(rocketCount - 1, workerCount < 0 ? 0 : workerCount);
+	bool wasLaunched = false;
+	// The rockets only have two attitudes : going up, and turned once falling
+	glm::mat4 FallingRotationMatrix = eulerAngleYXZ(0.0f, 10.0f, 0.0f);
+
+	// Replay : the time of each frame, and the tick it ended at
+	std::vector<float> frameTimes;
+	std::vector<unsigned long long> frameTicks;
 
 	double lastTime = glfwGetTime();
 	do {
@@ -745,11 +410,30 @@ int main(void)
 		// Clear the screen
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		// The shaders edited since the last frame, if they are compiled already
+		if (updateShaderRegistry(shaders) > 0 || programsChanged) {
+			programID = getShaderProgram(shaders, transformProgram);
+			MatrixID = glGetUniformLocation(programID, "MVP");
+			instancedProgramID = getShaderProgram(shaders, instancedProgram);
+			ViewProjectionID = glGetUniformLocation(instancedProgramID, "VP");
+			DequantizeID = glGetUniformLocation(instancedProgramID, "Dequantize");
+			programsChanged = false;
+		}
+
 		// Use our shader
 		glUseProgram(programID);
 
 		// Compute the MVP matrix from keyboard and mouse input
 		computeMatricesFromInputs();
+
+		if (getLaunch() && !wasLaunched)
+			requestFleetLaunch(fleet, getGauge(), getSimulationTick());
+		wasLaunched = getLaunch();
+		advanceRocketFleet(fleet, getSimulationTick());
+		// A replay draws the fleet at the tick it was recorded at, not whenever the threads get there
+		if (isReplayingInput())
+			waitForRocketFleet(fleet);
+
 		glm::mat4 ProjectionMatrix = getProjectionMatrix();
 		glm::mat4 ViewMatrix = getViewMatrix();
 		glm::mat4 ModelMatrix = glm::mat4(1.0);
@@ -758,386 +442,134 @@ int main(void)
 		glm::mat4 TranslationMatrix = translate(mat4(), glm::vec3(0, getHeight(), 0));
 
 		glm::mat4 MVP = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		glm::mat4 MVPRocket = ProjectionMatrix * ViewMatrix * ModelMatrix * TranslationMatrix * RotationMatrix;
-		glm::mat4 MVPChute = ProjectionMatrix * ViewMatrix * ModelMatrix * TranslationMatrix;
+		glm::mat4 VP = ProjectionMatrix * ViewMatrix;
 
-		//ground
+		// The player's rocket, then the fleet
+		int chuteCount = 0;
+		rocketModels[0] = TranslationMatrix * RotationMatrix;
+		if (getChute() == true) {
+			chuteModels[chuteCount] = TranslationMatrix;
+			chuteCount++;
+		}
+		// Whatever the simulation threads have finished last (the current tick, when replaying)
+		const RocketSnapshot* snapshot = acquireRocketSnapshot(fleet);
+		for (int i = 0; i < rocketCount - 1; i++) {
+			glm::mat4 FleetTranslationMatrix = translate(mat4(), launchSites[i + 1] + glm::vec3(0, snapshot->height[i], 0));
+			rocketModels[i + 1] = FleetTranslationMatrix * (snapshot->rotation[i] != 0.0f ? FallingRotationMatrix : mat4());
+			if (snapshot->chute[i]) {
+				chuteModels[chuteCount] = FleetTranslationMatrix;
+				chuteCount++;
+			}
+		}
+		releaseRocketSnapshot(fleet);
+
+		// Frustum culling : the spheres are centered on the translation of each matrix
+		extractFrustum(frustum, VP);
+		clearBoundingBoxes(modelBoxes);
+		for (int i = 0; i < rocketCount; i++)
+			addBoundingSphere(modelBoxes, glm::vec3(rocketModels[i][3]), rocketRadius);
+		for (int i = 0; i < chuteCount; i++)
+			addBoundingSphere(modelBoxes, glm::vec3(chuteModels[i][3]), chuteRadius);
+		rocketStats.visible = cullBoundingBoxes(frustum, modelBoxes, &modelVisible[0]);
+		rocketStats.culled = rocketCount + chuteCount - rocketStats.visible;
+
+		int visibleRockets = 0, visibleChutes = 0;
+		for (int i = 0; i < rocketCount; i++)
+			if (modelVisible[i])
+				instanceModels[visibleRockets++] = rocketModels[i];
+		for (int i = 0; i < chuteCount; i++)
+			if (modelVisible[rocketCount + i])
+				instanceModels[visibleRockets + visibleChutes++] = chuteModels[i];
+		streamInstances(instances, &instanceModels[0], visibleRockets + visibleChutes);
+
+		// ground : only the chunks near the camera at full resolution, and only those in view
 		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
+		selectTerrainChunks(terrain, getCameraPosition());
+		drawTerrain(terrain, &frustum);
+
+		// All the parts share the same buffers and attribute layout : bind them once
+		bindMeshRegistry(meshes);
+
+		// rockets : one draw call per part for the whole fleet
+		glUseProgram(instancedProgramID);
+		glUniformMatrix4fv(ViewProjectionID, 1, GL_FALSE, &VP[0][0]);
+
+		// Each part has its own quantization box
+		if (visibleRockets > 0) {
+			bindInstanceBuffer(instances, 0);
+			for (int i = 0; i < 5; i++) {
+				glUniformMatrix4fv(DequantizeID, 1, GL_FALSE, &meshes.meshes[rocketParts[i]].dequantize[0][0]);
+				drawMeshInstanced(meshes, rocketParts[i], visibleRockets);
+			}
+		}
 
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, groundVertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, groundColorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		// Draw the triangle !
-		glDrawArrays(GL_TRIANGLES, 0, 2 * 3); // 2*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		// mountine
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, mountineVertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, mountineColorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		// Draw the triangle !
-		glDrawArrays(GL_TRIANGLES, 0, 1 * 3 * 2); // 2*3 indices starting at 0 -> 12 triangles
-		glDisable(GL_CULL_FACE);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		// rocket
-		// Send our transformation to the currently bound shader, 
-		// in the "MVP" uniform
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPRocket[0][0]);
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		// Draw the triangle !
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		// window
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, windowVertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, windowColorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		// Draw the triangle !
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 37 * 3); // 2*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		// window2
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, window2Vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, window2Colorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		// Draw the triangle !
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 37 * 3); // 2*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		// wing
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, wingVertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, wingColorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		// Draw the triangle !
-		glDrawArrays(GL_TRIANGLES, 0, 1 * 3 * 2); // 2*3 indices starting at 0 -> 12 triangles
-		glDisable(GL_CULL_FACE);
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		// head
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, headVertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, headColorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 324); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
+		if (visibleChutes > 0) {
+			bindInstanceBuffer(instances, visibleRockets);
+			for (int i = 0; i < 2; i++) {
+				glUniformMatrix4fv(DequantizeID, 1, GL_FALSE, &meshes.meshes[chuteParts[i]].dequantize[0][0]);
+				drawMeshInstanced(meshes, chuteParts[i], visibleChutes);
+			}
+		}
 
-		if (getChute() == true) {
-			glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVPChute[0][0]);
-			// chute
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, chuteVertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, chuteColorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		// Draw the triangle !
-		glDrawArrays(GL_TRIANGLES, 0, 12 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		// line
-
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, lineVertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, lineColorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_LINES, 0, 12 * 9); // 12*3 indices starting at 0 -> 12 triangles
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
+		// What the culling saved, twice a second
+		if (time - lastTitleTime > 0.5) {
+			char title[256];
+			sprintf(title, "Computer Graphics Project - rockets and chutes : %u visible, %u culled - terrain chunks : %u visible, %u culled",
+				rocketStats.visible, rocketStats.culled, terrain.chunkStats.visible, terrain.chunkStats.culled);
+			glfwSetWindowTitle(window, title);
+			lastTitleTime = time;
 		}
 
 		// Swap buffers
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 
+		if (isReplayingInput()) {
+			frameTimes.push_back(float(glfwGetTime() - time));
+			frameTicks.push_back(getSimulationTick());
+		}
 
-
-	} // Check if the ESC key was pressed or the window was closed
+	} // Check if the ESC key was pressed or the window was closed, or the replay is over
 	while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
-		glfwWindowShouldClose(window) == 0);
+		glfwWindowShouldClose(window) == 0 && !isInputReplayOver());
+	stopInputRecord();
 
-	// Cleanup VBO and shader
-	glDeleteBuffers(1, &groundVertexbuffer);
-	glDeleteBuffers(1, &groundColorbuffer);
-
-	glDeleteBuffers(1, &vertexbuffer);
-	glDeleteBuffers(1, &colorbuffer);
-
-	glDeleteBuffers(1, &windowVertexbuffer);
-	glDeleteBuffers(1, &windowColorbuffer);
-
-	glDeleteBuffers(1, &wingVertexbuffer);
-	glDeleteBuffers(1, &wingColorbuffer);
-
-	glDeleteBuffers(1, &headVertexbuffer);
-	glDeleteBuffers(1, &headColorbuffer);
+	// The frame that found the end of the recording replayed nothing
+	if (!frameTimes.empty() && isInputReplayOver()) {
+		frameTimes.pop_back();
+		frameTicks.pop_back();
+	}
+	if (!frameTimes.empty()) {
+		if (timingsPath) {
+			FILE* timings = fopen(timingsPath, "w");
+			if (timings) {
+				fprintf(timings, "frame,tick,ms\n");
+				for (size_t i = 0; i < frameTimes.size(); i++)
+					fprintf(timings, "%u,%llu,%.4f\n", (unsigned int)i, frameTicks[i], frameTimes[i] * 1000.0f);
+				fclose(timings);
+			} else {
+				printf("%s could not be created\n", timingsPath);
+			}
+		}
+		std::vector<float> sorted(frameTimes);
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0.0;
+		for (size_t i = 0; i < sorted.size(); i++)
+			total += sorted[i];
+		printf("Replay : %u frames, %llu ticks, ms per frame : mean %.3f, median %.3f, 95%% %.3f, max %.3f\n",
+			(unsigned int)sorted.size(), frameTicks.back(), total / sorted.size() * 1000.0,
+			sorted[sorted.size() / 2] * 1000.0, sorted[sorted.size() * 95 / 100] * 1000.0, sorted.back() * 1000.0);
+	}
 
-	glDeleteProgram(programID);
-	glDeleteVertexArrays(1, &VertexArrayID);
+	// Cleanup VBO and shader
+	destroyRocketFleet(fleet);
+	cleanupInstanceBuffer(instances);
+	cleanupMeshRegistry(meshes);
+	cleanupTerrain(terrain);
+	destroyShaderRegistry(shaders);
 
 	// Close OpenGL window and terminate GLFW
 	glfwTerminate();
 
 	return 0;
 }
-
-GLfloat* makeCircleVertexData(GLfloat x, GLfloat y, GLfloat z, GLfloat radius, GLint numberOfSides)
-{
-	GLint numberOfVertices = numberOfSides + 1; // vertex 
-
-	GLfloat doublePi = 2.0f * 3.141592f; // 2pi
-
-	// Ҵ x, y, z
-	GLfloat* circleVerticesX = new GLfloat[numberOfVertices]; // Ѱ  side = 36 , numberOfVertices = 37
-	GLfloat* circleVerticesY = new GLfloat[numberOfVertices];
-	GLfloat* circleVerticesZ = new GLfloat[numberOfVertices];
-
-	for (int i = 0; i < numberOfVertices; i++)
-	{
-		circleVerticesX[i] = x + (radius * cos(i * doublePi / numberOfSides));
-		circleVerticesY[i] = y + (radius * sin(i * doublePi / numberOfSides));
-		circleVerticesZ[i] = z;
-	}
-	// 迭 ϳ 
-	GLfloat* allCircleVertices = new GLfloat[numberOfVertices * 3];	// 37 * 3 (x, y, z)
-
-	for (int i = 0; i < numberOfVertices; i++)
-	{
-		allCircleVertices[i * 3] = circleVerticesX[i];
-		allCircleVertices[(i * 3) + 1] = circleVerticesY[i];
-		allCircleVertices[(i * 3) + 2] = circleVerticesZ[i];
-	}
-
-	return allCircleVertices;
-}
-
-GLfloat* makeConeVertexData(GLfloat x, GLfloat y, GLfloat z, GLfloat height, GLfloat radius, GLint numberOfSides) {
-	GLint numberOfVertices = numberOfSides + 1;
-	GLfloat doublePi = 2.0f * 3.141592f;
-	GLfloat* circleVerticesX = new GLfloat[numberOfVertices * 3.0];
-	GLfloat* circleVerticesY = new GLfloat[numberOfVertices * 3.0];
-	GLfloat* circleVerticesZ = new GLfloat[numberOfVertices * 3.0];
-
-	for (int i = 0; i < numberOfVertices; i++) {
-		circleVerticesX[(i * 3) + 0] = x + (radius * cos(i * doublePi / numberOfSides));
-		circleVerticesY[(i * 3) + 0] = y;
-		circleVerticesZ[(i * 3) + 0] = z + (radius * sin(i * doublePi / numberOfSides));
-		circleVerticesX[(i * 3) + 1] = x;
-		circleVerticesY[(i * 3) + 1] = y + height;
-		circleVerticesZ[(i * 3) + 1] = z;
-		circleVerticesX[(i * 3) + 2] = x + (radius * cos((i + 1) * doublePi / numberOfSides));
-		circleVerticesY[(i * 3) + 2] = y;
-		circleVerticesZ[(i * 3) + 2] = z + (radius * sin((i + 1) * doublePi / numberOfSides));
-	}
-	GLfloat* allCylinderVertices = new GLfloat[numberOfVertices * 9.0];
-
-	for (int i = 0; i < numberOfVertices * 3; i++) {
-		allCylinderVertices[(i * 3) + 0] = circleVerticesX[i];
-		allCylinderVertices[(i * 3) + 1] = circleVerticesY[i];
-		allCylinderVertices[(i * 3) + 2] = circleVerticesZ[i];
-	}
-	return allCylinderVertices;
-}